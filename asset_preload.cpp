@@ -0,0 +1,222 @@
+/*******************************************************************************************
+*
+*   Asset Preload - background decoding of image assets
+*
+********************************************************************************************/
+
+#include "asset_preload.h"
+
+#include <string.h>
+
+#if !defined(PLATFORM_WEB)
+	#include <thread>
+	#include <mutex>
+	#include <condition_variable>
+#endif
+#include <atomic>
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef enum PreloadState { PRELOAD_FREE = 0, PRELOAD_PENDING, PRELOAD_DECODING, PRELOAD_DECODED, PRELOAD_UPLOADED, PRELOAD_FAILED } PreloadState;
+
+typedef struct PreloadSlot {
+	char path[256];
+	Image image;                    // Written by the worker, read by the main thread once DECODED
+	Texture2D texture;
+	int generation;                 // Request that last asked for it
+	std::atomic<int> state;
+} PreloadSlot;
+
+//----------------------------------------------------------------------------------
+// Module Variables Definition (local)
+//----------------------------------------------------------------------------------
+static PreloadSlot slots[PRELOAD_MAX_ASSETS];
+static int generation = 0;
+
+#if !defined(PLATFORM_WEB)
+static std::thread worker;
+static std::mutex workerLock;
+static std::condition_variable workerWake;
+static bool workerQuit = false;
+static int pendingCount = 0;    // Slots announced PENDING and not yet claimed, guarded by workerLock
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition (local)
+//----------------------------------------------------------------------------------
+
+// Claim and decode one pending slot, false when there is nothing left to do
+static bool DecodeNext()
+{
+	for (int i = 0; i < PRELOAD_MAX_ASSETS; i++)
+	{
+		int expected = PRELOAD_PENDING;
+		if (!slots[i].state.compare_exchange_strong(expected, PRELOAD_DECODING)) continue;
+
+		slots[i].image = LoadImage(slots[i].path);
+		slots[i].state.store(slots[i].image.data != nullptr ? PRELOAD_DECODED : PRELOAD_FAILED, std::memory_order_release);
+		return true;
+	}
+
+	return false;
+}
+
+#if !defined(PLATFORM_WEB)
+static void WorkerLoop()
+{
+	std::unique_lock<std::mutex> lock(workerLock);
+	for (;;)
+	{
+		//the count is bumped under the lock after the slots are marked, a request can't slip past the wait
+		workerWake.wait(lock, [] { return workerQuit || pendingCount > 0; });
+		if (workerQuit) break;
+
+		lock.unlock();
+		bool worked = DecodeNext();
+		lock.lock();
+
+		if (worked) pendingCount--;
+	}
+}
+#endif
+
+static void ReleaseSlot(PreloadSlot* slot)
+{
+	int state = slot->state.load(std::memory_order_acquire);
+	if (state == PRELOAD_DECODED) UnloadImage(slot->image);
+	if (state == PRELOAD_UPLOADED) UnloadTexture(slot->texture);
+
+	slot->image = { 0 };
+	slot->texture = { 0 };
+	slot->state.store(PRELOAD_FREE, std::memory_order_release);
+}
+
+//----------------------------------------------------------------------------------
+// Asset Preload Functions Definition
+//----------------------------------------------------------------------------------
+void RequestAssetPreload(const char** paths, int count)
+{
+	generation++;
+	int added = 0;
+
+	for (int p = 0; p < count; p++)
+	{
+		PreloadSlot* found = nullptr;
+		PreloadSlot* free = nullptr;
+		for (int i = 0; i < PRELOAD_MAX_ASSETS; i++)
+		{
+			int state = slots[i].state.load(std::memory_order_acquire);
+			if (state != PRELOAD_FREE && strcmp(slots[i].path, paths[p]) == 0) found = &slots[i];
+			if (state == PRELOAD_FREE && free == nullptr) free = &slots[i];
+		}
+
+		//already requested before, keep it
+		if (found != nullptr)
+		{
+			found->generation = generation;
+			continue;
+		}
+		if (free == nullptr)
+		{
+			TraceLog(LOG_WARNING, "PRELOAD: No free slot for [%s]", paths[p]);
+			continue;
+		}
+
+		strncpy(free->path, paths[p], sizeof(free->path) - 1);
+		free->path[sizeof(free->path) - 1] = '\0';
+		free->generation = generation;
+		free->state.store(PRELOAD_PENDING, std::memory_order_release);
+		added++;
+	}
+
+#if !defined(PLATFORM_WEB)
+	std::lock_guard<std::mutex> lock(workerLock);
+	if (!worker.joinable())
+	{
+		workerQuit = false;
+		worker = std::thread(WorkerLoop);
+	}
+	pendingCount += added;
+	workerWake.notify_one();
+#endif
+}
+
+bool UpdateAssetPreload(double budgetSeconds)
+{
+	double start = GetTime();
+	bool done = true;
+
+	for (int i = 0; i < PRELOAD_MAX_ASSETS; i++)
+	{
+		PreloadSlot* slot = &slots[i];
+		if (slot->generation != generation) continue;
+
+		int state = slot->state.load(std::memory_order_acquire);
+
+#if defined(PLATFORM_WEB)
+		//no worker thread, decode inside the frame budget instead
+		if (state == PRELOAD_PENDING && GetTime() - start < budgetSeconds)
+		{
+			DecodeNext();
+			state = slot->state.load(std::memory_order_acquire);
+		}
+#endif
+
+		if (state == PRELOAD_DECODED && GetTime() - start < budgetSeconds)
+		{
+			slot->texture = LoadTextureFromImage(slot->image);
+			UnloadImage(slot->image);
+			slot->image = { 0 };
+			slot->state.store(PRELOAD_UPLOADED, std::memory_order_release);
+			state = PRELOAD_UPLOADED;
+		}
+
+		if (state != PRELOAD_UPLOADED && state != PRELOAD_FAILED) done = false;
+	}
+
+	return done;
+}
+
+float GetAssetPreloadProgress(void)
+{
+	int wanted = 0, ready = 0;
+	for (int i = 0; i < PRELOAD_MAX_ASSETS; i++)
+	{
+		if (slots[i].generation != generation || slots[i].state.load() == PRELOAD_FREE) continue;
+
+		int state = slots[i].state.load(std::memory_order_acquire);
+		wanted++;
+		if (state == PRELOAD_UPLOADED || state == PRELOAD_FAILED) ready++;
+	}
+
+	return wanted > 0 ? (float)ready / wanted : 1.0f;
+}
+
+Texture2D GetPreloadedTexture(const char* path)
+{
+	for (int i = 0; i < PRELOAD_MAX_ASSETS; i++)
+		if (slots[i].state.load(std::memory_order_acquire) == PRELOAD_UPLOADED && strcmp(slots[i].path, path) == 0)
+			return slots[i].texture;
+
+	return { 0 };
+}
+
+void UnloadPreloadedAssets(void)
+{
+#if !defined(PLATFORM_WEB)
+	if (worker.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(workerLock);
+			workerQuit = true;
+		}
+		workerWake.notify_one();
+		worker.join();
+		pendingCount = 0;
+	}
+#endif
+
+	for (int i = 0; i < PRELOAD_MAX_ASSETS; i++)
+		if (slots[i].state.load() != PRELOAD_FREE) ReleaseSlot(&slots[i]);
+}
@@ -0,0 +1,40 @@
+/*******************************************************************************************
+*
+*   Asset Preload - background decoding of image assets
+*
+*   Images are decoded on a worker thread while the game keeps running. The caller runs
+*   UpdateAssetPreload once per frame, which uploads decoded images to the GPU inside a
+*   time budget, and draws a placeholder until GetPreloadedTexture has what it needs, so
+*   loading never stalls a frame. A new request replaces the previous one and keeps any
+*   asset it names again. Without threads (web) decoding also runs inside the per-frame
+*   budget.
+*
+********************************************************************************************/
+
+#ifndef ASSET_PRELOAD_H
+#define ASSET_PRELOAD_H
+
+#include "raylib.h"
+
+#define PRELOAD_MAX_ASSETS              32
+#define PRELOAD_FRAME_BUDGET         0.004      // Seconds of main-thread upload work per frame
+
+#ifdef __cplusplus
+extern "C" {            // Screens are C modules
+#endif
+
+//----------------------------------------------------------------------------------
+// Asset Preload Functions Declaration
+//----------------------------------------------------------------------------------
+void RequestAssetPreload(const char** paths, int count);   // Start decoding, assets already loaded are kept
+bool UpdateAssetPreload(double budgetSeconds);              // Upload what is decoded, true once the request is on the GPU
+float GetAssetPreloadProgress(void);                        // 0..1 of the latest request
+
+Texture2D GetPreloadedTexture(const char* path);            // Empty texture (id 0) if not preloaded
+void UnloadPreloadedAssets(void);                           // Stops the worker and unloads everything
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ASSET_PRELOAD_H
@@ -0,0 +1,79 @@
+/*******************************************************************************************
+*
+*   atlas_pack - pack sprite images into one atlas texture at build time
+*
+*   Usage: atlas_pack <out.png> <out.txt> <name>=<image> [<name>=<image> ...]
+*
+*   Sprites keep the order given, the layout file lists them by name (see sprite_atlas.h).
+*   Run by "make atlas", the game packs at startup instead when the outputs are missing.
+*
+********************************************************************************************/
+
+#include "raylib.h"
+#include "sprite_atlas.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define ATLAS_MAX_WIDTH                 256
+
+//----------------------------------------------------------------------------------
+// Main entry point
+//----------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+	if (argc < 4)
+	{
+		printf("usage: %s <out.png> <out.txt> <name>=<image> ...\n", argv[0]);
+		return 1;
+	}
+
+	SetTraceLogLevel(LOG_WARNING);
+
+	SpriteAtlas atlas = { 0 };
+	Image images[ATLAS_MAX_SPRITES];
+	for (int i = 3; i < argc && atlas.count < ATLAS_MAX_SPRITES; i++)
+	{
+		const char* eq = strchr(argv[i], '=');
+		if (eq == nullptr || eq - argv[i] >= ATLAS_NAME_SIZE)
+		{
+			printf("atlas_pack: expected <name>=<image>, got %s\n", argv[i]);
+			return 1;
+		}
+
+		Image img = LoadImage(eq + 1);
+		if (img.data == nullptr)
+		{
+			printf("atlas_pack: can't load %s\n", eq + 1);
+			return 1;
+		}
+		ImageFormat(&img, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+		AtlasSprite* s = &atlas.sprites[atlas.count];
+		memcpy(s->name, argv[i], eq - argv[i]);
+		s->name[eq - argv[i]] = '\0';
+		s->width = img.width;
+		s->height = img.height;
+		images[atlas.count++] = img;
+	}
+
+	if (!PackSpriteAtlas(&atlas, ATLAS_MAX_WIDTH))
+	{
+		printf("atlas_pack: a sprite is wider than %d pixels\n", ATLAS_MAX_WIDTH);
+		return 1;
+	}
+
+	Image out = GenImageColor(atlas.width, atlas.height, BLANK);
+	for (int i = 0; i < atlas.count; i++)
+	{
+		const AtlasSprite* s = &atlas.sprites[i];
+		ImageDraw(&out, images[i], { 0, 0, (float)s->width, (float)s->height }, { (float)s->x, (float)s->y, (float)s->width, (float)s->height }, WHITE);
+		UnloadImage(images[i]);
+	}
+
+	bool ok = ExportImage(out, argv[1]) && SaveSpriteAtlasLayout(&atlas, argv[2]);
+	UnloadImage(out);
+
+	printf("atlas_pack: %d sprites into %dx%d%s\n", atlas.count, atlas.width, atlas.height, ok ? "" : ", WRITE FAILED");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,257 @@
+/*******************************************************************************************
+*
+*   Carve Queue - coalesces all of a tick's carves into one pass over the terrain mask
+*
+********************************************************************************************/
+
+#include "carve_queue.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition (local)
+//----------------------------------------------------------------------------------
+static void ExtendRect(TerrainRect* r, int x0, int y0, int x1, int y1)
+{
+	if (r->width == 0)
+	{
+		*r = { x0, y0, x1 - x0, y1 - y0 };
+		return;
+	}
+
+	int rx1 = r->x + r->width, ry1 = r->y + r->height;
+	if (x0 < r->x) r->x = x0;
+	if (y0 < r->y) r->y = y0;
+	if (x1 > rx1) rx1 = x1;
+	if (y1 > ry1) ry1 = y1;
+	r->width = rx1 - r->x;
+	r->height = ry1 - r->y;
+}
+
+// Clear one row segment inside a single tile, returns pixels cleared
+static int ClearSegment(CarveQueue* queue, int* mask, int y, int x0, int x1, int carve, CarvePixelCallback removed, void* userData)
+{
+	int* row = mask + y * queue->width;
+	int first = -1, last = -1, cleared = 0;
+
+	//wear the segment down first, what still has hardness stays solid
+	const unsigned char* hardness = nullptr;
+	if (queue->materials != nullptr)
+	{
+		DamageTerrainRow(queue->materials, y, x0, x1, queue->damage);
+		hardness = queue->materials->hardness + y * queue->materials->bytesPerRow;
+	}
+
+	for (int x = x0; x < x1; x++)
+	{
+		if (row[x] != 1) continue;
+		if (hardness != nullptr && ((hardness[x >> 1] >> ((x & 1) * 4)) & 15) != 0) continue;
+
+		row[x] = 0;
+		if (removed != nullptr) removed(x, y, carve, userData);
+		if (first < 0) first = x;
+		last = x;
+		cleared++;
+	}
+
+	if (cleared > 0)
+	{
+		int tile = (y / TERRAIN_TILE_SIZE) * queue->tilesX + x0 / TERRAIN_TILE_SIZE;
+		ExtendRect(&queue->tileBounds[tile], first, y, last + 1, y + 1);
+	}
+
+	queue->stats.pixelsVisited += x1 - x0;
+	return cleared;
+}
+
+//----------------------------------------------------------------------------------
+// Carve Queue Functions Definition
+//----------------------------------------------------------------------------------
+void BuildCarveStamp(CarveStamp* stamp, const int* mask, int width, int height)
+{
+	stamp->width = width;
+	stamp->height = height;
+	stamp->rowStart = (int*)calloc(height + 1, sizeof(int));
+
+	//runs per row can't exceed half the row, count first then fill
+	int total = 0;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		total = 0;
+		for (int y = 0; y < height; y++)
+		{
+			if (pass == 1) stamp->rowStart[y] = total;
+			for (int x = 0; x < width; x++)
+			{
+				if (mask[y * width + x] != 1 || (x > 0 && mask[y * width + x - 1] == 1)) continue;
+
+				int end = x;
+				while (end < width && mask[y * width + end] == 1) end++;
+				if (pass == 1) stamp->spans[total] = { x, end };
+				total++;
+			}
+		}
+		if (pass == 0) stamp->spans = (CarveSpan*)malloc((total > 0 ? total : 1) * sizeof(CarveSpan));
+	}
+	stamp->rowStart[height] = total;
+}
+
+void UnloadCarveStamp(CarveStamp* stamp)
+{
+	free(stamp->rowStart);
+	free(stamp->spans);
+	memset(stamp, 0, sizeof(CarveStamp));
+}
+
+void InitCarveQueue(CarveQueue* queue, int width, int height, int capacity)
+{
+	queue->width = width;
+	queue->height = height;
+	queue->carves = (QueuedCarve*)malloc(capacity * sizeof(QueuedCarve));
+	queue->count = 0;
+	queue->capacity = capacity;
+
+	queue->rowStart = (int*)calloc(height + 1, sizeof(int));
+	queue->columnStart = (int*)calloc(width + 1, sizeof(int));
+	queue->spans = nullptr;
+	queue->sortedSpans = nullptr;
+	queue->spanCapacity = 0;
+
+	queue->tilesX = (width + TERRAIN_TILE_SIZE - 1) / TERRAIN_TILE_SIZE;
+	queue->tilesY = (height + TERRAIN_TILE_SIZE - 1) / TERRAIN_TILE_SIZE;
+	queue->tileBounds = (TerrainRect*)calloc(queue->tilesX * queue->tilesY, sizeof(TerrainRect));
+	memset(&queue->stats, 0, sizeof(CarveQueueStats));
+
+	queue->materials = nullptr;
+	queue->damage = 0;
+}
+
+void UnloadCarveQueue(CarveQueue* queue)
+{
+	free(queue->carves);
+	free(queue->rowStart);
+	free(queue->columnStart);
+	free(queue->spans);
+	free(queue->sortedSpans);
+	free(queue->tileBounds);
+	memset(queue, 0, sizeof(CarveQueue));
+}
+
+bool QueueCarve(CarveQueue* queue, const CarveStamp* stamp, int x, int y)
+{
+	if (queue->count == queue->capacity) return false;
+
+	queue->carves[queue->count++] = { stamp, x, y };
+	return true;
+}
+
+void SetCarveMaterials(CarveQueue* queue, TerrainMaterials* materials, int damage)
+{
+	queue->materials = materials;
+	queue->damage = damage;
+}
+
+int FlushCarveQueue(CarveQueue* queue, int* mask, CarvePixelCallback removed, void* userData)
+{
+	CarveQueueStats* stats = &queue->stats;
+	memset(stats, 0, sizeof(CarveQueueStats));
+	stats->carves = queue->count;
+	if (queue->count == 0) return 0;
+
+	int width = queue->width, height = queue->height;
+	int* rowStart = queue->rowStart;
+	int* columnStart = queue->columnStart;
+	memset(rowStart, 0, (height + 1) * sizeof(int));
+	memset(columnStart, 0, (width + 1) * sizeof(int));
+
+	//gather the clipped spans, counting them per start column and per row
+	int total = 0;
+	for (int c = 0; c < queue->count; c++)
+	{
+		const QueuedCarve* q = &queue->carves[c];
+		for (int r = 0; r < q->stamp->height; r++)
+		{
+			int y = q->y + r;
+			if (y < 0 || y >= height) continue;
+
+			for (int s = q->stamp->rowStart[r]; s < q->stamp->rowStart[r + 1]; s++)
+			{
+				int x0 = q->x + q->stamp->spans[s].x0, x1 = q->x + q->stamp->spans[s].x1;
+				if (x1 <= 0 || x0 >= width) continue;
+
+				if (total == queue->spanCapacity)
+				{
+					queue->spanCapacity = queue->spanCapacity > 0 ? queue->spanCapacity * 2 : 4096;
+					queue->spans = (CarveRowSpan*)realloc(queue->spans, queue->spanCapacity * sizeof(CarveRowSpan));
+					queue->sortedSpans = (CarveRowSpan*)realloc(queue->sortedSpans, queue->spanCapacity * sizeof(CarveRowSpan));
+				}
+
+				x0 = x0 < 0 ? 0 : x0;
+				queue->spans[total++] = { x0, x1 > width ? width : x1, y, c };
+				columnStart[x0 + 1]++;
+				rowStart[y + 1]++;
+			}
+		}
+	}
+	stats->spans = total;
+
+	//two stable counting sorts, by start column then by row, leave every row's spans in x order
+	for (int x = 0; x < width; x++) columnStart[x + 1] += columnStart[x];
+	for (int i = 0; i < total; i++) queue->sortedSpans[columnStart[queue->spans[i].x0]++] = queue->spans[i];
+
+	for (int y = 0; y < height; y++) rowStart[y + 1] += rowStart[y];
+	for (int i = 0; i < total; i++) queue->spans[rowStart[queue->sortedSpans[i].y]++] = queue->sortedSpans[i];
+	memmove(rowStart + 1, rowStart, height * sizeof(int));
+	rowStart[0] = 0;
+
+	//each row once: spans in x order, only the part past what earlier spans cleared is visited
+	int cleared = 0;
+	for (int y = 0; y < height; y++)
+	{
+		CarveRowSpan* spans = queue->spans + rowStart[y];
+		int n = rowStart[y + 1] - rowStart[y];
+		if (n == 0) continue;
+
+		int cursor = 0;
+		for (int i = 0; i < n; i++)
+		{
+			int x = spans[i].x0 > cursor ? spans[i].x0 : cursor;
+			while (x < spans[i].x1)
+			{
+				int tileEnd = (x / TERRAIN_TILE_SIZE + 1) * TERRAIN_TILE_SIZE;
+				int end = tileEnd < spans[i].x1 ? tileEnd : spans[i].x1;
+				cleared += ClearSegment(queue, mask, y, x, end, spans[i].carve, removed, userData);
+				x = end;
+			}
+			if (spans[i].x1 > cursor) cursor = spans[i].x1;
+		}
+	}
+	stats->pixelsCleared = cleared;
+
+	//one rect per run of dirty tiles in a tile row, the event bus merges the rest
+	for (int ty = 0; ty < queue->tilesY; ty++)
+	{
+		TerrainRect run = { 0 };
+		for (int tx = 0; tx <= queue->tilesX; tx++)
+		{
+			TerrainRect* b = tx < queue->tilesX ? &queue->tileBounds[ty * queue->tilesX + tx] : nullptr;
+			if (b != nullptr && b->width > 0)
+			{
+				ExtendRect(&run, b->x, b->y, b->x + b->width, b->y + b->height);
+				*b = { 0 };
+				continue;
+			}
+
+			if (run.width > 0)
+			{
+				PublishTerrainChange(run);
+				stats->rectsPublished++;
+				run = { 0 };
+			}
+		}
+	}
+
+	queue->count = 0;
+	return cleared;
+}
@@ -0,0 +1,94 @@
+/*******************************************************************************************
+*
+*   Carve Queue - coalesces all of a tick's carves into one pass over the terrain mask
+*
+*   Impacts queue a stamp instead of carving right away. The flush buckets every stamp row
+*   by map row, and clears each row once as the union of the spans that hit it, so a
+*   barrage of overlapping blasts touches each pixel once. The changed area is published
+*   per run of dirty terrain tiles, once per tick, instead of once per blast.
+*
+*   With a material plane attached, the row pass damages hardness instead, and only the
+*   pixels worn down to 0 leave the mask. Overlapping blasts of a tick damage a pixel once.
+*
+********************************************************************************************/
+
+#ifndef CARVE_QUEUE_H
+#define CARVE_QUEUE_H
+
+#include "terrain_events.h"
+#include "terrain_material.h"
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct CarveSpan {
+	int x0, x1;                     // [x0, x1) within the stamp row
+} CarveSpan;
+
+// Stamp mask stored as solid runs per row
+typedef struct CarveStamp {
+	int width, height;
+	int* rowStart;                  // height + 1 offsets into spans
+	CarveSpan* spans;
+} CarveStamp;
+
+typedef struct QueuedCarve {
+	const CarveStamp* stamp;
+	int x, y;                       // Stamp top-left on the map
+} QueuedCarve;
+
+typedef struct CarveRowSpan {
+	int x0, x1;
+	int y;
+	int carve;                      // Index of the queued carve it came from
+} CarveRowSpan;
+
+typedef struct CarveQueueStats {
+	int carves;                     // Last flush
+	int spans;
+	int pixelsVisited;              // Each at most once per flush
+	int pixelsCleared;
+	int rectsPublished;
+} CarveQueueStats;
+
+// A solid pixel cleared by the flush, carve tells which queued carve reached it first
+typedef void (*CarvePixelCallback)(int x, int y, int carve, void* userData);
+
+typedef struct CarveQueue {
+	int width, height;
+
+	QueuedCarve* carves;
+	int count;
+	int capacity;
+
+	int* rowStart;                  // height + 1, spans bucketed by map row
+	int* columnStart;               // width + 1, for the sort by start column
+	CarveRowSpan* spans;
+	CarveRowSpan* sortedSpans;      // Sort scratch
+	int spanCapacity;
+
+	int tilesX, tilesY;
+	TerrainRect* tileBounds;        // Per TERRAIN_TILE_SIZE tile, carved extent this flush (width 0 if clean)
+
+	TerrainMaterials* materials;    // Optional, not owned, null carves everything under the stamp
+	int damage;                     // Hardness taken off per flush
+
+	CarveQueueStats stats;
+} CarveQueue;
+
+//----------------------------------------------------------------------------------
+// Carve Queue Functions Declaration
+//----------------------------------------------------------------------------------
+void BuildCarveStamp(CarveStamp* stamp, const int* mask, int width, int height);    // mask: 1 carves
+void UnloadCarveStamp(CarveStamp* stamp);
+
+void InitCarveQueue(CarveQueue* queue, int width, int height, int capacity);
+void UnloadCarveQueue(CarveQueue* queue);
+
+bool QueueCarve(CarveQueue* queue, const CarveStamp* stamp, int x, int y);   // false once full for this tick
+void SetCarveMaterials(CarveQueue* queue, TerrainMaterials* materials, int damage);    // materials must match the mask size
+
+// Clear every queued stamp from mask (1 = solid), publish the dirty tiles, empty the queue
+int FlushCarveQueue(CarveQueue* queue, int* mask, CarvePixelCallback removed, void* userData);   // Returns pixels cleared
+
+#endif // CARVE_QUEUE_H
@@ -0,0 +1,207 @@
+/*******************************************************************************************
+*
+*   Debris - carved terrain pixels as ballistic particles
+*
+********************************************************************************************/
+
+#include "debris.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__SSE__)
+	#include <xmmintrin.h>
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Variables Definition (local)
+//----------------------------------------------------------------------------------
+static unsigned int rngState = 0x9E3779B9u;
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition (local)
+//----------------------------------------------------------------------------------
+
+// xorshift32, deterministic and cheap enough to call per emitted pixel
+static float RandomUnit()
+{
+	rngState ^= rngState << 13;
+	rngState ^= rngState >> 17;
+	rngState ^= rngState << 5;
+	return (rngState & 0xFFFFFF) / 16777216.0f;
+}
+
+// Move particle src over dst, used to keep the live range packed
+static void MoveParticle(DebrisPool* pool, int dst, int src)
+{
+	pool->x[dst] = pool->x[src];
+	pool->y[dst] = pool->y[src];
+	pool->vx[dst] = pool->vx[src];
+	pool->vy[dst] = pool->vy[src];
+	pool->color[dst] = pool->color[src];
+	pool->age[dst] = pool->age[src];
+}
+
+static void IntegrateDebris(DebrisPool* pool, float gravity)
+{
+	float* x = pool->x;
+	float* y = pool->y;
+	float* vx = pool->vx;
+	float* vy = pool->vy;
+	int n = pool->count;
+	int i = 0;
+
+#if defined(__SSE__)
+	__m128 g = _mm_set1_ps(gravity);
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128 px = _mm_loadu_ps(x + i);
+		__m128 py = _mm_loadu_ps(y + i);
+		__m128 sx = _mm_loadu_ps(vx + i);
+		__m128 sy = _mm_loadu_ps(vy + i);
+
+		_mm_storeu_ps(x + i, _mm_add_ps(px, sx));
+		_mm_storeu_ps(y + i, _mm_add_ps(py, sy));
+		_mm_storeu_ps(vy + i, _mm_add_ps(sy, g));
+	}
+#endif
+
+	for (; i < n; i++)
+	{
+		x[i] += vx[i];
+		y[i] += vy[i];
+		vy[i] += gravity;
+	}
+}
+
+//----------------------------------------------------------------------------------
+// Debris Functions Definition
+//----------------------------------------------------------------------------------
+void InitDebrisPool(DebrisPool* pool, int capacity)
+{
+	pool->x = (float*)calloc(capacity, sizeof(float));
+	pool->y = (float*)calloc(capacity, sizeof(float));
+	pool->vx = (float*)calloc(capacity, sizeof(float));
+	pool->vy = (float*)calloc(capacity, sizeof(float));
+	pool->color = (unsigned int*)calloc(capacity, sizeof(unsigned int));
+	pool->age = (unsigned short*)calloc(capacity, sizeof(unsigned short));
+	pool->settledIx = (int*)calloc(capacity, sizeof(int));
+	pool->settledColor = (unsigned int*)calloc(capacity, sizeof(unsigned int));
+
+	pool->capacity = capacity;
+	pool->count = 0;
+	pool->settledCount = 0;
+}
+
+void UnloadDebrisPool(DebrisPool* pool)
+{
+	free(pool->x);
+	free(pool->y);
+	free(pool->vx);
+	free(pool->vy);
+	free(pool->color);
+	free(pool->age);
+	free(pool->settledIx);
+	free(pool->settledColor);
+	memset(pool, 0, sizeof(DebrisPool));
+}
+
+void ClearDebrisPool(DebrisPool* pool)
+{
+	pool->count = 0;
+	pool->settledCount = 0;
+}
+
+bool EmitDebris(DebrisPool* pool, float x, float y, float fromX, float fromY, unsigned int color)
+{
+	if (pool->count >= pool->capacity) return false;
+
+	float dx = x - fromX;
+	float dy = y - fromY;
+	float len = sqrtf(dx * dx + dy * dy);
+	if (len < 1.0f) len = 1.0f;
+
+	//thrown outwards, faster near the centre of the blast, with an upward kick
+	float speed = 1.0f + 2.5f * RandomUnit();
+	int i = pool->count++;
+	pool->x[i] = x + 0.5f;
+	pool->y[i] = y + 0.5f;
+	pool->vx[i] = dx / len * speed + (RandomUnit() - 0.5f);
+	pool->vy[i] = dy / len * speed - 2.0f - 2.0f * RandomUnit();
+	pool->color[i] = color;
+	pool->age[i] = 0;
+
+	return true;
+}
+
+int UpdateDebris(DebrisPool* pool, float gravity, int* mask, unsigned char* pixels, int width, int height, TerrainRect* dirty)
+{
+	int x0 = width, y0 = height, x1 = 0, y1 = 0;
+	pool->settledCount = 0;
+
+	IntegrateDebris(pool, gravity);
+
+	int i = 0;
+	while (i < pool->count)
+	{
+		float x = pool->x[i];
+		float y = pool->y[i];
+
+		if (x < 0 || x >= width || y >= height || pool->age[i] >= DEBRIS_MAX_AGE)
+		{
+			MoveParticle(pool, i, --pool->count);
+			continue;
+		}
+
+		pool->age[i]++;
+
+		if (y < 0 || mask[(int)y * width + (int)x] == 0)
+		{
+			i++;
+			continue;
+		}
+
+		//landed, settle into the last free cell along the way back up
+		int sx = (int)(x - pool->vx[i]);
+		int sy = (int)(y - (pool->vy[i] - gravity));
+		if (sx < 0) sx = 0;
+		if (sx >= width) sx = width - 1;
+		if (sy >= height) sy = height - 1;
+
+		for (int climb = 0; climb < 4 && sy >= 0 && mask[sy * width + sx] != 0; climb++) sy--;
+
+		if (sy >= 0 && mask[sy * width + sx] == 0)
+		{
+			int ix = sy * width + sx;
+
+			//claim the cell now so later particles this tick stack on top of it
+			mask[ix] = 1;
+			pool->settledIx[pool->settledCount] = ix;
+			pool->settledColor[pool->settledCount] = pool->color[i];
+			pool->settledCount++;
+		}
+
+		MoveParticle(pool, i, --pool->count);
+	}
+
+	//write the settled batch back to the terrain image in one go
+	unsigned int* px = (unsigned int*)pixels;
+	for (int s = 0; s < pool->settledCount; s++)
+	{
+		int ix = pool->settledIx[s];
+		int sx = ix % width;
+		int sy = ix / width;
+
+		px[ix] = pool->settledColor[s] | 0xFF000000u;
+
+		if (sx < x0) x0 = sx;
+		if (sy < y0) y0 = sy;
+		if (sx + 1 > x1) x1 = sx + 1;
+		if (sy + 1 > y1) y1 = sy + 1;
+	}
+
+	*dirty = { x0, y0, x1 > x0 ? x1 - x0 : 0, y1 > y0 ? y1 - y0 : 0 };
+
+	return pool->settledCount;
+}
@@ -0,0 +1,54 @@
+/*******************************************************************************************
+*
+*   Debris - carved terrain pixels as ballistic particles
+*
+*   Pixels removed by a carve are emitted as particles carrying their terrain colour.
+*   They fly under gravity and settle back into the terrain as solid pixels.
+*
+*   Particles are kept as structure-of-arrays in a fixed pool so the integration step
+*   can run 4 particles at a time with SSE (scalar fallback elsewhere, i.e. web builds).
+*
+********************************************************************************************/
+
+#ifndef DEBRIS_H
+#define DEBRIS_H
+
+#include "terrain_events.h"
+
+#define DEBRIS_MAX_PARTICLES        131072      // Pool capacity, target is 100k live particles
+#define DEBRIS_MAX_AGE                 600      // Ticks before an airborne particle is dropped
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct DebrisPool {
+	float* x;                       // Position
+	float* y;
+	float* vx;                      // Velocity, pixels per tick
+	float* vy;
+	unsigned int* color;            // RGBA8 as stored in the terrain image
+	unsigned short* age;            // Ticks alive
+
+	int count;                      // Live particles, always packed at [0, count)
+	int capacity;
+
+	int* settledIx;                 // Pixel indices settled this tick, written back as a batch
+	unsigned int* settledColor;
+	int settledCount;
+} DebrisPool;
+
+//----------------------------------------------------------------------------------
+// Debris Functions Declaration
+//----------------------------------------------------------------------------------
+void InitDebrisPool(DebrisPool* pool, int capacity);
+void UnloadDebrisPool(DebrisPool* pool);
+void ClearDebrisPool(DebrisPool* pool);
+
+// Emit one particle at (x, y) thrown away from the blast centre (fromX, fromY)
+bool EmitDebris(DebrisPool* pool, float x, float y, float fromX, float fromY, unsigned int color);
+
+// Integrate one tick, settle landed particles into mask/pixels (RGBA8)
+// Returns the number of pixels written back, their bounding box goes to dirty
+int UpdateDebris(DebrisPool* pool, float gravity, int* mask, unsigned char* pixels, int width, int height, TerrainRect* dirty);
+
+#endif // DEBRIS_H
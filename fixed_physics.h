@@ -0,0 +1,50 @@
+/*******************************************************************************************
+*
+*   Fixed Physics - deterministic Q16.16 integration and table-driven trigonometry
+*
+*   Positions, velocities and gravity are 32-bit Q16.16 integers and every operation is an
+*   integer add, multiply or shift, so a step gives the same bits on every compiler,
+*   optimisation level and on the web build. Angles are binary: FIXED_ANGLE_TURN units per
+*   full turn, sine and arctangent come from hardcoded tables, never from libm.
+*
+********************************************************************************************/
+
+#ifndef FIXED_PHYSICS_H
+#define FIXED_PHYSICS_H
+
+#define FIXED_SHIFT                      16
+#define FIXED_ONE               (1 << FIXED_SHIFT)
+#define FIXED_ANGLE_TURN              65536     // Angle units per turn, a quarter is 16384
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef int fixed;                  // Q16.16
+
+// Structure of arrays over caller storage, so a single shell and a pool step the same way
+typedef struct FixedBodies {
+	fixed* x;
+	fixed* y;
+	fixed* vx;
+	fixed* vy;
+	int count;
+} FixedBodies;
+
+//----------------------------------------------------------------------------------
+// Fixed Physics Functions Declaration
+//----------------------------------------------------------------------------------
+static inline fixed IntToFixed(int v) { return v * FIXED_ONE; }
+static inline fixed FloatToFixed(float v) { return (fixed)(v * FIXED_ONE); }    // Only at the edges, e.g. mouse input
+static inline float FixedToFloat(fixed v) { return v / (float)FIXED_ONE; }
+static inline fixed FixedMul(fixed a, fixed b) { return (fixed)(((long long)a * b) >> FIXED_SHIFT); }
+
+fixed FixedSin(int angle);
+fixed FixedCos(int angle);
+int FixedAtan2(fixed y, fixed x);                       // 0..FIXED_ANGLE_TURN-1, counter-clockwise from +x
+unsigned int IntSqrt(unsigned long long v);             // Floor of the square root
+fixed FixedLength(fixed x, fixed y);
+
+// position += velocity, then velocity.y += gravity, for every body
+void StepFixedBodies(FixedBodies* bodies, fixed gravity);
+
+#endif // FIXED_PHYSICS_H
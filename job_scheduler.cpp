@@ -0,0 +1,223 @@
+/*******************************************************************************************
+*
+*   Job Scheduler - resumable background upkeep run inside a per-frame time budget
+*
+********************************************************************************************/
+
+#include "job_scheduler.h"
+#include "thread_pool.h"
+
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef enum JobState { JOB_FREE = 0, JOB_CLAIMED, JOB_QUEUED, JOB_RUNNING } JobState;
+
+typedef struct Job {
+	const char* name;
+	JobStepFunc step;
+	void* userData;
+	JobPriority priority;
+	bool parallel;
+
+	int id;                         // generation * JOB_MAX + slot
+	double submitTime;
+	int submitFrame;
+	double workMs;
+	double longestSliceMs;
+	int slices;
+
+	std::atomic<int> state;
+} Job;
+
+//----------------------------------------------------------------------------------
+// Module Variables Definition (local)
+//----------------------------------------------------------------------------------
+static Job jobs[JOB_MAX];
+static int generation = 0;
+static std::atomic<int> frame(0);
+static PoolTaskGroup parallelJobs;
+
+static std::mutex reportLock;       // Parallel jobs finish on workers
+static JobReport reports[JOB_REPORTS];
+static int reportsWritten = 0;
+static int finished = 0;
+static double lastFrameMs = 0;
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition (local)
+//----------------------------------------------------------------------------------
+static double Now()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static JobStatus RunSlice(Job* job)
+{
+	double t0 = Now();
+	JobStatus status = job->step(job->userData);
+	double ms = (Now() - t0) * 1000.0;
+
+	job->workMs += ms;
+	if (ms > job->longestSliceMs) job->longestSliceMs = ms;
+	job->slices++;
+	return status;
+}
+
+static void FinishJob(Job* job)
+{
+	JobReport report = { job->name, job->id, job->priority, job->parallel, (Now() - job->submitTime) * 1000.0,
+		job->workMs, job->longestSliceMs, job->slices, frame.load() - job->submitFrame + 1 };
+	{
+		std::lock_guard<std::mutex> lock(reportLock);
+		reports[reportsWritten++ % JOB_REPORTS] = report;
+		finished++;
+	}
+	job->state.store(JOB_FREE, std::memory_order_release);
+}
+
+// Parallel jobs don't share a frame with anything, they step until done
+static void RunParallelJob(void* data)
+{
+	Job* job = (Job*)data;
+	while (RunSlice(job) == JOB_YIELD) {}
+	FinishJob(job);
+}
+
+// Lowest priority value after aging wins, the older job on a tie
+static Job* PickMainThreadJob()
+{
+	Job* best = nullptr;
+	int bestRank = 0;
+	for (int i = 0; i < JOB_MAX; i++)
+	{
+		Job* job = &jobs[i];
+		if (job->state.load(std::memory_order_acquire) != JOB_QUEUED || job->parallel) continue;
+
+		int rank = (int)job->priority - (frame.load() - job->submitFrame) / JOB_AGING_FRAMES;
+		if (best == nullptr || rank < bestRank || (rank == bestRank && job->submitTime < best->submitTime))
+		{
+			best = job;
+			bestRank = rank;
+		}
+	}
+	return best;
+}
+
+//----------------------------------------------------------------------------------
+// Job Scheduler Functions Definition
+//----------------------------------------------------------------------------------
+void InitJobScheduler()
+{
+	for (int i = 0; i < JOB_MAX; i++) jobs[i].state.store(JOB_FREE);
+	parallelJobs.pending.store(0);
+	frame.store(0);
+	reportsWritten = 0;
+	finished = 0;
+	lastFrameMs = 0;
+}
+
+void UnloadJobScheduler()
+{
+	WaitPoolTasks(&parallelJobs);
+	for (int i = 0; i < JOB_MAX; i++) jobs[i].state.store(JOB_FREE);
+}
+
+int SubmitJob(const char* name, JobStepFunc step, void* userData, JobPriority priority, bool parallel)
+{
+	for (int i = 0; i < JOB_MAX; i++)
+	{
+		Job* job = &jobs[i];
+		int expected = JOB_FREE;
+		if (!job->state.compare_exchange_strong(expected, JOB_CLAIMED)) continue;
+
+		job->name = name;
+		job->step = step;
+		job->userData = userData;
+		job->priority = priority;
+		job->parallel = parallel && GetThreadPoolWorkers() > 0;      // Sliced on the main thread without workers
+		job->id = ++generation * JOB_MAX + i;
+		job->submitTime = Now();
+		job->submitFrame = frame.load();
+		job->workMs = 0;
+		job->longestSliceMs = 0;
+		job->slices = 0;
+
+		if (job->parallel)
+		{
+			job->state.store(JOB_RUNNING, std::memory_order_release);
+			SubmitPoolTask(RunParallelJob, job, &parallelJobs);
+		}
+		else job->state.store(JOB_QUEUED, std::memory_order_release);
+
+		return job->id;
+	}
+
+	return -1;
+}
+
+bool IsJobPending(int id)
+{
+	if (id < 0) return false;
+
+	const Job* job = &jobs[id % JOB_MAX];
+	return job->state.load(std::memory_order_acquire) != JOB_FREE && job->id == id;
+}
+
+void RunScheduledJobs(double budgetSeconds)
+{
+	double start = Now();
+	frame.fetch_add(1);
+
+	//the first slice always runs, so a tight budget still makes progress
+	bool first = true;
+	while (first || Now() - start < budgetSeconds)
+	{
+		Job* job = PickMainThreadJob();
+		if (job == nullptr) break;
+
+		JobStatus status;
+		do
+		{
+			status = RunSlice(job);
+			first = false;
+		} while (status == JOB_YIELD && Now() - start < budgetSeconds);
+
+		if (status == JOB_DONE) FinishJob(job);
+	}
+
+	lastFrameMs = (Now() - start) * 1000.0;
+}
+
+int GetJobReports(JobReport* out, int max)
+{
+	std::lock_guard<std::mutex> lock(reportLock);
+	int count = reportsWritten < JOB_REPORTS ? reportsWritten : JOB_REPORTS;
+	if (count > max) count = max;
+
+	for (int i = 0; i < count; i++) out[i] = reports[(reportsWritten - 1 - i) % JOB_REPORTS];
+	return count;
+}
+
+JobSchedulerStats GetJobSchedulerStats()
+{
+	JobSchedulerStats stats = { 0 };
+	for (int i = 0; i < JOB_MAX; i++)
+		if (jobs[i].state.load(std::memory_order_acquire) != JOB_FREE) stats.pending++;
+
+	std::lock_guard<std::mutex> lock(reportLock);
+	stats.finished = finished;
+	stats.lastFrameMs = lastFrameMs;
+
+	int count = reportsWritten < JOB_REPORTS ? reportsWritten : JOB_REPORTS;
+	for (int i = 0; i < count; i++)
+	{
+		if (reports[i].latencyMs > stats.maxLatencyMs) stats.maxLatencyMs = reports[i].latencyMs;
+		stats.meanLatencyMs += reports[i].latencyMs / count;
+	}
+	return stats;
+}
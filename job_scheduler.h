@@ -0,0 +1,71 @@
+/*******************************************************************************************
+*
+*   Job Scheduler - resumable background upkeep run inside a per-frame time budget
+*
+*   Subsystems submit jobs as a step function that does one slice of work and asks to be
+*   called again until it is done. Main-thread jobs get the frame budget: the most urgent
+*   job runs slice after slice until the budget is spent, a job waiting longer than
+*   JOB_AGING_FRAMES moves up a priority so low priority work still finishes. Jobs marked
+*   parallel run start to finish on the thread pool instead. Every finished job leaves a
+*   report with its latency (submit to done), time worked, slices and longest slice.
+*
+********************************************************************************************/
+
+#ifndef JOB_SCHEDULER_H
+#define JOB_SCHEDULER_H
+
+#define JOB_MAX                          64     // Jobs in flight
+#define JOB_REPORTS                      64     // Finished jobs kept for reporting
+#define JOB_AGING_FRAMES                 30     // Frames waited per priority step gained
+#define JOB_FRAME_BUDGET             0.002      // Seconds of main-thread jobs per frame
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef enum JobStatus { JOB_DONE = 0, JOB_YIELD } JobStatus;
+
+typedef enum JobPriority {
+	JOB_PRIORITY_HIGH = 0,
+	JOB_PRIORITY_NORMAL,
+	JOB_PRIORITY_LOW
+} JobPriority;
+
+typedef JobStatus (*JobStepFunc)(void* userData);      // One slice of work, JOB_YIELD to be called again
+
+typedef struct JobReport {
+	const char* name;
+	int id;
+	JobPriority priority;
+	bool parallel;
+
+	double latencyMs;               // Submit to done
+	double workMs;                  // Inside the step function
+	double longestSliceMs;
+	int slices;
+	int frames;                     // RunScheduledJobs calls it spanned
+} JobReport;
+
+typedef struct JobSchedulerStats {
+	int pending;                    // Submitted and not finished
+	int finished;                   // Since init
+	double lastFrameMs;             // Main-thread job time in the last RunScheduledJobs
+	double maxLatencyMs;            // Over the kept reports
+	double meanLatencyMs;
+} JobSchedulerStats;
+
+//----------------------------------------------------------------------------------
+// Job Scheduler Functions Declaration
+//----------------------------------------------------------------------------------
+void InitJobScheduler();            // Parallel jobs use the thread pool, init it first
+void UnloadJobScheduler();          // Waits for parallel jobs, drops the rest
+
+// name must outlive the job, returns its id or -1 when JOB_MAX jobs are in flight
+int SubmitJob(const char* name, JobStepFunc step, void* userData, JobPriority priority, bool parallel);
+bool IsJobPending(int id);
+
+void RunScheduledJobs(double budgetSeconds);    // Main thread, once per frame, always runs at least one slice
+
+int GetJobReports(JobReport* reports, int max); // Most recent first
+JobSchedulerStats GetJobSchedulerStats();
+
+#endif // JOB_SCHEDULER_H
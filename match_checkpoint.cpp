@@ -0,0 +1,393 @@
+/*******************************************************************************************
+*
+*   Match Checkpoint - match state saved as a delta against the original map
+*
+********************************************************************************************/
+
+#include "match_checkpoint.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TILE TERRAIN_TILE_SIZE
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct ByteWriter {
+	unsigned char* data;
+	int size;
+	int capacity;
+} ByteWriter;
+
+typedef struct ByteReader {
+	const unsigned char* data;
+	int size;
+	int at;
+	bool failed;                    // Read past the end, every later read returns 0
+} ByteReader;
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition (local)
+//----------------------------------------------------------------------------------
+static void Put(ByteWriter* w, unsigned int value, int bytes)
+{
+	if (w->size + bytes > w->capacity)
+	{
+		w->capacity = w->capacity * 2 + bytes + 4096;
+		w->data = (unsigned char*)realloc(w->data, w->capacity);
+	}
+	for (int i = 0; i < bytes; i++) w->data[w->size++] = (unsigned char)(value >> (i * 8));
+}
+
+static void PutBytes(ByteWriter* w, const void* data, int count)
+{
+	if (w->size + count > w->capacity)
+	{
+		w->capacity = w->capacity * 2 + count + 4096;
+		w->data = (unsigned char*)realloc(w->data, w->capacity);
+	}
+	memcpy(w->data + w->size, data, count);
+	w->size += count;
+}
+
+static unsigned int Get(ByteReader* r, int bytes)
+{
+	if (r->failed || r->at + bytes > r->size)
+	{
+		r->failed = true;
+		return 0;
+	}
+
+	unsigned int value = 0;
+	for (int i = 0; i < bytes; i++) value |= (unsigned int)r->data[r->at++] << (i * 8);
+	return value;
+}
+
+static const unsigned char* Skip(ByteReader* r, int count)
+{
+	if (r->failed || count < 0 || r->at + count > r->size)
+	{
+		r->failed = true;
+		return nullptr;
+	}
+
+	r->at += count;
+	return r->data + r->at - count;
+}
+
+static void TileBounds(const MatchCheckpoint* cp, int tile, int* x0, int* y0, int* w, int* h)
+{
+	*x0 = (tile % cp->tilesX) * TILE;
+	*y0 = (tile / cp->tilesX) * TILE;
+	*w = *x0 + TILE < cp->width ? TILE : cp->width - *x0;
+	*h = *y0 + TILE < cp->height ? TILE : cp->height - *y0;
+}
+
+static unsigned long long MaskRowBits(const int* row, int w)
+{
+	unsigned long long bits = 0;
+	for (int x = 0; x < w; x++) bits |= (unsigned long long)(row[x] == 1) << x;
+	return bits;
+}
+
+// Tiles whose hardness was damaged since we last looked are touched from now on
+static void CollectDamagedTiles(MatchCheckpoint* cp)
+{
+	if (cp->materials == nullptr) return;
+
+	for (int t = 0; t < cp->tilesX * cp->tilesY; t++)
+		if (cp->materials->tileVersions[t] != cp->seenVersions[t])
+		{
+			cp->touched[t] = 1;
+			cp->seenVersions[t] = cp->materials->tileVersions[t];
+		}
+}
+
+static void RestoreOriginalTile(MatchCheckpoint* cp, int tile)
+{
+	int x0, y0, w, h;
+	TileBounds(cp, tile, &x0, &y0, &w, &h);
+
+	for (int r = 0; r < h; r++)
+	{
+		unsigned long long bits = cp->originalBits[tile * TILE + r];
+		int* row = cp->mask + (y0 + r) * cp->width + x0;
+		for (int x = 0; x < w; x++) row[x] = (int)((bits >> x) & 1);
+
+		if (cp->pixels != nullptr)
+			memcpy(cp->pixels + (y0 + r) * cp->width + x0, cp->originalPixels + (y0 + r) * cp->width + x0, w * sizeof(unsigned int));
+
+		if (cp->materials != nullptr)
+		{
+			int offset = (y0 + r) * cp->materials->bytesPerRow + x0 / 2;
+			memcpy(cp->materials->hardness + offset, cp->originalHardness + offset, (w + 1) / 2);
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------
+// Match Checkpoint Functions Definition
+//----------------------------------------------------------------------------------
+void InitMatchCheckpoint(MatchCheckpoint* cp, int* mask, unsigned int* pixels, TerrainMaterials* materials, int width, int height)
+{
+	cp->width = width;
+	cp->height = height;
+	cp->tilesX = (width + TILE - 1) / TILE;
+	cp->tilesY = (height + TILE - 1) / TILE;
+	cp->mask = mask;
+	cp->pixels = pixels;
+	cp->materials = materials;
+
+	int tiles = cp->tilesX * cp->tilesY;
+	cp->originalBits = (unsigned long long*)calloc((size_t)tiles * TILE, sizeof(unsigned long long));
+	for (int t = 0; t < tiles; t++)
+	{
+		int x0, y0, w, h;
+		TileBounds(cp, t, &x0, &y0, &w, &h);
+		for (int r = 0; r < h; r++) cp->originalBits[t * TILE + r] = MaskRowBits(mask + (y0 + r) * width + x0, w);
+	}
+
+	cp->originalPixels = nullptr;
+	if (pixels != nullptr)
+	{
+		cp->originalPixels = (unsigned int*)malloc((size_t)width * height * sizeof(unsigned int));
+		memcpy(cp->originalPixels, pixels, (size_t)width * height * sizeof(unsigned int));
+	}
+
+	cp->originalHardness = nullptr;
+	if (materials != nullptr)
+	{
+		size_t bytes = (size_t)materials->bytesPerRow * height;
+		cp->originalHardness = (unsigned char*)malloc(bytes);
+		memcpy(cp->originalHardness, materials->hardness, bytes);
+	}
+
+	cp->touched = (unsigned char*)calloc(tiles, 1);
+	cp->seenVersions = (unsigned int*)calloc(tiles, sizeof(unsigned int));
+	if (materials != nullptr) memcpy(cp->seenVersions, materials->tileVersions, tiles * sizeof(unsigned int));
+}
+
+void UnloadMatchCheckpoint(MatchCheckpoint* cp)
+{
+	free(cp->originalBits);
+	free(cp->originalPixels);
+	free(cp->originalHardness);
+	free(cp->touched);
+	free(cp->seenVersions);
+	memset(cp, 0, sizeof(MatchCheckpoint));
+}
+
+void OnTerrainChangedCheckpoint(const TerrainRect* rects, int count, unsigned int version, void* data)
+{
+	MatchCheckpoint* cp = (MatchCheckpoint*)data;
+	for (int i = 0; i < count; i++)
+	{
+		int tx0 = rects[i].x / TILE, ty0 = rects[i].y / TILE;
+		int tx1 = (rects[i].x + rects[i].width - 1) / TILE, ty1 = (rects[i].y + rects[i].height - 1) / TILE;
+		if (tx0 < 0) tx0 = 0;
+		if (ty0 < 0) ty0 = 0;
+		if (tx1 >= cp->tilesX) tx1 = cp->tilesX - 1;
+		if (ty1 >= cp->tilesY) ty1 = cp->tilesY - 1;
+
+		for (int ty = ty0; ty <= ty1; ty++)
+			for (int tx = tx0; tx <= tx1; tx++) cp->touched[ty * cp->tilesX + tx] = 1;
+	}
+}
+
+unsigned char* SaveMatchCheckpoint(MatchCheckpoint* cp, const void* entities, int entityBytes, int* size)
+{
+	ByteWriter w = { 0 };
+	PutBytes(&w, "CKP1", 4);
+	Put(&w, cp->width, 4);
+	Put(&w, cp->height, 4);
+	int countAt = w.size;
+	Put(&w, 0, 4);
+	Put(&w, entityBytes, 4);
+	if (entityBytes > 0) PutBytes(&w, entities, entityBytes);
+
+	CollectDamagedTiles(cp);
+
+	int written = 0;
+	for (int t = 0; t < cp->tilesX * cp->tilesY; t++)
+	{
+		if (!cp->touched[t]) continue;
+
+		int x0, y0, w0, h;
+		TileBounds(cp, t, &x0, &y0, &w0, &h);
+
+		//a touched tile can still match the original, nothing to write then
+		unsigned long long rows[TILE];
+		bool maskDiffers = false, hardnessDiffers = false;
+		int colors = 0;
+		for (int r = 0; r < h; r++)
+		{
+			int y = y0 + r;
+			rows[r] = MaskRowBits(cp->mask + y * cp->width + x0, w0);
+			if (rows[r] != cp->originalBits[t * TILE + r]) maskDiffers = true;
+
+			if (cp->pixels != nullptr)
+				for (int x = x0; x < x0 + w0; x++)
+					if (cp->mask[y * cp->width + x] == 1 && cp->pixels[y * cp->width + x] != cp->originalPixels[y * cp->width + x]) colors++;
+
+			if (cp->materials != nullptr && !hardnessDiffers)
+			{
+				int offset = y * cp->materials->bytesPerRow + x0 / 2;
+				hardnessDiffers = memcmp(cp->materials->hardness + offset, cp->originalHardness + offset, (w0 + 1) / 2) != 0;
+			}
+		}
+		if (!maskDiffers && colors == 0 && !hardnessDiffers) continue;
+
+		Put(&w, t, 4);
+		Put(&w, hardnessDiffers ? 1 : 0, 1);
+
+		//runs alternate empty, solid, empty... in raster order over the tile, the first may be 0 long
+		int runsAt = w.size, runs = 0, length = 0;
+		Put(&w, 0, 2);
+		unsigned long long current = 0;
+		for (int r = 0; r < h; r++)
+			for (int x = 0; x < w0; x++)
+			{
+				unsigned long long bit = (rows[r] >> x) & 1;
+				if (bit != current)
+				{
+					Put(&w, length, 2);
+					runs++;
+					current = bit;
+					length = 0;
+				}
+				length++;
+			}
+		Put(&w, length, 2);
+		runs++;
+		w.data[runsAt] = (unsigned char)runs;
+		w.data[runsAt + 1] = (unsigned char)(runs >> 8);
+
+		Put(&w, colors, 2);
+		if (colors > 0)
+			for (int r = 0; r < h; r++)
+				for (int x = 0; x < w0; x++)
+				{
+					int ix = (y0 + r) * cp->width + x0 + x;
+					if (cp->mask[ix] != 1 || cp->pixels[ix] == cp->originalPixels[ix]) continue;
+					Put(&w, r * TILE + x, 2);
+					Put(&w, cp->pixels[ix], 4);
+				}
+
+		if (hardnessDiffers)
+			for (int r = 0; r < h; r++) PutBytes(&w, cp->materials->hardness + (y0 + r) * cp->materials->bytesPerRow + x0 / 2, (w0 + 1) / 2);
+
+		written++;
+	}
+
+	for (int i = 0; i < 4; i++) w.data[countAt + i] = (unsigned char)(written >> (i * 8));
+	*size = w.size;
+	return w.data;
+}
+
+bool LoadMatchCheckpoint(MatchCheckpoint* cp, const unsigned char* data, int size, void* entities, int entityBytes)
+{
+	ByteReader r = { data, size, 0, false };
+	const unsigned char* magic = Skip(&r, 4);
+	if (magic == nullptr || memcmp(magic, "CKP1", 4) != 0) return false;
+	if ((int)Get(&r, 4) != cp->width || (int)Get(&r, 4) != cp->height) return false;
+	int count = (int)Get(&r, 4);
+	if ((int)Get(&r, 4) != entityBytes) return false;
+	const unsigned char* blob = Skip(&r, entityBytes);
+	int tiles = cp->tilesX * cp->tilesY;
+	if (r.failed || count < 0 || count > tiles) return false;
+
+	//validate every record before touching the live state
+	int* records = (int*)malloc((count > 0 ? count : 1) * sizeof(int));
+	unsigned char* inCheckpoint = (unsigned char*)calloc(tiles, 1);
+	bool valid = true;
+	for (int i = 0; i < count && valid; i++)
+	{
+		records[i] = r.at;
+		int t = (int)Get(&r, 4);
+		int flags = (int)Get(&r, 1);
+		if (r.failed || t < 0 || t >= tiles || inCheckpoint[t] || (flags & 1 && cp->materials == nullptr))
+		{
+			valid = false;
+			break;
+		}
+		inCheckpoint[t] = 1;
+
+		int x0, y0, w, h;
+		TileBounds(cp, t, &x0, &y0, &w, &h);
+		int runs = (int)Get(&r, 2), covered = 0;
+		for (int k = 0; k < runs; k++) covered += (int)Get(&r, 2);
+		int colors = (int)Get(&r, 2);
+		for (int k = 0; k < colors; k++)
+		{
+			int offset = (int)Get(&r, 2);
+			Get(&r, 4);
+			if (offset % TILE >= w || offset / TILE >= h || cp->pixels == nullptr) valid = false;
+		}
+		if (flags & 1) Skip(&r, h * ((w + 1) / 2));
+		if (r.failed || covered != w * h) valid = false;
+	}
+	if (!valid || r.at != r.size)
+	{
+		free(records);
+		free(inCheckpoint);
+		return false;
+	}
+
+	//tiles damaged now but clean in the checkpoint go back to the original
+	CollectDamagedTiles(cp);
+	for (int t = 0; t < tiles; t++)
+	{
+		if (!cp->touched[t] || inCheckpoint[t]) continue;
+
+		int x0, y0, w, h;
+		TileBounds(cp, t, &x0, &y0, &w, &h);
+		RestoreOriginalTile(cp, t);
+		PublishTerrainChange({ x0, y0, w, h });
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		r.at = records[i];
+		int t = (int)Get(&r, 4);
+		int flags = (int)Get(&r, 1);
+		int x0, y0, w, h;
+		TileBounds(cp, t, &x0, &y0, &w, &h);
+		RestoreOriginalTile(cp, t);
+
+		//carved pixels go blank the way the game blanks them
+		int runs = (int)Get(&r, 2), at = 0;
+		for (int k = 0; k < runs; k++)
+		{
+			int length = (int)Get(&r, 2);
+			int solid = k & 1;
+			for (int p = at; p < at + length; p++)
+			{
+				int ix = (y0 + p / w) * cp->width + x0 + p % w;
+				if (solid == 0 && cp->mask[ix] == 1 && cp->pixels != nullptr) cp->pixels[ix] = 0;
+				cp->mask[ix] = solid;
+			}
+			at += length;
+		}
+
+		int colors = (int)Get(&r, 2);
+		for (int k = 0; k < colors; k++)
+		{
+			int offset = (int)Get(&r, 2);
+			cp->pixels[(y0 + offset / TILE) * cp->width + x0 + offset % TILE] = Get(&r, 4);
+		}
+
+		if (flags & 1)
+			for (int row = 0; row < h; row++)
+				memcpy(cp->materials->hardness + (y0 + row) * cp->materials->bytesPerRow + x0 / 2, Skip(&r, (w + 1) / 2), (w + 1) / 2);
+
+		PublishTerrainChange({ x0, y0, w, h });
+	}
+
+	memcpy(cp->touched, inCheckpoint, tiles);
+	if (entityBytes > 0) memcpy(entities, blob, entityBytes);
+
+	free(records);
+	free(inCheckpoint);
+	return true;
+}
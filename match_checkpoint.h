@@ -0,0 +1,58 @@
+/*******************************************************************************************
+*
+*   Match Checkpoint - match state saved as a delta against the original map
+*
+*   The original mask (one bit per pixel, one 64-bit word per tile row), pixels and
+*   hardness plane are kept from the start of the match. A checkpoint holds only the
+*   tiles that differ from them: occupancy as alternating empty/solid runs, the colour of
+*   every solid pixel whose colour changed (settled debris), and the hardness rows of
+*   damaged tiles, plus an opaque entity blob from the game. Tiles are found through the
+*   terrain events and the material tile versions, so saving costs in proportion to the
+*   damage, not the map.
+*
+*   Layout (little endian): "CKP1", width, height, tile count, entity bytes (u32 each),
+*   the entity blob, then per tile: index (u32), flags (u8), run count (u16) and runs
+*   (u16 each), colour count (u16) and (offset u16, colour u32) pairs, hardness bytes.
+*
+********************************************************************************************/
+
+#ifndef MATCH_CHECKPOINT_H
+#define MATCH_CHECKPOINT_H
+
+#include "terrain_events.h"
+#include "terrain_material.h"
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct MatchCheckpoint {
+	int width, height;
+	int tilesX, tilesY;             // TERRAIN_TILE_SIZE tiles
+
+	int* mask;                      // Live state, not owned, 1 = solid
+	unsigned int* pixels;           // Optional, RGBA8
+	TerrainMaterials* materials;    // Optional
+
+	unsigned long long* originalBits;   // tile * TERRAIN_TILE_SIZE + row, bit x - tile x0
+	unsigned int* originalPixels;
+	unsigned char* originalHardness;
+	unsigned char* touched;         // Per tile, mask changed since the base or the last load
+	unsigned int* seenVersions;     // Material tile versions as of the last save or load
+} MatchCheckpoint;
+
+//----------------------------------------------------------------------------------
+// Match Checkpoint Functions Declaration
+//----------------------------------------------------------------------------------
+// Take the current state as the original map, pixels and materials may be null
+void InitMatchCheckpoint(MatchCheckpoint* checkpoint, int* mask, unsigned int* pixels, TerrainMaterials* materials, int width, int height);
+void UnloadMatchCheckpoint(MatchCheckpoint* checkpoint);
+void OnTerrainChangedCheckpoint(const TerrainRect* rects, int count, unsigned int version, void* checkpoint);   // Terrain events subscriber
+
+// Encode the delta, returns a malloc'd buffer (free it) and its size
+unsigned char* SaveMatchCheckpoint(MatchCheckpoint* checkpoint, const void* entities, int entityBytes, int* size);
+
+// Restore the terrain and copy the entity blob out, publishes every tile it rewrote
+// False (and nothing changed) if the data is malformed or for another map size or entity size
+bool LoadMatchCheckpoint(MatchCheckpoint* checkpoint, const unsigned char* data, int size, void* entities, int entityBytes);
+
+#endif // MATCH_CHECKPOINT_H
@@ -0,0 +1,548 @@
+/*******************************************************************************************
+*
+*   Nav Graph - walkable surface runs of the terrain with cached, batched path queries
+*
+********************************************************************************************/
+
+#include "nav_graph.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NAV_NO_NODE                 0xFFFF
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct NavPred {
+	int state;                      // Node * 2 + end it leaves by
+	int landingX;
+	int cost;
+} NavPred;
+
+typedef struct NavHeapEntry {
+	int cost;
+	int state;
+} NavHeapEntry;
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition (local)
+//----------------------------------------------------------------------------------
+static inline bool Solid(const NavGraph* graph, int x, int y)
+{
+	if ((unsigned int)x >= (unsigned int)graph->width || (unsigned int)y >= (unsigned int)graph->height) return false;
+	return graph->mask[y * graph->width + x] != 0;
+}
+
+static bool IsSurface(const NavGraph* graph, int x, int y)
+{
+	if (!Solid(graph, x, y)) return false;
+	for (int k = 1; k <= graph->params.clearance; k++)
+		if (Solid(graph, x, y - k)) return false;
+	return true;
+}
+
+// Where a unit at surface point (x, y) ends up one column over
+static NavExit Step(const NavGraph* graph, int x, int y, int direction)
+{
+	NavExit exit = { NAV_EXIT_NONE, 0, 0, 0 };
+	int nx = x + direction, ny = y;
+	if ((unsigned int)nx >= (unsigned int)graph->width) return exit;
+
+	const NavParams* p = &graph->params;
+	if (Solid(graph, nx, y))
+	{
+		//up the wall to its top, if the top is in reach
+		while (Solid(graph, nx, ny - 1) && y - (ny - 1) <= p->climbHeight) ny--;
+		if (Solid(graph, nx, ny - 1)) return exit;
+	}
+	else
+	{
+		//down to the first solid, if the drop is survivable
+		while (ny + 1 < graph->height && !Solid(graph, nx, ny + 1) && ny + 1 - y <= p->maxFall) ny++;
+		ny++;
+		if (!Solid(graph, nx, ny) || ny - y > p->maxFall) return exit;
+	}
+	if (!IsSurface(graph, nx, ny)) return exit;
+
+	int dy = ny > y ? ny - y : y - ny;
+	exit.kind = dy <= p->stepHeight ? NAV_EXIT_WALK : (ny < y ? NAV_EXIT_CLIMB : NAV_EXIT_FALL);
+	exit.x = nx;
+	exit.y = ny;
+	exit.cost = 1 + dy;
+	return exit;
+}
+
+// Local node of surface point (x, y) in tile, NAV_NO_NODE if (x, y) is not one
+static int NodeInTile(const NavTile* tile, int tx, int x, int y)
+{
+	int column = x - tx * TERRAIN_TILE_SIZE;
+	for (int i = tile->columnStart[column]; i < tile->columnStart[column + 1]; i++)
+		if (tile->surface[i].y == y) return tile->surface[i].node;
+	return NAV_NO_NODE;
+}
+
+static int GlobalNodeAt(const NavGraph* graph, int x, int y)
+{
+	if ((unsigned int)x >= (unsigned int)graph->width || (unsigned int)y >= (unsigned int)graph->height) return -1;
+
+	int tx = x / TERRAIN_TILE_SIZE, ty = y / TERRAIN_TILE_SIZE;
+	int t = ty * graph->tilesX + tx;
+	int node = NodeInTile(&graph->tiles[t], tx, x, y);
+	return node == NAV_NO_NODE ? -1 : graph->tileFirst[t] + node;
+}
+
+static void PushSurface(NavTile* tile, int y)
+{
+	if (tile->columnStart[TERRAIN_TILE_SIZE] == tile->surfaceCapacity)
+	{
+		tile->surfaceCapacity = tile->surfaceCapacity > 0 ? tile->surfaceCapacity * 2 : 128;
+		tile->surface = (NavSurface*)realloc(tile->surface, tile->surfaceCapacity * sizeof(NavSurface));
+	}
+	tile->surface[tile->columnStart[TERRAIN_TILE_SIZE]++] = { (unsigned short)y, NAV_NO_NODE };
+}
+
+static int PushNode(NavTile* tile, int x, int y)
+{
+	if (tile->count == tile->capacity)
+	{
+		tile->capacity = tile->capacity > 0 ? tile->capacity * 2 : 32;
+		tile->nodes = (NavNode*)realloc(tile->nodes, tile->capacity * sizeof(NavNode));
+	}
+
+	NavNode* node = &tile->nodes[tile->count];
+	memset(node, 0, sizeof(NavNode));
+	node->x0 = node->x1 = x;
+	node->y0 = node->y1 = y;
+	return tile->count++;
+}
+
+static void RebuildTile(NavGraph* graph, int tx, int ty)
+{
+	NavTile* tile = &graph->tiles[ty * graph->tilesX + tx];
+	int x0 = tx * TERRAIN_TILE_SIZE, y0 = ty * TERRAIN_TILE_SIZE;
+	int x1 = x0 + TERRAIN_TILE_SIZE < graph->width ? x0 + TERRAIN_TILE_SIZE : graph->width;
+	int y1 = y0 + TERRAIN_TILE_SIZE < graph->height ? y0 + TERRAIN_TILE_SIZE : graph->height;
+
+	//surface points by column, the running end of the list is columnStart[TERRAIN_TILE_SIZE]
+	graph->stats.nodeCount -= tile->count;
+	tile->count = 0;
+	tile->columnStart[TERRAIN_TILE_SIZE] = 0;
+	for (int x = x0; x < x0 + TERRAIN_TILE_SIZE; x++)
+	{
+		tile->columnStart[x - x0] = tile->columnStart[TERRAIN_TILE_SIZE];
+		if (x >= x1) continue;
+		for (int y = y0; y < y1; y++)
+			if (IsSurface(graph, x, y)) PushSurface(tile, y);
+	}
+
+	//a point joins the node of its left neighbour when each steps onto the other
+	for (int x = x0; x < x1; x++)
+	{
+		int column = x - x0;
+		for (int i = tile->columnStart[column]; i < tile->columnStart[column + 1]; i++)
+		{
+			NavSurface* point = &tile->surface[i];
+			if (x > x0)
+			{
+				NavExit left = Step(graph, x, point->y, -1);
+				int q = left.kind == NAV_EXIT_WALK && left.y >= y0 && left.y < y1 ? NodeInTile(tile, tx, left.x, left.y) : NAV_NO_NODE;
+				if (q != NAV_NO_NODE && tile->nodes[q].x1 == x - 1 && tile->nodes[q].y1 == left.y)
+				{
+					NavExit right = Step(graph, left.x, left.y, 1);
+					if (right.kind == NAV_EXIT_WALK && right.x == x && right.y == point->y)
+					{
+						point->node = (unsigned short)q;
+						tile->nodes[q].x1 = x;
+						tile->nodes[q].y1 = point->y;
+						continue;
+					}
+				}
+			}
+			point->node = (unsigned short)PushNode(tile, x, point->y);
+		}
+	}
+
+	for (int n = 0; n < tile->count; n++)
+	{
+		NavNode* node = &tile->nodes[n];
+		node->exits[0] = Step(graph, node->x0, node->y0, -1);
+		node->exits[1] = Step(graph, node->x1, node->y1, 1);
+	}
+
+	graph->stats.tilesRebuilt++;
+	graph->stats.nodesRebuilt += tile->count;
+	graph->stats.nodeCount += tile->count;
+}
+
+static void RenumberTiles(NavGraph* graph)
+{
+	int tileCount = graph->tilesX * graph->tilesY;
+	graph->tileFirst[0] = 0;
+	for (int t = 0; t < tileCount; t++) graph->tileFirst[t + 1] = graph->tileFirst[t] + graph->tiles[t].count;
+	graph->version++;
+}
+
+static const NavNode* NodeByIndex(const NavGraph* graph, int node)
+{
+	//last tile whose first index is not past node, empty tiles share their first with the next one
+	int lo = 0, hi = graph->tilesX * graph->tilesY - 1;
+	while (lo < hi)
+	{
+		int mid = (lo + hi + 1) >> 1;
+		if (graph->tileFirst[mid] <= node) lo = mid;
+		else hi = mid - 1;
+	}
+	return &graph->tiles[lo].nodes[node - graph->tileFirst[lo]];
+}
+
+static void HeapPush(NavHeapEntry* heap, int* size, int cost, int state)
+{
+	int i = (*size)++;
+	while (i > 0 && heap[(i - 1) >> 1].cost > cost)
+	{
+		heap[i] = heap[(i - 1) >> 1];
+		i = (i - 1) >> 1;
+	}
+	heap[i] = { cost, state };
+}
+
+static NavHeapEntry HeapPop(NavHeapEntry* heap, int* size)
+{
+	NavHeapEntry top = heap[0];
+	NavHeapEntry last = heap[--(*size)];
+	int i = 0;
+	for (;;)
+	{
+		int child = 2 * i + 1;
+		if (child >= *size) break;
+		if (child + 1 < *size && heap[child + 1].cost < heap[child].cost) child++;
+		if (heap[child].cost >= last.cost) break;
+		heap[i] = heap[child];
+		i = child;
+	}
+	if (*size > 0) heap[i] = last;
+	return top;
+}
+
+// Reverse Dijkstra over node ends, exitCost[n * 2 + end] is the cost from leaving by that end
+static void BuildField(const NavGraph* graph, NavField* field)
+{
+	int nodeCount = graph->stats.nodeCount;
+	if (field->nodeCapacity < nodeCount)
+	{
+		field->nodeCapacity = nodeCount;
+		field->exitCost = (int*)realloc(field->exitCost, 2 * nodeCount * sizeof(int));
+	}
+	field->goalNode = GlobalNodeAt(graph, field->goalX, field->goalY);
+	field->version = graph->version;
+	for (int s = 0; s < 2 * nodeCount; s++) field->exitCost[s] = -1;
+	if (field->goalNode < 0) return;
+
+	//flat node table and the exits landing on each node, grouped by landing node
+	const NavNode** nodes = (const NavNode**)malloc(nodeCount * sizeof(NavNode*));
+	int* landing = (int*)malloc(2 * nodeCount * sizeof(int));
+	int* predStart = (int*)calloc(nodeCount + 1, sizeof(int));
+	for (int t = 0, n = 0; t < graph->tilesX * graph->tilesY; t++)
+		for (int i = 0; i < graph->tiles[t].count; i++) nodes[n++] = &graph->tiles[t].nodes[i];
+
+	for (int s = 0; s < 2 * nodeCount; s++)
+	{
+		const NavExit* exit = &nodes[s >> 1]->exits[s & 1];
+		landing[s] = exit->kind == NAV_EXIT_NONE ? -1 : GlobalNodeAt(graph, exit->x, exit->y);
+		if (landing[s] >= 0) predStart[landing[s] + 1]++;
+	}
+	for (int n = 0; n < nodeCount; n++) predStart[n + 1] += predStart[n];
+
+	NavPred* preds = (NavPred*)malloc((predStart[nodeCount] + 1) * sizeof(NavPred));
+	int* fill = (int*)malloc(nodeCount * sizeof(int));
+	memcpy(fill, predStart, nodeCount * sizeof(int));
+	for (int s = 0; s < 2 * nodeCount; s++)
+		if (landing[s] >= 0) preds[fill[landing[s]]++] = { s, nodes[s >> 1]->exits[s & 1].x, nodes[s >> 1]->exits[s & 1].cost };
+
+	//an exit is pushed when seeded and at most once per popped end of its landing node
+	NavHeapEntry* heap = (NavHeapEntry*)malloc((3 * predStart[nodeCount] + 1) * sizeof(NavHeapEntry));
+	int heapSize = 0;
+	int* cost = field->exitCost;
+	int goal = field->goalNode;
+
+	for (int i = predStart[goal]; i < predStart[goal + 1]; i++)
+	{
+		int c = preds[i].cost + (preds[i].landingX > field->goalX ? preds[i].landingX - field->goalX : field->goalX - preds[i].landingX);
+		if (cost[preds[i].state] < 0 || c < cost[preds[i].state])
+		{
+			cost[preds[i].state] = c;
+			HeapPush(heap, &heapSize, c, preds[i].state);
+		}
+	}
+
+	while (heapSize > 0)
+	{
+		NavHeapEntry top = HeapPop(heap, &heapSize);
+		if (top.cost != cost[top.state]) continue;
+
+		//arriving on this node anywhere, then walking to this end and leaving by it
+		int node = top.state >> 1, end = top.state & 1;
+		if (node == goal) continue;
+		const NavNode* n = nodes[node];
+		for (int i = predStart[node]; i < predStart[node + 1]; i++)
+		{
+			int walk = end == 0 ? preds[i].landingX - n->x0 : n->x1 - preds[i].landingX;
+			int c = preds[i].cost + walk + top.cost;
+			if (cost[preds[i].state] < 0 || c < cost[preds[i].state])
+			{
+				cost[preds[i].state] = c;
+				HeapPush(heap, &heapSize, c, preds[i].state);
+			}
+		}
+	}
+
+	free(heap);
+	free(fill);
+	free(preds);
+	free(predStart);
+	free(landing);
+	free(nodes);
+}
+
+static NavStep StepFrom(const NavField* field, const NavNode* node, int index, int x)
+{
+	NavStep step = { 0, -1 };
+	if (index == field->goalNode)
+	{
+		step.direction = field->goalX > x ? 1 : (field->goalX < x ? -1 : 0);
+		step.cost = field->goalX > x ? field->goalX - x : x - field->goalX;
+		return step;
+	}
+
+	int left = field->exitCost[index * 2], right = field->exitCost[index * 2 + 1];
+	if (left >= 0) left += x - node->x0;
+	if (right >= 0) right += node->x1 - x;
+	if (left < 0 && right < 0) return step;
+
+	if (right < 0 || (left >= 0 && left <= right))
+	{
+		step.direction = -1;
+		step.cost = left;
+	}
+	else
+	{
+		step.direction = 1;
+		step.cost = right;
+	}
+	return step;
+}
+
+//----------------------------------------------------------------------------------
+// Nav Graph Functions Definition
+//----------------------------------------------------------------------------------
+void InitNavGraph(NavGraph* graph, const int* mask, int width, int height, NavParams params)
+{
+	graph->mask = mask;
+	graph->width = width;
+	graph->height = height;
+	graph->params = params;
+	graph->tilesX = (width + TERRAIN_TILE_SIZE - 1) / TERRAIN_TILE_SIZE;
+	graph->tilesY = (height + TERRAIN_TILE_SIZE - 1) / TERRAIN_TILE_SIZE;
+	graph->tiles = (NavTile*)calloc(graph->tilesX * graph->tilesY, sizeof(NavTile));
+	graph->tileFirst = (int*)calloc(graph->tilesX * graph->tilesY + 1, sizeof(int));
+	graph->version = 0;
+	memset(&graph->stats, 0, sizeof(NavStats));
+
+	for (int ty = 0; ty < graph->tilesY; ty++)
+		for (int tx = 0; tx < graph->tilesX; tx++) RebuildTile(graph, tx, ty);
+	RenumberTiles(graph);
+}
+
+void UnloadNavGraph(NavGraph* graph)
+{
+	for (int t = 0; t < graph->tilesX * graph->tilesY; t++)
+	{
+		free(graph->tiles[t].nodes);
+		free(graph->tiles[t].surface);
+	}
+	free(graph->tiles);
+	free(graph->tileFirst);
+	graph->tiles = nullptr;
+	graph->tileFirst = nullptr;
+}
+
+void UpdateNavGraph(NavGraph* graph, TerrainRect rect)
+{
+	graph->stats.tilesRebuilt = 0;
+	graph->stats.nodesRebuilt = 0;
+
+	//a point reads its own column up to clearance above it, and the next columns from
+	//climbHeight + clearance above to maxFall below
+	const NavParams* p = &graph->params;
+	int x0 = rect.x - 1, x1 = rect.x + rect.width + 1;
+	int y0 = rect.y - p->maxFall - 1, y1 = rect.y + rect.height + p->climbHeight + p->clearance + 1;
+
+	int tx0 = x0 < 0 ? 0 : x0 / TERRAIN_TILE_SIZE, ty0 = y0 < 0 ? 0 : y0 / TERRAIN_TILE_SIZE;
+	int tx1 = (x1 - 1) / TERRAIN_TILE_SIZE, ty1 = (y1 - 1) / TERRAIN_TILE_SIZE;
+	if (tx1 >= graph->tilesX) tx1 = graph->tilesX - 1;
+	if (ty1 >= graph->tilesY) ty1 = graph->tilesY - 1;
+
+	for (int ty = ty0; ty <= ty1; ty++)
+		for (int tx = tx0; tx <= tx1; tx++) RebuildTile(graph, tx, ty);
+	RenumberTiles(graph);
+}
+
+void OnTerrainChangedNav(const TerrainRect* rects, int count, unsigned int version, void* graph)
+{
+	NavGraph* g = (NavGraph*)graph;
+	int tiles = 0, nodes = 0;
+	for (int i = 0; i < count; i++)
+	{
+		UpdateNavGraph(g, rects[i]);
+		tiles += g->stats.tilesRebuilt;
+		nodes += g->stats.nodesRebuilt;
+	}
+
+	g->stats.tilesRebuilt = tiles;
+	g->stats.nodesRebuilt = nodes;
+}
+
+int FindNavNode(const NavGraph* graph, int x, int y)
+{
+	if ((unsigned int)x >= (unsigned int)graph->width) return -1;
+
+	//nearest surface row within stepHeight, it may sit in the tile above or below
+	int best = -1, bestDistance = graph->params.stepHeight + 1;
+	int tx = x / TERRAIN_TILE_SIZE;
+	int ty0 = y - graph->params.stepHeight, ty1 = y + graph->params.stepHeight;
+	ty0 = ty0 < 0 ? 0 : ty0 / TERRAIN_TILE_SIZE;
+	ty1 = ty1 >= graph->height ? graph->tilesY - 1 : ty1 / TERRAIN_TILE_SIZE;
+	for (int ty = ty0; ty <= ty1; ty++)
+	{
+		int t = ty * graph->tilesX + tx;
+		const NavTile* tile = &graph->tiles[t];
+		int column = x - tx * TERRAIN_TILE_SIZE;
+		for (int i = tile->columnStart[column]; i < tile->columnStart[column + 1]; i++)
+		{
+			int distance = tile->surface[i].y > y ? tile->surface[i].y - y : y - tile->surface[i].y;
+			if (distance < bestDistance)
+			{
+				bestDistance = distance;
+				best = graph->tileFirst[t] + tile->surface[i].node;
+			}
+		}
+	}
+	return best;
+}
+
+void InitNavCache(NavCache* cache, NavGraph* graph, int capacity)
+{
+	cache->graph = graph;
+	cache->capacity = capacity;
+	cache->fields = (NavField*)calloc(capacity, sizeof(NavField));
+	cache->clock = 0;
+	cache->hits = 0;
+	cache->misses = 0;
+}
+
+void UnloadNavCache(NavCache* cache)
+{
+	for (int i = 0; i < cache->capacity; i++) free(cache->fields[i].exitCost);
+	free(cache->fields);
+	cache->fields = nullptr;
+}
+
+const NavField* GetNavField(NavCache* cache, int x, int y)
+{
+	const NavGraph* graph = cache->graph;
+
+	//snap the goal to the first surface point at or below it
+	int goalY = y < 0 ? 0 : y;
+	if ((unsigned int)x < (unsigned int)graph->width)
+	{
+		int tx = x / TERRAIN_TILE_SIZE, column = x - tx * TERRAIN_TILE_SIZE;
+		int found = -1;
+		for (int ty = goalY / TERRAIN_TILE_SIZE; ty < graph->tilesY && found < 0; ty++)
+		{
+			const NavTile* tile = &graph->tiles[ty * graph->tilesX + tx];
+			for (int i = tile->columnStart[column]; i < tile->columnStart[column + 1]; i++)
+				if (tile->surface[i].y >= goalY)
+				{
+					found = tile->surface[i].y;
+					break;
+				}
+		}
+		if (found >= 0) goalY = found;
+	}
+
+	cache->clock++;
+	NavField* victim = &cache->fields[0];
+	for (int i = 0; i < cache->capacity; i++)
+	{
+		NavField* field = &cache->fields[i];
+		if (field->version == graph->version && field->goalX == x && field->goalY == goalY)
+		{
+			field->lastUse = cache->clock;
+			cache->hits++;
+			return field;
+		}
+		if (field->version == 0 || field->lastUse < victim->lastUse) victim = field;
+	}
+
+	cache->misses++;
+	victim->goalX = x;
+	victim->goalY = goalY;
+	victim->lastUse = cache->clock;
+	BuildField(graph, victim);
+	return victim;
+}
+
+void QueryNavSteps(const NavGraph* graph, const NavField* field, const int* xs, const int* ys, int count, NavStep* steps)
+{
+	for (int i = 0; i < count; i++)
+	{
+		int index = field->goalNode >= 0 ? FindNavNode(graph, xs[i], ys[i]) : -1;
+		if (index < 0)
+		{
+			steps[i] = { 0, -1 };
+			continue;
+		}
+		steps[i] = StepFrom(field, NodeByIndex(graph, index), index, xs[i]);
+	}
+}
+
+int GetNavPath(const NavGraph* graph, const NavField* field, int x, int y, int* pointsX, int* pointsY, int maxPoints)
+{
+	int index = field->goalNode >= 0 ? FindNavNode(graph, x, y) : -1;
+	if (index < 0 || maxPoints < 1) return 0;
+
+	int count = 0;
+	pointsX[count] = x;
+	pointsY[count++] = y;
+	while (count < maxPoints)
+	{
+		const NavNode* node = NodeByIndex(graph, index);
+		NavStep step = StepFrom(field, node, index, x);
+		if (step.cost < 0) return 0;
+		if (index == field->goalNode)
+		{
+			pointsX[count] = field->goalX;
+			pointsY[count++] = field->goalY;
+			return count;
+		}
+
+		//walk to the end, then take its exit
+		int end = step.direction < 0 ? 0 : 1;
+		int ex = end == 0 ? node->x0 : node->x1, ey = end == 0 ? node->y0 : node->y1;
+		if (ex != x)
+		{
+			pointsX[count] = ex;
+			pointsY[count++] = ey;
+			if (count == maxPoints) break;
+		}
+
+		const NavExit* exit = &node->exits[end];
+		pointsX[count] = x = exit->x;
+		pointsY[count++] = exit->y;
+		index = GlobalNodeAt(graph, exit->x, exit->y);
+		if (index < 0) return 0;
+	}
+
+	return count;
+}
@@ -0,0 +1,134 @@
+/*******************************************************************************************
+*
+*   Nav Graph - walkable surface runs of the terrain with cached, batched path queries
+*
+*   A surface point is a solid pixel with clearance empty rows above it, where a unit
+*   stands. Stepping one column left or right goes where the walker would: up the solid
+*   it runs into if that is no more than climbHeight, or down to the first solid below if
+*   that is no more than maxFall, blocked otherwise. Points joined by steps of at most
+*   stepHeight both ways form a node, cut at TERRAIN_TILE_SIZE tile borders; each end of a
+*   node has one exit, the step off it, kept as the point it lands on rather than a node
+*   id. A terrain change rebuilds only the tiles whose nodes or exits can see it, and
+*   nodes elsewhere never point at stale ids.
+*
+*   Paths come from fields: one reverse Dijkstra from a goal gives every node the cost of
+*   leaving by either end, and a unit's next direction is two adds and a compare. Fields
+*   are cached per goal and graph version, so any number of units going the same way pay
+*   for one search until the terrain changes.
+*
+********************************************************************************************/
+
+#ifndef NAV_GRAPH_H
+#define NAV_GRAPH_H
+
+#include "terrain_events.h"
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef enum NavExitKind {
+	NAV_EXIT_NONE = 0,              // Wall too high or drop too deep
+	NAV_EXIT_WALK,
+	NAV_EXIT_CLIMB,
+	NAV_EXIT_FALL
+} NavExitKind;
+
+typedef struct NavParams {
+	int stepHeight;                 // Walked over without a state change, up or down
+	int climbHeight;                // Highest wall an ascend gets over
+	int maxFall;                    // Deepest survivable drop
+	int clearance;                  // Empty rows needed above a surface point
+} NavParams;
+
+typedef struct NavExit {
+	NavExitKind kind;
+	int x, y;                       // Surface point it lands on
+	int cost;                       // 1 per column, plus the height climbed or dropped
+} NavExit;
+
+typedef struct NavNode {
+	int x0, y0;                     // Left end
+	int x1, y1;                     // Right end
+	NavExit exits[2];               // Off the left end, off the right end
+} NavNode;
+
+typedef struct NavSurface {
+	unsigned short y;
+	unsigned short node;            // Within the tile
+} NavSurface;
+
+typedef struct NavTile {
+	int count, capacity;
+	NavNode* nodes;
+	int columnStart[TERRAIN_TILE_SIZE + 1];     // Into surface, per column of the tile
+	int surfaceCapacity;
+	NavSurface* surface;            // Surface points in the tile's rows, by column then row
+} NavTile;
+
+typedef struct NavStats {
+	int tilesRebuilt;               // Last update
+	int nodesRebuilt;
+	int nodeCount;                  // Whole graph
+} NavStats;
+
+typedef struct NavGraph {
+	const int* mask;                // 1 = solid, not owned
+	int width, height;
+	NavParams params;
+
+	int tilesX, tilesY;
+	NavTile* tiles;
+	int* tileFirst;                 // Global index of each tile's first node, tile count + 1 entries
+	unsigned int version;           // Bumped by every update, fields older than it are rebuilt
+
+	NavStats stats;
+} NavGraph;
+
+typedef struct NavField {
+	int goalX, goalY;               // Surface point
+	unsigned int version;           // Graph version it was built on, 0 when unused
+	unsigned int lastUse;
+	int goalNode;                   // Global, -1 if the goal is not on a surface
+	int nodeCapacity;
+	int* exitCost;                  // Per node and end, cost from taking that exit to the goal, -1 if it never gets there
+} NavField;
+
+typedef struct NavCache {
+	NavGraph* graph;
+	int capacity;
+	NavField* fields;
+	unsigned int clock;
+
+	long hits, misses;
+} NavCache;
+
+typedef struct NavStep {
+	int direction;                  // -1 left, 1 right, 0 at the goal or no way there
+	int cost;                       // -1 if the goal can't be reached from here
+} NavStep;
+
+//----------------------------------------------------------------------------------
+// Nav Graph Functions Declaration
+//----------------------------------------------------------------------------------
+void InitNavGraph(NavGraph* graph, const int* mask, int width, int height, NavParams params);
+void UnloadNavGraph(NavGraph* graph);
+
+void UpdateNavGraph(NavGraph* graph, TerrainRect rect);     // Rebuild the tiles the change can reach
+void OnTerrainChangedNav(const TerrainRect* rects, int count, unsigned int version, void* graph);   // Terrain events subscriber
+
+// Global node under the unit at (x, y), within stepHeight of its row, -1 if none
+int FindNavNode(const NavGraph* graph, int x, int y);
+
+void InitNavCache(NavCache* cache, NavGraph* graph, int capacity);
+void UnloadNavCache(NavCache* cache);
+
+// Field towards the first surface point at or below (x, y), built or refreshed as needed
+const NavField* GetNavField(NavCache* cache, int x, int y);
+
+// Next direction and remaining cost for count units, one field serves them all
+void QueryNavSteps(const NavGraph* graph, const NavField* field, const int* xs, const int* ys, int count, NavStep* steps);
+
+// Corner points from (x, y) to the goal: node ends and landings, returns the count, 0 if unreachable
+int GetNavPath(const NavGraph* graph, const NavField* field, int x, int y, int* pointsX, int* pointsY, int maxPoints);
+
+#endif // NAV_GRAPH_H
@@ -0,0 +1,203 @@
+/*******************************************************************************************
+*
+*   Occupancy Pyramid - hierarchical empty-space skipping over the terrain mask
+*
+********************************************************************************************/
+
+#include "occupancy_pyramid.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition (local)
+//----------------------------------------------------------------------------------
+
+// Is the level cell holding pixel (x, y) occupied, level 0 reads the mask
+static inline bool CellSolid(OccupancyPyramid* p, int level, int x, int y)
+{
+	p->lookups++;
+	if (level == 0) return p->mask[y * p->width + x] != 0;
+	return p->levels[level][(y >> level) * p->levelWidth[level] + (x >> level)] != 0;
+}
+
+// Coarsest empty level around pixel (x, y), -1 if the pixel itself is solid
+static int EmptyLevelAt(OccupancyPyramid* p, int x, int y)
+{
+	int level = OCCUPANCY_LEVELS;
+	while (level >= 0 && CellSolid(p, level, x, y)) level--;
+	return level;
+}
+
+static void RebuildCells(OccupancyPyramid* p, int level, int cx0, int cy0, int cx1, int cy1)
+{
+	int lw = p->levelWidth[level];
+	int childW = level == 1 ? p->width : p->levelWidth[level - 1];
+	int childH = level == 1 ? p->height : p->levelHeight[level - 1];
+
+	for (int cy = cy0; cy <= cy1; cy++)
+		for (int cx = cx0; cx <= cx1; cx++)
+		{
+			unsigned char any = 0;
+			for (int y = cy * 2; y < cy * 2 + 2 && y < childH; y++)
+				for (int x = cx * 2; x < cx * 2 + 2 && x < childW; x++)
+				{
+					if (level == 1) any |= p->mask[y * childW + x] != 0;
+					else any |= p->levels[level - 1][y * childW + x];
+				}
+
+			p->levels[level][cy * lw + cx] = any;
+		}
+}
+
+static bool AnySolid(OccupancyPyramid* p, int level, int cx, int cy, int x0, int y0, int x1, int y1)
+{
+	int size = 1 << level;
+	int bx0 = cx * size, by0 = cy * size;
+	if (bx0 >= x1 || by0 >= y1 || bx0 + size <= x0 || by0 + size <= y0) return false;
+	if (!CellSolid(p, level, bx0, by0)) return false;
+	if (level == 0) return true;
+
+	for (int y = cy * 2; y < cy * 2 + 2; y++)
+		for (int x = cx * 2; x < cx * 2 + 2; x++)
+		{
+			if ((x << (level - 1)) >= p->width || (y << (level - 1)) >= p->height) continue;
+			if (AnySolid(p, level - 1, x, y, x0, y0, x1, y1)) return true;
+		}
+
+	return false;
+}
+
+//----------------------------------------------------------------------------------
+// Occupancy Pyramid Functions Definition
+//----------------------------------------------------------------------------------
+void InitOccupancyPyramid(OccupancyPyramid* pyramid, const int* mask, int width, int height)
+{
+	pyramid->mask = mask;
+	pyramid->width = width;
+	pyramid->height = height;
+	pyramid->lookups = 0;
+	pyramid->levels[0] = nullptr;
+
+	for (int level = 1; level <= OCCUPANCY_LEVELS; level++)
+	{
+		int size = 1 << level;
+		pyramid->levelWidth[level] = (width + size - 1) / size;
+		pyramid->levelHeight[level] = (height + size - 1) / size;
+		pyramid->levels[level] = (unsigned char*)calloc(pyramid->levelWidth[level] * pyramid->levelHeight[level], 1);
+	}
+
+	UpdateOccupancyPyramid(pyramid, { 0, 0, width, height });
+}
+
+void UnloadOccupancyPyramid(OccupancyPyramid* pyramid)
+{
+	for (int level = 1; level <= OCCUPANCY_LEVELS; level++) free(pyramid->levels[level]);
+	memset(pyramid, 0, sizeof(OccupancyPyramid));
+}
+
+void UpdateOccupancyPyramid(OccupancyPyramid* pyramid, TerrainRect rect)
+{
+	if (rect.width <= 0 || rect.height <= 0) return;
+
+	int x0 = rect.x, y0 = rect.y;
+	int x1 = rect.x + rect.width - 1, y1 = rect.y + rect.height - 1;
+
+	for (int level = 1; level <= OCCUPANCY_LEVELS; level++)
+		RebuildCells(pyramid, level, x0 >> level, y0 >> level, x1 >> level, y1 >> level);
+}
+
+void OnTerrainChangedPyramid(const TerrainRect* rects, int count, unsigned int version, void* pyramid)
+{
+	for (int i = 0; i < count; i++) UpdateOccupancyPyramid((OccupancyPyramid*)pyramid, rects[i]);
+}
+
+bool IsOccupancyAreaEmpty(OccupancyPyramid* pyramid, int x, int y, int width, int height)
+{
+	int x0 = x < 0 ? 0 : x, y0 = y < 0 ? 0 : y;
+	int x1 = x + width > pyramid->width ? pyramid->width : x + width;
+	int y1 = y + height > pyramid->height ? pyramid->height : y + height;
+	if (x0 >= x1 || y0 >= y1) return true;
+
+	const int top = OCCUPANCY_LEVELS;
+	for (int cy = y0 >> top; cy <= (y1 - 1) >> top; cy++)
+		for (int cx = x0 >> top; cx <= (x1 - 1) >> top; cx++)
+			if (AnySolid(pyramid, top, cx, cy, x0, y0, x1, y1)) return false;
+
+	return true;
+}
+
+bool RaycastOccupancy(OccupancyPyramid* pyramid, float x0, float y0, float x1, float y1, int* hitX, int* hitY)
+{
+	float dx = x1 - x0, dy = y1 - y0;
+	float tEnter = 0, tExit = 1;
+
+	//clip the segment to the map (Liang-Barsky)
+	float p[4] = { -dx, dx, -dy, dy };
+	float q[4] = { x0, pyramid->width - x0, y0, pyramid->height - y0 };
+	for (int i = 0; i < 4; i++)
+	{
+		if (p[i] == 0)
+		{
+			if (q[i] <= 0) return false;
+			continue;
+		}
+
+		float r = q[i] / p[i];
+		if (p[i] < 0 && r > tEnter) tEnter = r;
+		if (p[i] > 0 && r < tExit) tExit = r;
+	}
+	if (tEnter > tExit) return false;
+
+	float len = fabsf(dx) > fabsf(dy) ? fabsf(dx) : fabsf(dy);
+	float eps = len > 0 ? 1e-3f / len : 1;
+
+	float t = tEnter;
+	while (t <= tExit)
+	{
+		float x = x0 + dx * t, y = y0 + dy * t;
+		int px = (int)floorf(x), py = (int)floorf(y);
+		if (px >= pyramid->width) px = pyramid->width - 1;
+		if (py >= pyramid->height) py = pyramid->height - 1;
+		if (px < 0) px = 0;
+		if (py < 0) py = 0;
+
+		int level = EmptyLevelAt(pyramid, px, py);
+		if (level < 0)
+		{
+			*hitX = px;
+			*hitY = py;
+			return true;
+		}
+		if (len == 0) return false;
+
+		//skip to where the ray leaves the empty block
+		int size = 1 << level;
+		float bx0 = (float)((px >> level) << level), by0 = (float)((py >> level) << level);
+		float tx = dx > 0 ? (bx0 + size - x0) / dx : dx < 0 ? (bx0 - x0) / dx : 2.0f;
+		float ty = dy > 0 ? (by0 + size - y0) / dy : dy < 0 ? (by0 - y0) / dy : 2.0f;
+		float next = (tx < ty ? tx : ty) + eps;
+
+		t = next > t ? next : t + eps;
+	}
+
+	return false;
+}
+
+int FindOccupancyBelow(OccupancyPyramid* pyramid, int x, int y, int maxDistance)
+{
+	if (x < 0 || x >= pyramid->width) return -1;
+	if (y < 0) y = 0;
+
+	int yy = y;
+	while (yy < pyramid->height && yy - y <= maxDistance)
+	{
+		int level = EmptyLevelAt(pyramid, x, yy);
+		if (level < 0) return yy - y;
+
+		yy = ((yy >> level) + 1) << level;
+	}
+
+	return -1;
+}
@@ -0,0 +1,50 @@
+/*******************************************************************************************
+*
+*   Occupancy Pyramid - hierarchical empty-space skipping over the terrain mask
+*
+*   Level 0 is the terrain mask itself. Each level above records whether any cell of the
+*   2x2 block below it is solid, up to OCCUPANCY_LEVELS (64x64 pixel blocks). Queries walk
+*   down only into occupied blocks, so crossing open sky costs a handful of lookups.
+*
+********************************************************************************************/
+
+#ifndef OCCUPANCY_PYRAMID_H
+#define OCCUPANCY_PYRAMID_H
+
+#include "terrain_events.h"
+
+#define OCCUPANCY_LEVELS                 6      // Coarsest level covers 2^6 = 64 pixel blocks
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct OccupancyPyramid {
+	const int* mask;                            // Level 0, not owned
+	int width, height;
+
+	unsigned char* levels[OCCUPANCY_LEVELS + 1];  // [1..OCCUPANCY_LEVELS], 1 if any pixel below is solid
+	int levelWidth[OCCUPANCY_LEVELS + 1];
+	int levelHeight[OCCUPANCY_LEVELS + 1];
+
+	long lookups;                               // Cell reads made by queries, for profiling
+} OccupancyPyramid;
+
+//----------------------------------------------------------------------------------
+// Occupancy Pyramid Functions Declaration
+//----------------------------------------------------------------------------------
+void InitOccupancyPyramid(OccupancyPyramid* pyramid, const int* mask, int width, int height);
+void UnloadOccupancyPyramid(OccupancyPyramid* pyramid);
+
+// Rebuild the cells over a dirty rect and their ancestors only
+void UpdateOccupancyPyramid(OccupancyPyramid* pyramid, TerrainRect rect);
+void OnTerrainChangedPyramid(const TerrainRect* rects, int count, unsigned int version, void* pyramid);   // Terrain events subscriber
+
+bool IsOccupancyAreaEmpty(OccupancyPyramid* pyramid, int x, int y, int width, int height);
+
+// First solid pixel on the segment (x0, y0) -> (x1, y1), false if the segment is clear
+bool RaycastOccupancy(OccupancyPyramid* pyramid, float x0, float y0, float x1, float y1, int* hitX, int* hitY);
+
+// Distance down from (x, y) to the first solid pixel in the column, -1 if none within maxDistance
+int FindOccupancyBelow(OccupancyPyramid* pyramid, int x, int y, int maxDistance);
+
+#endif // OCCUPANCY_PYRAMID_H
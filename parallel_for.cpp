@@ -0,0 +1,99 @@
+/*******************************************************************************************
+*
+*   Parallel For - row bands and tile ranges of a pass spread over the thread pool
+*
+********************************************************************************************/
+
+#include "parallel_for.h"
+#include "thread_pool.h"
+
+#include <atomic>
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct ParallelPass {
+	ParallelRangeFunc func;
+	void* userData;
+	int count;
+	int grain;
+	int chunks;
+	std::atomic<int> nextChunk;
+} ParallelPass;
+
+typedef struct TilePass {
+	ParallelTileFunc func;
+	void* userData;
+	int width, height;
+	int tileSize;
+	int tilesX;
+} TilePass;
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition (local)
+//----------------------------------------------------------------------------------
+static void RunChunks(void* data)
+{
+	ParallelPass* pass = (ParallelPass*)data;
+	for (;;)
+	{
+		int chunk = pass->nextChunk.fetch_add(1, std::memory_order_relaxed);
+		if (chunk >= pass->chunks) return;
+
+		int begin = chunk * pass->grain;
+		int end = begin + pass->grain < pass->count ? begin + pass->grain : pass->count;
+		pass->func(begin, end, pass->userData);
+	}
+}
+
+static void RunTiles(int begin, int end, void* data)
+{
+	TilePass* pass = (TilePass*)data;
+	for (int t = begin; t < end; t++)
+	{
+		int x0 = (t % pass->tilesX) * pass->tileSize, y0 = (t / pass->tilesX) * pass->tileSize;
+		int x1 = x0 + pass->tileSize < pass->width ? x0 + pass->tileSize : pass->width;
+		int y1 = y0 + pass->tileSize < pass->height ? y0 + pass->tileSize : pass->height;
+		pass->func(x0, y0, x1, y1, pass->userData);
+	}
+}
+
+//----------------------------------------------------------------------------------
+// Parallel For Functions Definition
+//----------------------------------------------------------------------------------
+void ParallelFor(int count, int grain, ParallelRangeFunc func, void* userData)
+{
+	if (count <= 0) return;
+	if (grain < 1) grain = 1;
+
+	ParallelPass pass;
+	pass.func = func;
+	pass.userData = userData;
+	pass.count = count;
+	pass.grain = grain;
+	pass.chunks = (count + grain - 1) / grain;
+	pass.nextChunk.store(0);
+
+	//one helper per worker at most, the caller pulls chunks too
+	int helpers = GetThreadPoolWorkers();
+	if (helpers > pass.chunks - 1) helpers = pass.chunks - 1;
+
+	PoolTaskGroup group;
+	group.pending.store(0);
+	for (int i = 0; i < helpers; i++) SubmitPoolTask(RunChunks, &pass, &group);
+
+	RunChunks(&pass);
+	if (helpers > 0) WaitPoolTasks(&group);
+}
+
+void ParallelForRows(int height, int bandRows, ParallelRangeFunc func, void* userData)
+{
+	ParallelFor(height, bandRows, func, userData);
+}
+
+void ParallelForTiles(int width, int height, int tileSize, ParallelTileFunc func, void* userData)
+{
+	TilePass pass = { func, userData, width, height, tileSize, (width + tileSize - 1) / tileSize };
+	int tilesY = (height + tileSize - 1) / tileSize;
+	ParallelFor(pass.tilesX * tilesY, 1, RunTiles, &pass);
+}
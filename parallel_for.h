@@ -0,0 +1,31 @@
+/*******************************************************************************************
+*
+*   Parallel For - row bands and tile ranges of a pass spread over the thread pool
+*
+*   The range is cut into fixed chunks (grain items, row bands or tiles) that depend only on
+*   the sizes passed in, never on the thread count, so a pass whose chunks write disjoint
+*   output gives the same bytes on any machine. Workers and the calling thread pull chunks
+*   until none are left; the call returns when every chunk is done. Without pool workers
+*   the chunks run in order on the caller.
+*
+********************************************************************************************/
+
+#ifndef PARALLEL_FOR_H
+#define PARALLEL_FOR_H
+
+#define PARALLEL_ROW_BAND                32     // Default rows per band for full-map passes
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef void (*ParallelRangeFunc)(int begin, int end, void* userData);                 // [begin, end)
+typedef void (*ParallelTileFunc)(int x0, int y0, int x1, int y1, void* userData);       // [x0, x1) x [y0, y1)
+
+//----------------------------------------------------------------------------------
+// Parallel For Functions Declaration
+//----------------------------------------------------------------------------------
+void ParallelFor(int count, int grain, ParallelRangeFunc func, void* userData);
+void ParallelForRows(int height, int bandRows, ParallelRangeFunc func, void* userData);    // Bands of bandRows rows
+void ParallelForTiles(int width, int height, int tileSize, ParallelTileFunc func, void* userData);
+
+#endif // PARALLEL_FOR_H
@@ -0,0 +1,143 @@
+/*******************************************************************************************
+*
+*   Pixel Mask - packed bit masks for pixel-perfect sprite overlap tests
+*
+********************************************************************************************/
+
+#include "pixel_mask.h"
+
+#include <stdlib.h>
+#include <math.h>
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition (local)
+//----------------------------------------------------------------------------------
+static void AllocPixelMask(PixelMask* mask, int width, int height, int originX, int originY)
+{
+	mask->width = width;
+	mask->height = height;
+	mask->wordsPerRow = (width + 63) / 64;
+	mask->bits = (unsigned long long*)calloc((size_t)mask->wordsPerRow * height, sizeof(unsigned long long));
+	mask->originX = originX;
+	mask->originY = originY;
+}
+
+static inline void SetMaskBit(PixelMask* mask, int x, int y)
+{
+	mask->bits[y * mask->wordsPerRow + (x >> 6)] |= 1ull << (x & 63);
+}
+
+// 64 bits of a row starting at pixel offset, zero outside the row
+static inline unsigned long long ReadRowBits(const unsigned long long* row, int words, int offset)
+{
+	int w = offset >= 0 ? offset / 64 : (offset - 63) / 64;
+	int shift = offset - w * 64;
+
+	unsigned long long lo = (w >= 0 && w < words) ? row[w] : 0;
+	if (shift == 0) return lo;
+
+	unsigned long long hi = (w + 1 >= 0 && w + 1 < words) ? row[w + 1] : 0;
+	return (lo >> shift) | (hi << (64 - shift));
+}
+
+//----------------------------------------------------------------------------------
+// Pixel Mask Functions Definition
+//----------------------------------------------------------------------------------
+void BuildPixelMask(PixelMask* mask, const unsigned char* rgba, int width, int height, unsigned char alphaThreshold, int originX, int originY)
+{
+	AllocPixelMask(mask, width, height, originX, originY);
+
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			if (rgba[(y * width + x) * 4 + 3] > alphaThreshold) SetMaskBit(mask, x, y);
+}
+
+void BuildRotatedPixelMask(PixelMask* mask, const unsigned char* rgba, int width, int height, unsigned char alphaThreshold,
+	float originX, float originY, float degrees)
+{
+	//rotation matches DrawTexturePro: clockwise on screen for positive angles
+	float c = cosf(degrees * 3.14159265f / 180.0f);
+	float s = sinf(degrees * 3.14159265f / 180.0f);
+
+	float cornersX[4] = { -originX, width - originX, -originX, width - originX };
+	float cornersY[4] = { -originY, -originY, height - originY, height - originY };
+	float minX = 1e9f, minY = 1e9f, maxX = -1e9f, maxY = -1e9f;
+	for (int i = 0; i < 4; i++)
+	{
+		float rx = cornersX[i] * c - cornersY[i] * s;
+		float ry = cornersX[i] * s + cornersY[i] * c;
+		minX = fminf(minX, rx); maxX = fmaxf(maxX, rx);
+		minY = fminf(minY, ry); maxY = fmaxf(maxY, ry);
+	}
+
+	int left = (int)floorf(minX), top = (int)floorf(minY);
+	AllocPixelMask(mask, (int)ceilf(maxX) - left, (int)ceilf(maxY) - top, -left, -top);
+
+	for (int y = 0; y < mask->height; y++)
+		for (int x = 0; x < mask->width; x++)
+		{
+			float px = x + left + 0.5f;
+			float py = y + top + 0.5f;
+			int sx = (int)floorf(px * c + py * s + originX);
+			int sy = (int)floorf(-px * s + py * c + originY);
+
+			if (sx < 0 || sy < 0 || sx >= width || sy >= height) continue;
+			if (rgba[(sy * width + sx) * 4 + 3] > alphaThreshold) SetMaskBit(mask, x, y);
+		}
+}
+
+void BuildCirclePixelMask(PixelMask* mask, int radius)
+{
+	AllocPixelMask(mask, radius * 2 + 1, radius * 2 + 1, radius, radius);
+
+	for (int y = -radius; y <= radius; y++)
+		for (int x = -radius; x <= radius; x++)
+			if (x * x + y * y <= radius * radius) SetMaskBit(mask, x + radius, y + radius);
+}
+
+void UnloadPixelMask(PixelMask* mask)
+{
+	free(mask->bits);
+	mask->bits = nullptr;
+	mask->width = mask->height = mask->wordsPerRow = 0;
+}
+
+bool PixelMasksOverlap(const PixelMask* a, int ax, int ay, const PixelMask* b, int bx, int by)
+{
+	int aLeft = ax - a->originX, aTop = ay - a->originY;
+	int bLeft = bx - b->originX, bTop = by - b->originY;
+
+	int x0 = aLeft > bLeft ? aLeft : bLeft;
+	int y0 = aTop > bTop ? aTop : bTop;
+	int x1 = aLeft + a->width < bLeft + b->width ? aLeft + a->width : bLeft + b->width;
+	int y1 = aTop + a->height < bTop + b->height ? aTop + a->height : bTop + b->height;
+	if (x0 >= x1 || y0 >= y1) return false;
+
+	//walk b's words over the overlap, pulling the matching 64 pixels of a into alignment
+	int dx = bLeft - aLeft;
+	int w0 = (x0 - bLeft) >> 6;
+	int w1 = (x1 - bLeft - 1) >> 6;
+
+	for (int y = y0; y < y1; y++)
+	{
+		const unsigned long long* rowA = a->bits + (y - aTop) * a->wordsPerRow;
+		const unsigned long long* rowB = b->bits + (y - bTop) * b->wordsPerRow;
+
+		for (int w = w0; w <= w1; w++)
+			if (rowB[w] & ReadRowBits(rowA, a->wordsPerRow, w * 64 + dx)) return true;
+	}
+
+	return false;
+}
+
+int TestPixelMaskPairs(const PixelMaskTest* tests, int count, bool* hits)
+{
+	int total = 0;
+	for (int i = 0; i < count; i++)
+	{
+		hits[i] = PixelMasksOverlap(tests[i].a, tests[i].ax, tests[i].ay, tests[i].b, tests[i].bx, tests[i].by);
+		total += hits[i];
+	}
+
+	return total;
+}
@@ -14,12 +14,39 @@
 
 #include "raylib.h"
 #include "raymath.h"
+#include "rlgl.h"
 #include "screens.h"    // NOTE: Declares global (extern) variables and screens functions
+#include "terrain_events.h"
+#include "debris.h"
+#include "spatial_hash.h"
+#include "occupancy_pyramid.h"
+#include "terrain_sdf.h"
+#include "terrain_normals.h"
+#include "terrain_gen.h"
+#include "terrain_tiles.h"
+#include "pixel_mask.h"
+#include "telemetry.h"
+#include "sprite_batch.h"
+#include "fixed_physics.h"
+#include "carve_queue.h"
+#include "terrain_material.h"
+#include "trajectory_cache.h"
+#include "asset_preload.h"
+#include "thread_pool.h"
+#include "job_scheduler.h"
+#include "parallel_for.h"
+#include "match_checkpoint.h"
+#include "terrain_store.h"
+#include "terrain_contours.h"
+#include "nav_graph.h"
+#include "team_vision.h"
+#include "terrain_density.h"
 
 #if defined(PLATFORM_WEB)
     #include <emscripten/emscripten.h>
 #endif
 #include <math.h>
+#include <string.h>
 #include <utils.h>
 enum playerAction { WALKING = 1, FALLING = 2, ASCENDING = 3, STANDING = 4, DEAD = 5 };
 
@@ -28,6 +55,11 @@ typedef struct Ball {
 	Vector2 speed;
 	int radius;
 	bool active;
+	bool armed;                     // Cleared the firing tank, can now hit tanks
+	int bounces;
+
+	fixed fx, fy;                   // Q16.16 state in fixed physics mode, position and speed mirror it
+	fixed fvx, fvy;
 } Ball;
 
 typedef struct Player {
@@ -54,24 +86,72 @@ typedef struct Player {
 	int Ascended;
 	int Fallen;
 	int TrueFallen;
+
+	float tilt;                     // Degrees, follows the ground normal
 } Player;
 
+// Everything besides the terrain a checkpoint needs to resume the match
+typedef struct MatchState {
+	Player player;
+	Ball ball;
+	bool ballOnAir;
+	unsigned int tickCount;
+} MatchState;
+
+typedef struct AlphaMaskPass {
+	const Color* cols;
+	int* mask;                      // 1 where alpha > 0
+	int width;
+	int size;
+} AlphaMaskPass;
+
 #define GRAVITY                       9.81f
 #define DELTA_FPS                        60
 const int MAXFALLDISTANCE = 62;
+const float TANKRADIUS = 23;           // Encloses the sprite at any tilt, the pixel masks decide real hits
+const int MAXBOUNCES = 2;
+const float RICOCHETCOS = 0.35f;        // Hits shallower than ~20 degrees to the surface bounce
+const float RESTITUTION = 0.6f;
+const fixed FIXEDGRAVITY = 10715;       // GRAVITY / DELTA_FPS in Q16.16
+const fixed FIXEDRESTITUTION = 39322;   // RESTITUTION in Q16.16
+const fixed FIXEDRICOCHETCOS = 22938;   // RICOCHETCOS in Q16.16
+const int TANKMASKSTEP = 5;            // Degrees between prebuilt rotated tank masks
+const int TANKMASKANGLES = 19;         // -45..45
+const unsigned int MAPSEED = 0;         // Non-zero plays a generated map instead of demoBg.png
+const bool TELEMETRYON = true;          // Record every tick to telemetry.tlm, see telemetry_dump
+const int BLASTDAMAGE = 4;              // Hardness a shell takes off: dirt goes in one, rock takes two
+const int DIRTDEPTH = 48;               // Rows of dirt under the surface, rock below
+const int BEDROCKROWS = 6;              // Indestructible floor
+const double CHECKPOINTSECONDS = 5;     // Autosave interval, F9 goes back to the last one
+const TerrainBackend MAPBACKEND = TERRAIN_BACKEND_DENSE;    // Terrain behind HasPixelAt and the ground probe, TERRAIN_BACKEND_COLUMNS for maps that drop the dense mask
+const NavParams NAVPARAMS = { 3, 4, MAXFALLDISTANCE, 1 };   // handleWalking steps, handleAscending climbs, handleFalling drops
+const int VISIONRADIUS = 160;           // How far a tank sees, F7 shows the fog past it
+const int SDFSLICEROWS = 64;            // Dirty rows the distance field refreshes per job slice
+const char* const ATLASPATH = "resources/atlas.png";  // Built by "make atlas", decoded in the background during setup()
 
 int fIteration = 0;
 int fClockFrame = 0;
+unsigned int tickCount = 0;
+int tickCarves = 0;
 
 Vector2 camStart = { 342,388 };
 Camera2D mainCam = { 0 };
 
 Image imgBg;
-Texture texBg;
+TerrainTiles terrainTiles = { 0 };
+Texture* tileTextures = nullptr;
 int* maskBg = nullptr;
 
 Image imgCn;
-Texture texCn;
+PixelMask tankMasks[TANKMASKANGLES] = { 0 };
+PixelMask ballMask = { 0 };
+
+SpriteAtlas atlas = { 0 };
+Texture texAtlas;
+SpriteBatch spriteBatch = { 0 };
+const AtlasSprite* sprCannon = nullptr;
+const AtlasSprite* sprShell = nullptr;
+const AtlasSprite* sprPixel = nullptr;       // Solid white, for particles and flat shapes
 
 Image imgBomb;
 int* maskBomb = nullptr;
@@ -83,9 +163,40 @@ int Size = 0;
 int bombWidth = 0;
 int bombHeight = 0;
 int bombSize = 0;
-
-
-int imgInvalid = 0;
+CarveStamp bombStamp = { 0 };
+CarveQueue carveQueue = { 0 };  // Impacts of a tick, carved together
+TerrainMaterials terrainMaterials = { 0 };  // Hardness per pixel, blasts wear it down
+
+
+Color* texScratch = nullptr;     // Staging for tile texture uploads
+
+DebrisPool debris = { 0 };
+SpatialHash broadphase = { 0 };
+OccupancyPyramid occupancy = { 0 };
+TerrainStore terrainStore = { };    // MAPBACKEND view of maskBg behind HasPixelAt and batched ground probes
+TerrainContours terrainContours = { 0 };    // Vector outline of maskBg, kept up per dirty tile
+ContourSegment contourView[16384];      // Outline segments under the camera
+bool showContours = false;      // F8, draw the terrain outline
+NavGraph navGraph = { 0 };      // Walkable surface of maskBg, repaired per dirty tile
+NavCache navCache = { 0 };      // Path fields per goal
+Vector2 navGoal = { -1, -1 };   // G puts it under the mouse, the tank walks there
+TeamVision teamVision = { 0 };  // What each team sees of maskBg, the player is on team 0
+int playerEye = -1;
+bool showFog = false;           // F7, darken what the player's team can't see
+TerrainDensity terrainDensity = { 0 };  // Solid pixel counts of any rect of maskBg in O(1), cutBombMask skips empty blasts with it
+TrajectoryCache trajectoryCache = { 0 };    // Impact preview while aiming
+
+bool fixedPhysics = true;       // Integer-only shell flight, same bits on every build
+bool sdfEnabled = true;         // Optional distance field, shells sphere-trace it when on
+TerrainSdf terrainSdf = { 0 };
+TerrainRect sdfPending[64];     // Carved since the field was last refreshed
+int sdfPendingCount = 0;
+int sdfJob = -1;
+TerrainNormalCache normalCache = { 0 };
+MatchCheckpoint matchCheckpoint = { 0 };    // Terrain delta against the map as loaded
+unsigned char* lastCheckpoint = nullptr;
+int lastCheckpointSize = 0;
+double lastCheckpointTime = 0;
 
 Vector2 cannonPos = { 334,288 };
 float cannonAngle = 0;
@@ -98,25 +209,49 @@ static bool ballOnAir = false;
 void setup();
 void setupBGMask();
 void setupBombMask();
+void setupMaterials();
+void maskFromAlphaRows(int y0, int y1, void* userData);
+void shadeMaterialTile(int x0, int y0, int x1, int y1, void* userData);
+void setupAtlas();
+bool updateAtlasPreload();
+void drawAtlasPlaceholder();
+void flushSprites(SpriteLayer layer, const SpriteVertex* vertices, int vertexCount, void* userData);
 
 void render();
 
-void CheckAndUpdateTexture();
+void blankCarvedPixels(const TerrainRect* rects, int count, unsigned int version, void* userData);
+void blankCarvedRows(int begin, int end, void* userData);
+void deferSdfRefresh(const TerrainRect* rects, int count, unsigned int version, void* userData);
+JobStatus refreshSdfSlice(void* userData);
+void uploadTerrainTile(int tile, TerrainRect rect, void* userData);
+void drawTerrainTile(int tile, TerrainRect rect, void* userData);
 bool updatePlayer(Vector2& thisPos);
 void handlelogic(Vector2& thisPos);
 void handleInput(Vector2& thisPos);
 void handleWalking();
+void steerToGoal();
 void handleFalling();
 void handleAscending();
 void handleStanding();
 void handlePlayerMovt();
+void updateTilt();
 void transitionState(enum playerAction newState, bool turnAround = false);
 void TurnAround() { player.movement.x = -player.movement.x; }
 bool updateBall();
+void launchFixedBall();
+void aimVelocity(Vector2 point, fixed* vx, fixed* vy);
+void previewImpact();
+void saveCheckpoint();
+void restoreCheckpoint();
+void drawContours(Vector2 viewMin, Vector2 viewMax);
+void drawFog(Vector2 viewMin, Vector2 viewMax);
+void updateBroadphase();
+int testTankHits();
 int  main(void);
 
 void cutPx(int x, int y);
 void cutBombMask(int cx, int cy);
+void emitCarvedDebris(int x, int y, int carve, void* userData);
 int HasPixelAt(int x, int y);
 
 int findGroundPixel(int x, int y);
@@ -131,6 +266,11 @@ int  main(void)
 #else
 	while (!WindowShouldClose())
 		render();
+
+	StopTelemetry();
+	UnloadPreloadedAssets();
+	UnloadJobScheduler();
+	ShutdownThreadPool();
 #endif 
 }
 
@@ -143,19 +283,77 @@ void setup()
 	mainCam.zoom = 1;
 	mainCam.rotation = 0;
 
+	if (TELEMETRYON) StartTelemetry("telemetry.tlm");
+	InitThreadPool(-1);
+	InitJobScheduler();
 
-	imgBg = LoadImage("resources/demoBg.png");
+	//the packed atlas decodes on the preload worker while the terrain below is set up
+	const char* preloads[] = { ATLASPATH };
+	if (FileExists(ATLASPATH)) RequestAssetPreload(preloads, 1);
+
+	if (MAPSEED != 0)
+	{
+		TerrainGenParams gen = DefaultTerrainGenParams(MAPSEED, 1024, 768);
+		imgBg = GenImageColor(gen.width, gen.height, BLANK);
+		GenerateTerrain(&gen, (unsigned char*)imgBg.data, nullptr);
+	}
+	else imgBg = LoadImage("resources/demoBg.png");
 	ImageFormat(&imgBg, PixelFormat::PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
-	texBg = LoadTextureFromImage(imgBg);
 	Width = imgBg.width;
 	Height = imgBg.height;
 	Size = Width * Height;
 
 	setupBGMask();
+	setupMaterials();
+
+	texScratch = (Color*)calloc(TERRAIN_TEXTURE_TILE_SIZE * TERRAIN_TEXTURE_TILE_SIZE, sizeof(Color));
+	InitTerrainEvents(Width, Height);
+	SubscribeTerrainChanges(blankCarvedPixels, nullptr);
+
+	InitMatchCheckpoint(&matchCheckpoint, maskBg, (unsigned int*)imgBg.data, &terrainMaterials, Width, Height);
+	SubscribeTerrainChanges(OnTerrainChangedCheckpoint, &matchCheckpoint);
+
+	InitTerrainTiles(&terrainTiles, Width, Height, { uploadTerrainTile, drawTerrainTile, nullptr });
+	tileTextures = (Texture*)calloc(terrainTiles.tilesX * terrainTiles.tilesY, sizeof(Texture));
+	SubscribeTerrainChanges(OnTerrainChangedTiles, &terrainTiles);
+
+	InitTerrainStore(&terrainStore, MAPBACKEND, maskBg, Width, Height);
+	SubscribeTerrainChanges(OnTerrainChangedStore, &terrainStore);
+
+	InitTerrainContours(&terrainContours, maskBg, Width, Height);
+	SubscribeTerrainChanges(OnTerrainChangedContours, &terrainContours);
+
+	InitNavGraph(&navGraph, maskBg, Width, Height, NAVPARAMS);
+	SubscribeTerrainChanges(OnTerrainChangedNav, &navGraph);
+	InitNavCache(&navCache, &navGraph, 4);
+
+	InitTeamVision(&teamVision, maskBg, Width, Height, 2, VISIONRADIUS, 16);
+	SubscribeTerrainChanges(OnTerrainChangedVision, &teamVision);
+	playerEye = AddVisionUnit(&teamVision, 0, (int)player.position.x, (int)player.position.y);
+
+	InitTerrainDensity(&terrainDensity, maskBg, Width, Height);
+	SubscribeTerrainChanges(OnTerrainChangedDensity, &terrainDensity);
+
+	InitOccupancyPyramid(&occupancy, maskBg, Width, Height);
+	SubscribeTerrainChanges(OnTerrainChangedPyramid, &occupancy);
+	InitTrajectoryCache(&trajectoryCache, &occupancy, 256);
+
+	InitTerrainNormalCache(&normalCache, maskBg, Width, Height);
+
+	if (sdfEnabled)
+	{
+		InitTerrainSdf(&terrainSdf, maskBg, Width, Height);
+		SubscribeTerrainChanges(deferSdfRefresh, nullptr);
+	}
 
 	imgCn = LoadImage("resources/cannon.png");
 	ImageFormat(&imgCn, PixelFormat::PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
 
+	//hit masks come from the same pixels the tank is drawn with, pivoting where DrawTexturePro does
+	for (int i = 0; i < TANKMASKANGLES; i++)
+		BuildRotatedPixelMask(&tankMasks[i], (unsigned char*)imgCn.data, imgCn.width, imgCn.height, 0,
+			imgCn.width / 2.0f, (float)imgCn.height, (i - TANKMASKANGLES / 2) * TANKMASKSTEP);
+
 
 	imgBomb = LoadImage("resources/bombmask.png");
 
@@ -163,12 +361,17 @@ void setup()
 	bombWidth = imgBomb.width;
 	bombSize = bombHeight * bombWidth;
 	setupBombMask();
+	BuildCarveStamp(&bombStamp, maskBomb, bombWidth, bombHeight);
+	InitCarveQueue(&carveQueue, Width, Height, 1024);
+	SetCarveMaterials(&carveQueue, &terrainMaterials, BLASTDAMAGE);
 
 	UnloadImage(imgBomb);
 
+	InitDebrisPool(&debris, DEBRIS_MAX_PARTICLES);
+	InitSpatialHash(&broadphase, 64, 256);
 
-	texCn = LoadTextureFromImage(imgCn);
 	UnloadImage(imgCn);
+	setupAtlas();
 
 
 
@@ -199,86 +402,166 @@ void setup()
 	player.TrueFallen = 0;
 	transitionState(WALKING);
 	ball.radius = 10;
+	BuildCirclePixelMask(&ballMask, ball.radius);
 	ballOnAir = false;
 	ball.active = false;
 
 
 
 }
-void CheckAndUpdateTexture()
+// Terrain change subscriber: carved pixels go transparent in the image, tiles re-upload when next drawn
+void blankCarvedPixels(const TerrainRect* rects, int count, unsigned int version, void* userData)
 {
-
-	if (imgInvalid)
+	for (int i = 0; i < count; i++)
 	{
-		Color* pxImg = LoadImageColors(imgBg);
-
-
-		UpdateTexture(texBg, pxImg);
+		TerrainRect r = rects[i];
+		ParallelForRows(r.height, PARALLEL_ROW_BAND, blankCarvedRows, &r);
+	}
+}
+void blankCarvedRows(int begin, int end, void* userData)
+{
+	const TerrainRect* r = (const TerrainRect*)userData;
+	Color* pxBg = (Color*)imgBg.data;
 
-		//can optimize this for just localised changes
-		for (int y = 0; y < Height; y++)
+	for (int y = r->y + begin; y < r->y + end; y++)
+		for (int x = r->x; x < r->x + r->width; x++)
 		{
-
-			for (int x = 0; x < Width; x++)
-			{
-
-				int ix = y * Width + x;
-
-				if (ix >= Size || ix <= 0) continue;
-
-				if (maskBg[ix] == 0)
-				{
-					pxImg[ix] = BLANK;
-
-
-				}
-
-			}
+			int ix = y * Width + x;
+			if (maskBg[ix] == 0) pxBg[ix] = BLANK;
 		}
+}
+// Terrain change subscriber: the distance field catches up in the frame's job budget, shells raycast until then
+void deferSdfRefresh(const TerrainRect* rects, int count, unsigned int version, void* userData)
+{
+	for (int i = 0; i < count; i++)
+	{
+		if (sdfPendingCount < 64) sdfPending[sdfPendingCount++] = rects[i];
+		else
+		{
+			//out of room, grow the last rect over this one
+			TerrainRect* last = &sdfPending[63];
+			TerrainRect r = rects[i];
+			int x1 = last->x + last->width > r.x + r.width ? last->x + last->width : r.x + r.width;
+			int y1 = last->y + last->height > r.y + r.height ? last->y + last->height : r.y + r.height;
+			if (r.x < last->x) last->x = r.x;
+			if (r.y < last->y) last->y = r.y;
+			last->width = x1 - last->x;
+			last->height = y1 - last->y;
+		}
+	}
 
-		UpdateTexture(texBg, pxImg);
-		UnloadImage(imgBg);
-		imgBg = LoadImageFromTexture(texBg);
-
-		UnloadImageColors(pxImg);
-
+	if (!IsJobPending(sdfJob)) sdfJob = SubmitJob("sdf refresh", refreshSdfSlice, nullptr, JOB_PRIORITY_NORMAL, false);
+}
+// A band of SDFSLICEROWS rows of the newest dirty rect per slice, however large a merged rect grows
+JobStatus refreshSdfSlice(void* userData)
+{
+	if (sdfPendingCount > 0)
+	{
+		TerrainRect* rect = &sdfPending[sdfPendingCount - 1];
+		TerrainRect band = { rect->x, rect->y, rect->width, rect->height < SDFSLICEROWS ? rect->height : SDFSLICEROWS };
+		UpdateTerrainSdf(&terrainSdf, band);
+
+		//the rest of the rect stays queued for the next slice
+		rect->y += band.height;
+		rect->height -= band.height;
+		if (rect->height <= 0) sdfPendingCount--;
+	}
+	return sdfPendingCount > 0 ? JOB_YIELD : JOB_DONE;
+}
+void uploadTerrainTile(int tile, TerrainRect rect, void* userData)
+{
+	Color* pxBg = (Color*)imgBg.data;
+	for (int y = 0; y < rect.height; y++)
+		memcpy(texScratch + y * rect.width, pxBg + (rect.y + y) * Width + rect.x, rect.width * sizeof(Color));
 
+	if (tileTextures[tile].id == 0)
+	{
+		Image img = { texScratch, rect.width, rect.height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+		tileTextures[tile] = LoadTextureFromImage(img);
 	}
-	imgInvalid = 0;
+	else UpdateTexture(tileTextures[tile], texScratch);
+}
+void drawTerrainTile(int tile, TerrainRect rect, void* userData)
+{
+	DrawTexture(tileTextures[tile], rect.x, rect.y, WHITE);
 }
 void render()
 {
 
 
 	Vector2 thisPos = GetMousePosition();
+	double phaseStart[TELEMETRY_PHASE_COUNT + 1];
 
+	phaseStart[PHASE_INPUT] = GetTime();
 	handleInput(thisPos);
+	phaseStart[PHASE_LOGIC] = GetTime();
 	handlelogic(thisPos);
-	CheckAndUpdateTexture();
+	phaseStart[PHASE_FLUSH] = GetTime();
+	FlushTerrainChanges();
+	MoveVisionUnit(&teamVision, playerEye, (int)player.position.x, (int)(player.position.y - player.size.y / 2));
+	UpdateTeamVision(&teamVision);
+	RunScheduledJobs(JOB_FRAME_BUDGET);
+	if (GetTime() - lastCheckpointTime >= CHECKPOINTSECONDS) saveCheckpoint();
+	phaseStart[PHASE_DRAW] = GetTime();
 	BeginDrawing();
 	BeginMode2D(mainCam);
 	ClearBackground({ 0,0,52,255 });
 
-	DrawTexture(texBg, 0, 0, WHITE);
+	//only the tiles under the camera are uploaded and drawn
+	Vector2 viewMin = GetScreenToWorld2D({ 0, 0 }, mainCam);
+	Vector2 viewMax = GetScreenToWorld2D({ (float)GetScreenWidth(), (float)GetScreenHeight() }, mainCam);
+	DrawTerrainTiles(&terrainTiles, viewMin.x, viewMin.y, viewMax.x - viewMin.x, viewMax.y - viewMin.y);
 
-	DrawTexture(texCn, player.position.x - (texCn.width / 2), player.position.y - (texCn.height - 4), WHITE);
-	//DrawCircle(player.position.x, player.position.y, 10, RED);
-	//const char* txt = TextFormat("x%f, y%f", cannonPos.x, cannonPos.y);
-	//DrawText(txt, 10, 10, 14, WHITE);
+	bool atlasReady = updateAtlasPreload();
+	if (atlasReady)
+	{
+		//everything else goes through one sorted batch, a draw call per layer; layers set the
+		//draw order, submission order only decides what a full batch would drop, so the few
+		//sprites that matter go in before the debris and debug views
+		BeginSpriteBatch(&spriteBatch);
+
+		SubmitSprite(&spriteBatch, LAYER_TANKS, (int)player.position.y, sprCannon, player.position.x, player.position.y + 4,
+			(float)sprCannon->width, (float)sprCannon->height, sprCannon->width / 2.0f, (float)sprCannon->height, player.tilt, 0xFFFFFFFF);
+		//DrawCircle(player.position.x, player.position.y, 10, RED);
+		//const char* txt = TextFormat("x%f, y%f", cannonPos.x, cannonPos.y);
+		//DrawText(txt, 10, 10, 14, WHITE);
+
+		//DrawText(TextFormat("%i", player.paction), 10, 60, 18, WHITE);
 
-	//DrawText(TextFormat("%i", player.paction), 10, 60, 18, WHITE);
 
 
+		Color shellColor = MAROON;
+		if (ball.active)
+			SubmitSprite(&spriteBatch, LAYER_PROJECTILES, 0, sprShell, ball.position.x, ball.position.y, ball.radius * 2 + 1, ball.radius * 2 + 1,
+				ball.radius + 0.5f, ball.radius + 0.5f, 0, *(unsigned int*)&shellColor);
 
-	if (ball.active) DrawCircle(ball.position.x, ball.position.y, ball.radius, MAROON);
-	if (!ballOnAir)
-		DrawTriangle(
-			{ player.position.x - player.size.x / 2, player.position.y - player.size.y / 4 },
-			{ player.position.x + player.size.x * 2, player.position.y + player.size.y / 4 },
-			player.aimingPoint, { 255,255,255,100 });
+		Color guideColor = { 255,255,255,100 };
+		if (!ballOnAir)
+			SubmitSpriteTriangle(&spriteBatch, LAYER_OVERLAY, 0, sprPixel,
+				player.position.x - player.size.x / 2, player.position.y - player.size.y / 4,
+				player.position.x + player.size.x * 2, player.position.y + player.size.y / 4,
+				player.aimingPoint.x, player.aimingPoint.y, *(unsigned int*)&guideColor);
+		if (!ballOnAir && player.impactPoint.x >= 0)
+			SubmitSprite(&spriteBatch, LAYER_OVERLAY, 1, sprPixel, player.impactPoint.x, player.impactPoint.y, 4, 4, 2, 2, 45, *(unsigned int*)&guideColor);
+
+		for (int i = 0; i < debris.count; i++)
+			SubmitSprite(&spriteBatch, LAYER_DEBRIS, 0, sprPixel, debris.x[i], debris.y[i], 1, 1, 0, 0, 0, debris.color[i]);
+		if (showContours) drawContours(viewMin, viewMax);
+		if (showFog) drawFog(viewMin, viewMax);
+
+		EndSpriteBatch(&spriteBatch);
+	}
+	else drawAtlasPlaceholder();
 	EndMode2D();
+	if (!atlasReady) DrawRectangle(10, GetScreenHeight() - 14, (int)(200 * GetAssetPreloadProgress()), 4, WHITE);
 	EndDrawing();
+	phaseStart[TELEMETRY_PHASE_COUNT] = GetTime();
 
+	TelemetryTick tick = { tickCount++, player.position.x, player.position.y, player.tilt, (int)player.paction,
+		ball.active, ball.position.x, ball.position.y, tickCarves };
+	for (int i = 0; i < TELEMETRY_PHASE_COUNT; i++) tick.phaseMs[i] = (float)((phaseStart[i + 1] - phaseStart[i]) * 1000.0);
+	RecordTelemetryTick(&tick);
+	tickCarves = 0;
 
 }
 
@@ -303,6 +586,7 @@ bool updatePlayer(Vector2& thisPos)
 		else {
 			player.isLeftTeam = false;
 }
+		previewImpact();
 		if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
 		{
 			player.previousPoint = player.aimingPoint;
@@ -318,6 +602,7 @@ bool updatePlayer(Vector2& thisPos)
 		player.aimingPoint = player.position;
 		player.aimingPower = 0;
 		player.aimingAngle = 0;
+		player.impactPoint = { -100, -100 };
 	}
 
 
@@ -371,21 +656,55 @@ void handlePlayerMovt()
 		handleStanding();
 		break;
 	}
+
+	updateTilt();
+}
+// Lean the tank to the ground under its tracks, eased so single-pixel bumps don't jitter it
+void updateTilt()
+{
+	float xs[3] = { player.position.x - player.size.x / 4, player.position.x, player.position.x + player.size.x / 4 };
+	float ys[3] = { player.position.y, player.position.y, player.position.y };
+	TerrainNormal n[3];
+	QueryTerrainNormals(&normalCache, xs, ys, 3, n);
+
+	float target = 0;
+	if (player.paction != FALLING)
+		target = atan2(n[0].nx + n[1].nx + n[2].nx, -(n[0].ny + n[1].ny + n[2].ny)) * RAD2DEG;
+
+	player.tilt += (target - player.tilt) * 0.25f;
 }
 bool updateBall()
 {
 	if (!ball.active)
 	{
-		ball.speed.x = cos(player.previousAngle * DEG2RAD) * player.previousPower * 3 / DELTA_FPS;
-		ball.speed.y = -sin(player.previousAngle * DEG2RAD) * player.previousPower * 3 / DELTA_FPS;
+		if (fixedPhysics) launchFixedBall();
+		else
+		{
+			ball.speed.x = cos(player.previousAngle * DEG2RAD) * player.previousPower * 3 / DELTA_FPS;
+			ball.speed.y = -sin(player.previousAngle * DEG2RAD) * player.previousPower * 3 / DELTA_FPS;
+			if (player.isLeftTeam) ball.speed.x = -ball.speed.x;
+		}
 		ball.active = true;
-		if (player.isLeftTeam) ball.speed.x = -ball.speed.x;
+		ball.armed = false;
+		ball.bounces = 0;
 
 	}
 
-	ball.position.x += ball.speed.x;
-	ball.position.y += ball.speed.y;
-	ball.speed.y += GRAVITY / DELTA_FPS;
+	Vector2 from = ball.position;
+	fixed fromX = ball.fx, fromY = ball.fy;
+	if (fixedPhysics)
+	{
+		FixedBodies body = { &ball.fx, &ball.fy, &ball.fvx, &ball.fvy, 1 };
+		StepFixedBodies(&body, FIXEDGRAVITY);
+		ball.position = { FixedToFloat(ball.fx), FixedToFloat(ball.fy) };
+		ball.speed = { FixedToFloat(ball.fvx), FixedToFloat(ball.fvy) };
+	}
+	else
+	{
+		ball.position.x += ball.speed.x;
+		ball.position.y += ball.speed.y;
+		ball.speed.y += GRAVITY / DELTA_FPS;
+	}
 
 
 	if (ball.position.x + ball.radius < 0 || ball.position.y >= GetScreenHeight())
@@ -401,18 +720,289 @@ bool updateBall()
 
 
 
-	//check for terrain collision using pixel color
+	//shells only hit tanks once they have left the barrel they were fired from
+	updateBroadphase();
+	bool touchingTank = testTankHits() > 0;
+	if (!touchingTank) ball.armed = true;
+	else if (ball.armed) return true;
+
+	//check for terrain collision along the whole step, so fast shells can't tunnel
 	//this is different from the example
+	Vector2 contact = { 0 };
+	bool hitTerrain = false;
+	int hitX = 0, hitY = 0;
+	if (fixedPhysics)
+	{
+		//whole pixels into the integer raycast, the distance field's float contact would differ between builds
+		int x0 = (fromX >> FIXED_SHIFT) + ball.radius, y0 = fromY >> FIXED_SHIFT;
+		int x1 = (ball.fx >> FIXED_SHIFT) + ball.radius, y1 = ball.fy >> FIXED_SHIFT;
+		hitTerrain = RaycastOccupancy(&occupancy, (float)x0, (float)y0, (float)x1, (float)y1, &hitX, &hitY);
+		contact = { (float)hitX, (float)hitY };
+	}
+	else if (sdfEnabled && sdfPendingCount == 0)
+	{
+		//same leading probe point as the raycast below, the distance field just gets there in fewer steps
+		hitTerrain = SphereTraceTerrainSdf(&terrainSdf, from.x + ball.radius, from.y, ball.position.x + ball.radius, ball.position.y, 0, &contact.x, &contact.y);
+	}
+	else
+	{
+		hitTerrain = RaycastOccupancy(&occupancy, from.x + ball.radius, from.y, ball.position.x + ball.radius, ball.position.y, &hitX, &hitY);
+		contact = { (float)hitX, (float)hitY };
+	}
+
+	if (!hitTerrain) return false;
 
-	Color c = GetImageColor(imgBg, ball.position.x + ball.radius, ball.position.y);
-	if (c.a > 0) //simple alpha check value
+	//glancing hits ricochet off the surface, anything steeper detonates
+	if (fixedPhysics)
 	{
-		return true;
+		//unit normal from the integer gradient, len is |g| in Q16.16
+		int gx, gy;
+		QueryTerrainGradients(&normalCache, &hitX, &hitY, 1, &gx, &gy);
+		fixed nx = 0, ny = -FIXED_ONE;
+		unsigned long long g2 = (unsigned long long)(gx * gx + gy * gy);
+		if (g2 > 0)
+		{
+			long long len = IntSqrt(g2 << (2 * FIXED_SHIFT));
+			nx = (fixed)(-((long long)gx << (2 * FIXED_SHIFT)) / len);
+			ny = (fixed)(-((long long)gy << (2 * FIXED_SHIFT)) / len);
+		}
+
+		fixed speed = FixedLength(ball.fvx, ball.fvy);
+		fixed vn = FixedMul(ball.fvx, nx) + FixedMul(ball.fvy, ny);
+		if (ball.bounces < MAXBOUNCES && vn > -FixedMul(FIXEDRICOCHETCOS, speed) && speed > IntToFixed(2))
+		{
+			ball.fvx = FixedMul(ball.fvx - 2 * FixedMul(vn, nx), FIXEDRESTITUTION);
+			ball.fvy = FixedMul(ball.fvy - 2 * FixedMul(vn, ny), FIXEDRESTITUTION);
+			ball.fx = fromX;
+			ball.fy = fromY;
+			ball.position = from;
+			ball.bounces++;
+			return false;
+		}
+	}
+	else
+	{
+		TerrainNormal n;
+		QueryTerrainNormals(&normalCache, &contact.x, &contact.y, 1, &n);
+		float speed = sqrt(ball.speed.x * ball.speed.x + ball.speed.y * ball.speed.y);
+		float along = (ball.speed.x * n.nx + ball.speed.y * n.ny) / speed;
+		if (ball.bounces < MAXBOUNCES && along > -RICOCHETCOS && speed > 2)
+		{
+			float vn = ball.speed.x * n.nx + ball.speed.y * n.ny;
+			ball.speed.x = (ball.speed.x - 2 * vn * n.nx) * RESTITUTION;
+			ball.speed.y = (ball.speed.y - 2 * vn * n.ny) * RESTITUTION;
+			ball.position = from;
+			ball.bounces++;
+			return false;
+		}
+	}
+
+	ball.position = { contact.x - ball.radius, contact.y };
+	return true;
+}
+// Load the atlas built by "make atlas", or pack the same sprites now when it is missing
+void setupAtlas()
+{
+	const char* sources[][2] = {
+		{ "cannon", "resources/cannon.png" },
+		{ "shell", "resources/shell.png" },
+		{ "pixel", "resources/pixel.png" },
+	};
+	const int sourceCount = sizeof(sources) / sizeof(sources[0]);
+
+	if (FileExists(ATLASPATH) && LoadSpriteAtlasLayout(&atlas, "resources/atlas.txt"))
+	{
+		//requested at the top of setup(), render() uploads it within the frame budget
+		texAtlas = { 0 };
+	}
+	else
+	{
+		Image images[sourceCount];
+		atlas.count = sourceCount;
+		for (int i = 0; i < sourceCount; i++)
+		{
+			images[i] = LoadImage(sources[i][1]);
+			ImageFormat(&images[i], PixelFormat::PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+			strcpy(atlas.sprites[i].name, sources[i][0]);
+			atlas.sprites[i].width = images[i].width;
+			atlas.sprites[i].height = images[i].height;
+		}
+		PackSpriteAtlas(&atlas, 256);
 
+		Image img = GenImageColor(atlas.width, atlas.height, BLANK);
+		for (int i = 0; i < sourceCount; i++)
+		{
+			AtlasSprite* spr = &atlas.sprites[i];
+			ImageDraw(&img, images[i], { 0, 0, (float)spr->width, (float)spr->height }, { (float)spr->x, (float)spr->y, (float)spr->width, (float)spr->height }, WHITE);
+			UnloadImage(images[i]);
+		}
+		texAtlas = LoadTextureFromImage(img);
+		UnloadImage(img);
+	}
+
+	sprCannon = FindAtlasSprite(&atlas, "cannon");
+	sprShell = FindAtlasSprite(&atlas, "shell");
+	sprPixel = FindAtlasSprite(&atlas, "pixel");
+	//room for a full debris pool, a full contour view and a fog cell per 8x8 of the screen (zoom never goes below 1)
+	int fogCells = (GetScreenWidth() / 8 + 2) * (GetScreenHeight() / 8 + 2);
+	int contourSprites = sizeof(contourView) / sizeof(ContourSegment);
+	InitSpriteBatch(&spriteBatch, DEBRIS_MAX_PARTICLES + contourSprites + fogCells + 256, atlas.width, atlas.height, flushSprites, nullptr);
+}
+// Upload the preloaded atlas a frame budget at a time, true once sprites can be drawn
+bool updateAtlasPreload()
+{
+	if (texAtlas.id != 0) return true;
+	if (!UpdateAssetPreload(PRELOAD_FRAME_BUDGET)) return false;
 
+	//a failed decode falls back to a plain load
+	texAtlas = GetPreloadedTexture(ATLASPATH);
+	if (texAtlas.id == 0) texAtlas = LoadTexture(ATLASPATH);
+	return texAtlas.id != 0;
+}
+// Plain shapes for the tank and shell while the atlas is still uploading
+void drawAtlasPlaceholder()
+{
+	DrawRectangle((int)(player.position.x - sprCannon->width / 2), (int)(player.position.y + 4 - sprCannon->height), sprCannon->width, sprCannon->height, GRAY);
+	if (ball.active) DrawCircleV(ball.position, ball.radius, MAROON);
+}
+void flushSprites(SpriteLayer layer, const SpriteVertex* vertices, int vertexCount, void* userData)
+{
+	//rlgl's batch holds RL_DEFAULT_BATCH_BUFFER_ELEMENTS quads (2048 on GLES2), longer runs go in pieces
+	const int chunk = RL_DEFAULT_BATCH_BUFFER_ELEMENTS * 4;
+	rlSetTexture(texAtlas.id);
+	for (int first = 0; first < vertexCount; first += chunk)
+	{
+		int count = vertexCount - first < chunk ? vertexCount - first : chunk;
+		rlCheckRenderBatchLimit(count);
+		rlBegin(RL_QUADS);
+		for (int i = first; i < first + count; i++)
+		{
+			const unsigned char* c = (const unsigned char*)&vertices[i].color;
+			rlColor4ub(c[0], c[1], c[2], c[3]);
+			rlTexCoord2f(vertices[i].u, vertices[i].v);
+			rlVertex2f(vertices[i].x, vertices[i].y);
+		}
+		rlEnd();
 	}
+	rlSetTexture(0);
+}
+// Fire from the aim point with table trigonometry, the inputs are whole pixels so every build starts the shell identically
+void launchFixedBall()
+{
+	ball.fx = IntToFixed((int)ball.position.x);
+	ball.fy = IntToFixed((int)ball.position.y);
+	aimVelocity(player.previousPoint, &ball.fvx, &ball.fvy);
+}
+// Launch velocity for a shot aimed at point, the same for the preview and the real shell
+void aimVelocity(Vector2 point, fixed* vx, fixed* vy)
+{
+	fixed dx = IntToFixed((int)point.x - (int)player.position.x);
+	fixed dy = IntToFixed((int)player.position.y - (int)point.y);
+	int angle = FixedAtan2(dy, dx < 0 ? -dx : dx);
+	fixed speed = FixedLength(dx, dy) * 3 / DELTA_FPS;
+
+	*vx = FixedMul(FixedCos(angle), speed);
+	*vy = -FixedMul(FixedSin(angle), speed);
+	if (player.isLeftTeam) *vx = -*vx;
+}
+// First terrain contact of the shot being aimed, cached until the mouse moves or the path gets carved
+void previewImpact()
+{
+	player.impactPoint = { -100, -100 };
+	if (!fixedPhysics) return;
 
-	return false;
+	//the leading probe point updateBall raycasts from
+	TrajectoryShot shot;
+	shot.x = IntToFixed((int)player.position.x + ball.radius);
+	shot.y = IntToFixed((int)player.position.y);
+	shot.gravity = FIXEDGRAVITY;
+	aimVelocity(player.aimingPoint, &shot.vx, &shot.vy);
+
+	TrajectoryResult result = QueryTrajectory(&trajectoryCache, &shot);
+	if (result.hit) player.impactPoint = { (float)result.x, (float)result.y };
+}
+// Keep the latest checkpoint in memory, after the terrain flush so every change is in it
+void saveCheckpoint()
+{
+	MatchState state = { player, ball, ballOnAir, tickCount };
+	free(lastCheckpoint);
+	lastCheckpoint = SaveMatchCheckpoint(&matchCheckpoint, &state, sizeof(MatchState), &lastCheckpointSize);
+	lastCheckpointTime = GetTime();
+}
+void restoreCheckpoint()
+{
+	MatchState state;
+	if (lastCheckpoint == nullptr || !LoadMatchCheckpoint(&matchCheckpoint, lastCheckpoint, lastCheckpointSize, &state, sizeof(MatchState))) return;
+
+	player = state.player;
+	ball = state.ball;
+	ballOnAir = state.ballOnAir;
+	tickCount = state.tickCount;
+	ClearDebrisPool(&debris);
+	lastCheckpointTime = GetTime();
+}
+// Terrain outline under the camera, a thin sprite per contour segment
+void drawContours(Vector2 viewMin, Vector2 viewMax)
+{
+	TerrainRect view = { (int)viewMin.x, (int)viewMin.y, (int)(viewMax.x - viewMin.x) + 1, (int)(viewMax.y - viewMin.y) + 1 };
+	int count = GetTerrainContourSegments(&terrainContours, view, contourView, sizeof(contourView) / sizeof(ContourSegment));
+
+	Color outlineColor = YELLOW;
+	for (int i = 0; i < count; i++)
+	{
+		//half pixels to world, pixel centres sit at +0.5
+		float x0 = contourView[i].from.x * 0.5f + 0.5f, y0 = contourView[i].from.y * 0.5f + 0.5f;
+		float dx = (contourView[i].to.x - contourView[i].from.x) * 0.5f, dy = (contourView[i].to.y - contourView[i].from.y) * 0.5f;
+		SubmitSprite(&spriteBatch, LAYER_OVERLAY, 0, sprPixel, x0, y0, sqrtf(dx * dx + dy * dy), 1, 0, 0.5f,
+			atan2f(dy, dx) * RAD2DEG, *(unsigned int*)&outlineColor);
+	}
+}
+// Dark 8x8 cells over what team 0 can't see now, lighter where it has looked before
+void drawFog(Vector2 viewMin, Vector2 viewMax)
+{
+	Color unseenColor = { 0, 0, 0, 230 };
+	Color exploredColor = { 0, 0, 0, 140 };
+	int x0 = (int)viewMin.x < 0 ? 0 : (int)viewMin.x / 8 * 8, y0 = (int)viewMin.y < 0 ? 0 : (int)viewMin.y / 8 * 8;
+	for (int y = y0; y < viewMax.y && y < Height; y += 8)
+		for (int x = x0; x < viewMax.x && x < Width; x += 8)
+		{
+			//one sample at the cell centre
+			if (IsVisibleToTeam(&teamVision, 0, x + 4, y + 4)) continue;
+			Color color = IsExploredByTeam(&teamVision, 0, x + 4, y + 4) ? exploredColor : unseenColor;
+			SubmitSprite(&spriteBatch, LAYER_OVERLAY, 2, sprPixel, (float)x, (float)y, 8, 8, 0, 0, 0, *(unsigned int*)&color);
+		}
+}
+// Rebuild the broadphase from this tick's tanks and shells
+void updateBroadphase()
+{
+	ClearSpatialHash(&broadphase);
+	AddSpatialEntry(&broadphase, SPATIAL_TANK, 0, player.position.x, player.position.y - player.size.y / 2 + 4, TANKRADIUS);
+	if (ball.active) AddSpatialEntry(&broadphase, SPATIAL_PROJECTILE, 0, ball.position.x, ball.position.y, ball.radius);
+	BuildSpatialHash(&broadphase);
+}
+// Pixel-exact tank hits for every broadphase pair, returns the number of hits
+int testTankHits()
+{
+	SpatialPair pairs[64];
+	PixelMaskTest tests[64];
+	bool hits[64];
+	int count = QuerySpatialPairs(&broadphase, SPATIAL_TANK, SPATIAL_PROJECTILE, pairs, 64);
+
+	for (int i = 0; i < count; i++)
+	{
+		//entry ids index the tank and ball arrays, there is one of each for now
+		int angle = (int)roundf(player.tilt / TANKMASKSTEP) + TANKMASKANGLES / 2;
+		angle = angle < 0 ? 0 : angle >= TANKMASKANGLES ? TANKMASKANGLES - 1 : angle;
+
+		tests[i].a = &tankMasks[angle];
+		tests[i].ax = (int)roundf(player.position.x);
+		tests[i].ay = (int)roundf(player.position.y) + 4;
+		tests[i].b = &ballMask;
+		tests[i].bx = (int)roundf(ball.position.x);
+		tests[i].by = (int)roundf(ball.position.y);
+	}
+
+	return TestPixelMaskPairs(tests, count, hits);
 }
 void handlelogic(Vector2& thisPos)
 {
@@ -435,6 +1025,12 @@ void handlelogic(Vector2& thisPos)
 		}
 	}
 
+	FlushCarveQueue(&carveQueue, maskBg, emitCarvedDebris, nullptr);
+
+	TerrainRect settled;
+	if (UpdateDebris(&debris, GRAVITY / DELTA_FPS, maskBg, (unsigned char*)imgBg.data, Width, Height, &settled) > 0)
+		PublishTerrainChange(settled);
+
 }
 void handleInput(Vector2& thisPos)
 {
@@ -442,6 +1038,11 @@ void handleInput(Vector2& thisPos)
 
 	//player.movement.x = 0;
 //	player.paction = STANDING;
+	if (IsKeyPressed(KEY_F9)) restoreCheckpoint();
+	if (IsKeyPressed(KEY_F8)) showContours = !showContours;
+	if (IsKeyPressed(KEY_F7)) showFog = !showFog;
+	if (IsKeyPressed(KEY_G)) navGoal = GetScreenToWorld2D(GetMousePosition(), mainCam);
+
 	if (IsKeyPressed(KEY_PAGE_UP))
 	{
 		mainCam.zoom += 1;
@@ -450,6 +1051,7 @@ void handleInput(Vector2& thisPos)
 	{
 
 		mainCam.zoom -= 1;
+		if (mainCam.zoom < 1) mainCam.zoom = 1;
 	}
 
 	if (IsKeyPressed(KEY_RIGHT))
@@ -515,6 +1117,7 @@ void handleWalking()
 	int DY = 0;
 	Vector2& pos = player.position;
 	Vector2& mov = player.movement;
+	if (navGoal.x >= 0) steerToGoal();
 	pos.x += mov.x;
 	DY = findGroundPixel(pos.x, pos.y);
 
@@ -552,6 +1155,17 @@ void handleWalking()
 	}
 
 }
+// Face the way the nav field says is shortest to navGoal, drop the goal once there or if it can't be reached
+void steerToGoal()
+{
+	int x = (int)player.position.x, y = (int)player.position.y;
+	const NavField* field = GetNavField(&navCache, (int)navGoal.x, (int)navGoal.y);
+	NavStep step;
+	QueryNavSteps(&navGraph, field, &x, &y, 1, &step);
+
+	if (step.direction != 0) player.movement.x = (float)step.direction;
+	else navGoal = { -1, -1 };
+}
 void handleFalling() {
 	int curFallDisnace = 0;
 	int maxFallDistance = 3;
@@ -615,92 +1229,81 @@ void handleAscending() {
 void handleStanding() {}
 
 
+// Row band of a mask built from image alpha, shared by the map and the bomb
+void maskFromAlphaRows(int y0, int y1, void* userData)
+{
+	AlphaMaskPass* pass = (AlphaMaskPass*)userData;
+	for (int y = y0; y < y1; y++)
+		for (int x = 0; x < pass->width; x++)
+		{
+			int ix = y * pass->width + x;
+			if (ix >= pass->size || ix <= 0) continue;
+			pass->mask[ix] = pass->cols[ix].a > 0 ? 1 : 0;
+		}
+}
 void setupBGMask()
 {
 	maskBg = (int*)calloc(Size, sizeof(int));
 	Color* cols = LoadImageColors(imgBg);
-	for (int y = 0; y < Height; y++)
-	{
+	AlphaMaskPass pass = { cols, maskBg, Width, Size };
+	ParallelForRows(Height, PARALLEL_ROW_BAND, maskFromAlphaRows, &pass);
+	UnloadImageColors(cols);
+}
+// Layer dirt, rock and bedrock under the surface, and shade the harder ones so they read as such
+void setupMaterials()
+{
+	InitTerrainMaterials(&terrainMaterials, maskBg, Width, Height, MATERIAL_DIRT);
+	LayerTerrainMaterials(&terrainMaterials, maskBg, DIRTDEPTH, BEDROCKROWS);
 
-		for (int x = 0; x < Width; x++)
+	ParallelForTiles(Width, Height, TERRAIN_TILE_SIZE, shadeMaterialTile, nullptr);
+}
+void shadeMaterialTile(int x0, int y0, int x1, int y1, void* userData)
+{
+	Color* px = (Color*)imgBg.data;
+	for (int y = y0; y < y1; y++)
+		for (int x = x0; x < x1; x++)
 		{
-			int ix = y * Width + x;
-
-			if (ix >= Size || ix <= 0) continue;
-
-			if (cols[ix].a > 0)
-			{
-
-				maskBg[ix] = 1;
-			}
-			else {
-				maskBg[ix] = 0;
-			}
-
-
+			int h = GetTerrainHardness(&terrainMaterials, x, y);
+			if (h <= GetMaterialHardness(MATERIAL_DIRT)) continue;
+
+			float shade = h == MATERIAL_HARDNESS_MAX ? 0.4f : 0.7f;
+			Color* c = &px[y * Width + x];
+			c->r = (unsigned char)(c->r * shade);
+			c->g = (unsigned char)(c->g * shade);
+			c->b = (unsigned char)(c->b * shade);
 		}
-	}
-	UnloadImageColors(cols);
 }
 void setupBombMask()
 {
 	maskBomb = (int*)calloc(bombSize, sizeof(int));
 	Color* cols = LoadImageColors(imgBomb);
-	for (int y = 0; y < bombHeight; y++)
-		for (int x = 0; x < bombWidth; x++)
-		{
-			int ix = y * bombWidth + x;
-			if (ix >= bombSize || ix <= 0) continue;
-			if (cols[ix].a != 0)
-			{
-				maskBomb[ix] = 1;
-			}
-			else
-			{
-
-				maskBomb[ix] = 0;
-			}
-
-		}
-
+	AlphaMaskPass pass = { cols, maskBomb, bombWidth, bombSize };
+	ParallelForRows(bombHeight, PARALLEL_ROW_BAND, maskFromAlphaRows, &pass);
 	UnloadImageColors(cols);
 }
 
 void cutBombMask(int cx, int cy)
 {
-
-	//there are better ways of doing this with ptr logic! see raylib's imagedraw for ideas,i've done this to illustrate what's happening.
-
-
-//	Color* c = LoadImageColors(imgBg);
-
 	cx = cx - bombWidth / 2;
 	cy = cy - bombHeight;
 
-	for (int y = 0; y < bombHeight; y++)
-	{
-		for (int x = 0; x < bombWidth; x++)
-		{
-			int sx = y * bombWidth + x;
-			int dx = (cy + y) * Width + (cx + x);
-			if (dx > Size || sx > bombSize || dx < 0 || sx < 0) continue;
-
-			if (maskBomb[sx] == 1)
-			{
-				maskBg[dx] = 0;
-			}
+	//nothing under the stamp, nothing to carve or upload; an exact count in four lookups
+	if (GetTerrainSum(&terrainDensity, { cx, cy, bombWidth, bombHeight }) == 0) return;
 
+	//carved with the rest of the tick's impacts in handlelogic
+	QueueCarve(&carveQueue, &bombStamp, cx, cy);
 
+	TelemetryCarve carve = { tickCount, cx, cy, bombWidth, bombHeight };
+	RecordTelemetryCarve(&carve);
+	tickCarves++;
+}
 
-		}
-	}
-
-
-
-
-	//	UnloadImageColors(c);
-	imgInvalid = true;
-
+// The carved pixel keeps flying as debris with the terrain colour, away from its blast
+void emitCarvedDebris(int x, int y, int carve, void* userData)
+{
+	const QueuedCarve* blast = &carveQueue.carves[carve];
+	unsigned int* pxBg = (unsigned int*)imgBg.data;
+	EmitDebris(&debris, x, y, blast->x + bombWidth / 2, blast->y + bombHeight / 2, pxBg[y * Width + x]);
 }
 
 void cutPx(int _x, int _y)
@@ -723,26 +1326,38 @@ void cutPx(int _x, int _y)
 
 int HasPixelAt(int x, int y)
 {
-	return GetImageColor(imgBg, x, y).a == 255;
+	return IsTerrainSolid(&terrainStore, x, y);
 }
 int findGroundPixel(int x, int y)
 {
+	//the whole probe column y-7..y+4 in one batched query, bit k is y + k - 7
+	int xs[12], ys[12];
+	for (int k = 0; k < 12; k++)
+	{
+		xs[k] = x;
+		ys[k] = y + k - 7;
+	}
+	unsigned long long solid;
+	QueryTerrainStorePoints(&terrainStore, xs, ys, 12, &solid);
+#define SOLIDAT(dy) ((solid >> ((dy) + 7)) & 1)
+
 	int r = 0;
-	if (HasPixelAt(x, y))
+	if (SOLIDAT(0))
 	{
-		while (HasPixelAt(x, y + r - 1) && (r > -7))
+		while ((r > -7) && SOLIDAT(r - 1))
 		{
 			r--;
 		}
 	}
 	else {
 		r++;
-		while (!HasPixelAt(x, y + r) && (r < 4))
+		while (!SOLIDAT(r) && (r < 4))
 		{
 
 			r++;
 		}
 	}
+#undef SOLIDAT
 
 
 	return r;
@@ -0,0 +1,201 @@
+/*******************************************************************************************
+*
+*   Spatial Hash - uniform grid broadphase for tanks, projectiles and particles
+*
+********************************************************************************************/
+
+#include "spatial_hash.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition (local)
+//----------------------------------------------------------------------------------
+static inline int CellCoord(const SpatialHash* hash, float v) { return (int)floorf(v / hash->cellSize); }
+
+static inline int PackCell(int cx, int cy) { return (cx & 0xFFFF) | ((cy & 0xFFFF) << 16); }
+
+static inline int BucketOf(const SpatialHash* hash, int cx, int cy)
+{
+	return (int)(((unsigned int)cx * 73856093u) ^ ((unsigned int)cy * 19349663u)) & (hash->bucketCount - 1);
+}
+
+static inline bool CirclesOverlap(const SpatialEntry* a, const SpatialEntry* b)
+{
+	float dx = a->x - b->x;
+	float dy = a->y - b->y;
+	float r = a->radius + b->radius;
+	return dx * dx + dy * dy <= r * r;
+}
+
+//----------------------------------------------------------------------------------
+// Spatial Hash Functions Definition
+//----------------------------------------------------------------------------------
+void InitSpatialHash(SpatialHash* hash, float cellSize, int capacity)
+{
+	int buckets = 1024;
+	while (buckets < capacity * 2) buckets <<= 1;
+
+	hash->cellSize = cellSize;
+	hash->bucketCount = buckets;
+
+	hash->entries = (SpatialEntry*)calloc(capacity, sizeof(SpatialEntry));
+	hash->stamp = (unsigned int*)calloc(capacity, sizeof(unsigned int));
+	hash->capacity = capacity;
+	hash->count = 0;
+
+	hash->bucketStart = (int*)calloc(buckets + 1, sizeof(int));
+	hash->itemCapacity = capacity * 4;
+	hash->items = (int*)calloc(hash->itemCapacity, sizeof(int));
+	hash->itemCell = (int*)calloc(hash->itemCapacity, sizeof(int));
+	hash->itemCount = 0;
+	hash->queryStamp = 0;
+}
+
+void UnloadSpatialHash(SpatialHash* hash)
+{
+	free(hash->entries);
+	free(hash->stamp);
+	free(hash->bucketStart);
+	free(hash->items);
+	free(hash->itemCell);
+	memset(hash, 0, sizeof(SpatialHash));
+}
+
+void ClearSpatialHash(SpatialHash* hash)
+{
+	hash->count = 0;
+	hash->itemCount = 0;
+}
+
+int AddSpatialEntry(SpatialHash* hash, SpatialKind kind, int id, float x, float y, float radius)
+{
+	if (hash->count >= hash->capacity) return -1;
+
+	int e = hash->count++;
+	hash->entries[e] = { x, y, radius, (int)kind, id };
+	return e;
+}
+
+void BuildSpatialHash(SpatialHash* hash)
+{
+	int* start = hash->bucketStart;
+	memset(start, 0, (hash->bucketCount + 1) * sizeof(int));
+
+	//count items per bucket, an entry lands in every cell its bounds cover
+	int total = 0;
+	for (int e = 0; e < hash->count; e++)
+	{
+		const SpatialEntry* en = &hash->entries[e];
+		int x0 = CellCoord(hash, en->x - en->radius), x1 = CellCoord(hash, en->x + en->radius);
+		int y0 = CellCoord(hash, en->y - en->radius), y1 = CellCoord(hash, en->y + en->radius);
+
+		for (int cy = y0; cy <= y1; cy++)
+			for (int cx = x0; cx <= x1; cx++)
+				start[BucketOf(hash, cx, cy)]++;
+
+		total += (x1 - x0 + 1) * (y1 - y0 + 1);
+	}
+
+	if (total > hash->itemCapacity)
+	{
+		hash->itemCapacity = total * 2;
+		hash->items = (int*)realloc(hash->items, hash->itemCapacity * sizeof(int));
+		hash->itemCell = (int*)realloc(hash->itemCell, hash->itemCapacity * sizeof(int));
+	}
+
+	//inclusive prefix sum gives bucket ends, filling backwards walks them down to the starts
+	for (int b = 1; b < hash->bucketCount; b++) start[b] += start[b - 1];
+	start[hash->bucketCount] = total;
+
+	for (int e = 0; e < hash->count; e++)
+	{
+		const SpatialEntry* en = &hash->entries[e];
+		int x0 = CellCoord(hash, en->x - en->radius), x1 = CellCoord(hash, en->x + en->radius);
+		int y0 = CellCoord(hash, en->y - en->radius), y1 = CellCoord(hash, en->y + en->radius);
+
+		for (int cy = y0; cy <= y1; cy++)
+			for (int cx = x0; cx <= x1; cx++)
+			{
+				int slot = --start[BucketOf(hash, cx, cy)];
+				hash->items[slot] = e;
+				hash->itemCell[slot] = PackCell(cx, cy);
+			}
+	}
+
+	hash->itemCount = total;
+}
+
+int QuerySpatialPairs(SpatialHash* hash, SpatialKind kindA, SpatialKind kindB, SpatialPair* pairs, int maxPairs)
+{
+	int found = 0;
+	const SpatialEntry* entries = hash->entries;
+
+	for (int b = 0; b < hash->bucketCount; b++)
+	{
+		int s = hash->bucketStart[b], end = hash->bucketStart[b + 1];
+		if (end - s < 2) continue;
+
+		for (int i = s; i < end; i++)
+		{
+			const SpatialEntry* ea = &entries[hash->items[i]];
+			if (ea->kind != kindA) continue;
+
+			for (int j = s; j < end; j++)
+			{
+				if (i == j || hash->itemCell[i] != hash->itemCell[j]) continue;
+
+				const SpatialEntry* eb = &entries[hash->items[j]];
+				if (eb->kind != kindB) continue;
+				if (kindA == kindB && hash->items[i] > hash->items[j]) continue;
+				if (!CirclesOverlap(ea, eb)) continue;
+
+				//both cover the cell holding the min corner of their overlap, report only from there
+				float ox = fmaxf(ea->x - ea->radius, eb->x - eb->radius);
+				float oy = fmaxf(ea->y - ea->radius, eb->y - eb->radius);
+				if (PackCell(CellCoord(hash, ox), CellCoord(hash, oy)) != hash->itemCell[i]) continue;
+
+				if (found < maxPairs) pairs[found] = { hash->items[i], hash->items[j] };
+				found++;
+			}
+		}
+	}
+
+	return found < maxPairs ? found : maxPairs;
+}
+
+int QuerySpatialRadius(SpatialHash* hash, float x, float y, float radius, int kindMask, int* results, int maxResults)
+{
+	int found = 0;
+	SpatialEntry probe = { x, y, radius, 0, 0 };
+
+	hash->queryStamp++;
+
+	int x0 = CellCoord(hash, x - radius), x1 = CellCoord(hash, x + radius);
+	int y0 = CellCoord(hash, y - radius), y1 = CellCoord(hash, y + radius);
+
+	for (int cy = y0; cy <= y1; cy++)
+		for (int cx = x0; cx <= x1; cx++)
+		{
+			int b = BucketOf(hash, cx, cy);
+			int cell = PackCell(cx, cy);
+
+			for (int i = hash->bucketStart[b]; i < hash->bucketStart[b + 1]; i++)
+			{
+				if (hash->itemCell[i] != cell) continue;
+
+				int e = hash->items[i];
+				const SpatialEntry* en = &hash->entries[e];
+				if (!(kindMask & SPATIAL_KIND_BIT(en->kind)) || hash->stamp[e] == hash->queryStamp) continue;
+
+				hash->stamp[e] = hash->queryStamp;
+				if (!CirclesOverlap(&probe, en)) continue;
+
+				if (found < maxResults) results[found++] = e;
+			}
+		}
+
+	return found;
+}
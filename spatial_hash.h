@@ -0,0 +1,67 @@
+/*******************************************************************************************
+*
+*   Spatial Hash - uniform grid broadphase for tanks, projectiles and particles
+*
+*   Entries are circles. The table is rebuilt from scratch every tick with a counting sort
+*   over hashed cells, so a rebuild is linear in the number of entries and cells covered.
+*   Cells are hashed rather than bounded to the map, balls flying above the screen still
+*   land in a bucket.
+*
+********************************************************************************************/
+
+#ifndef SPATIAL_HASH_H
+#define SPATIAL_HASH_H
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef enum SpatialKind { SPATIAL_TANK = 0, SPATIAL_PROJECTILE, SPATIAL_PARTICLE } SpatialKind;
+
+#define SPATIAL_KIND_BIT(kind)   (1 << (kind))
+
+typedef struct SpatialEntry {
+	float x, y;
+	float radius;
+	int kind;                       // SpatialKind
+	int id;                         // Caller's index into its own entity array
+} SpatialEntry;
+
+typedef struct SpatialPair {
+	int a, b;                       // Entry indices, a is of the first kind queried
+} SpatialPair;
+
+typedef struct SpatialHash {
+	float cellSize;
+	int bucketCount;                // Power of two
+
+	SpatialEntry* entries;
+	int count;
+	int capacity;
+
+	int* bucketStart;               // bucketCount + 1 offsets into items
+	int* items;                     // Entry index per covered cell, sorted by bucket
+	int* itemCell;                  // Packed cell coordinate per item, to tell apart cells sharing a bucket
+	int itemCount;
+	int itemCapacity;
+
+	unsigned int* stamp;            // Per entry, dedups radius queries
+	unsigned int queryStamp;
+} SpatialHash;
+
+//----------------------------------------------------------------------------------
+// Spatial Hash Functions Declaration
+//----------------------------------------------------------------------------------
+void InitSpatialHash(SpatialHash* hash, float cellSize, int capacity);
+void UnloadSpatialHash(SpatialHash* hash);
+
+void ClearSpatialHash(SpatialHash* hash);
+int AddSpatialEntry(SpatialHash* hash, SpatialKind kind, int id, float x, float y, float radius);   // Returns entry index, -1 if full
+void BuildSpatialHash(SpatialHash* hash);          // Call once after all entries for the tick are added
+
+// Overlapping pairs between kindA and kindB entries, each pair reported once
+int QuerySpatialPairs(SpatialHash* hash, SpatialKind kindA, SpatialKind kindB, SpatialPair* pairs, int maxPairs);
+
+// Entries of the kinds in kindMask (SPATIAL_KIND_BIT) overlapping the circle (x, y, radius)
+int QuerySpatialRadius(SpatialHash* hash, float x, float y, float radius, int kindMask, int* results, int maxResults);
+
+#endif // SPATIAL_HASH_H
@@ -0,0 +1,97 @@
+/*******************************************************************************************
+*
+*   Sprite Atlas - shelf packing of sprites into one texture and its layout file
+*
+********************************************************************************************/
+
+#include "sprite_atlas.h"
+
+#include <stdio.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------------
+// Sprite Atlas Functions Definition
+//----------------------------------------------------------------------------------
+bool PackSpriteAtlas(SpriteAtlas* atlas, int maxWidth)
+{
+	//tallest first, each shelf is as tall as its first sprite; ties keep source order so the layout is stable
+	int order[ATLAS_MAX_SPRITES];
+	for (int i = 0; i < atlas->count; i++)
+	{
+		int j = i;
+		while (j > 0 && atlas->sprites[order[j - 1]].height < atlas->sprites[i].height)
+		{
+			order[j] = order[j - 1];
+			j--;
+		}
+		order[j] = i;
+	}
+
+	int x = ATLAS_PADDING, y = ATLAS_PADDING, shelfHeight = 0, usedWidth = 0;
+	for (int i = 0; i < atlas->count; i++)
+	{
+		AtlasSprite* s = &atlas->sprites[order[i]];
+		if (s->width + 2 * ATLAS_PADDING > maxWidth) return false;
+
+		if (x + s->width + ATLAS_PADDING > maxWidth)
+		{
+			x = ATLAS_PADDING;
+			y += shelfHeight + ATLAS_PADDING;
+			shelfHeight = 0;
+		}
+
+		s->x = x;
+		s->y = y;
+		x += s->width + ATLAS_PADDING;
+		if (s->height > shelfHeight) shelfHeight = s->height;
+		if (x > usedWidth) usedWidth = x;
+	}
+
+	//power of two sizes keep older GL targets happy
+	atlas->width = 1;
+	while (atlas->width < usedWidth) atlas->width *= 2;
+	atlas->height = 1;
+	while (atlas->height < y + shelfHeight + ATLAS_PADDING) atlas->height *= 2;
+	return true;
+}
+
+bool SaveSpriteAtlasLayout(const SpriteAtlas* atlas, const char* path)
+{
+	FILE* f = fopen(path, "w");
+	if (f == nullptr) return false;
+
+	fprintf(f, "atlas %d %d\n", atlas->width, atlas->height);
+	for (int i = 0; i < atlas->count; i++)
+	{
+		const AtlasSprite* s = &atlas->sprites[i];
+		fprintf(f, "%s %d %d %d %d\n", s->name, s->x, s->y, s->width, s->height);
+	}
+
+	fclose(f);
+	return true;
+}
+
+bool LoadSpriteAtlasLayout(SpriteAtlas* atlas, const char* path)
+{
+	FILE* f = fopen(path, "r");
+	if (f == nullptr) return false;
+
+	bool ok = fscanf(f, "atlas %d %d", &atlas->width, &atlas->height) == 2;
+	atlas->count = 0;
+
+	AtlasSprite s;
+	while (ok && atlas->count < ATLAS_MAX_SPRITES &&
+		fscanf(f, "%31s %d %d %d %d", s.name, &s.x, &s.y, &s.width, &s.height) == 5)
+		atlas->sprites[atlas->count++] = s;
+
+	fclose(f);
+	return ok;
+}
+
+const AtlasSprite* FindAtlasSprite(const SpriteAtlas* atlas, const char* name)
+{
+	for (int i = 0; i < atlas->count; i++)
+		if (strcmp(atlas->sprites[i].name, name) == 0) return &atlas->sprites[i];
+
+	return nullptr;
+}
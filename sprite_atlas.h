@@ -0,0 +1,46 @@
+/*******************************************************************************************
+*
+*   Sprite Atlas - shelf packing of sprites into one texture and its layout file
+*
+*   "make atlas" packs the sprite sources into resources/atlas.png and writes the rects to
+*   resources/atlas.txt. The game loads those when present, and otherwise packs the same
+*   sources at startup with the same packer, so both paths produce the same layout.
+*
+*   Layout file: a line "atlas <width> <height>", then one "<name> <x> <y> <w> <h>" per sprite.
+*
+********************************************************************************************/
+
+#ifndef SPRITE_ATLAS_H
+#define SPRITE_ATLAS_H
+
+#define ATLAS_MAX_SPRITES                64
+#define ATLAS_NAME_SIZE                  32
+#define ATLAS_PADDING                     1     // Transparent pixels between sprites, stops filtering bleed
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct AtlasSprite {
+	char name[ATLAS_NAME_SIZE];
+	int x, y;                       // Placement, filled in by the packer
+	int width, height;
+} AtlasSprite;
+
+typedef struct SpriteAtlas {
+	int width, height;
+	AtlasSprite sprites[ATLAS_MAX_SPRITES];
+	int count;
+} SpriteAtlas;
+
+//----------------------------------------------------------------------------------
+// Sprite Atlas Functions Declaration
+//----------------------------------------------------------------------------------
+// Place every sprite (name, width and height set) in rows of at most maxWidth, false if one doesn't fit
+bool PackSpriteAtlas(SpriteAtlas* atlas, int maxWidth);
+
+bool SaveSpriteAtlasLayout(const SpriteAtlas* atlas, const char* path);
+bool LoadSpriteAtlasLayout(SpriteAtlas* atlas, const char* path);
+
+const AtlasSprite* FindAtlasSprite(const SpriteAtlas* atlas, const char* name);   // nullptr if missing
+
+#endif // SPRITE_ATLAS_H
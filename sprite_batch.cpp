@@ -0,0 +1,154 @@
+/*******************************************************************************************
+*
+*   Sprite Batch - sorted, layered submission of atlas sprites
+*
+********************************************************************************************/
+
+#include "sprite_batch.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition (local)
+//----------------------------------------------------------------------------------
+static inline unsigned long long SpriteKey(SpriteLayer layer, int sortKey, int index)
+{
+	//24 bits of sort key, biased so negative keys sort first
+	if (sortKey < -0x800000) sortKey = -0x800000;
+	if (sortKey > 0x7FFFFF) sortKey = 0x7FFFFF;
+	return ((unsigned long long)layer << 56) | ((unsigned long long)(sortKey + 0x800000) << 32) | (unsigned int)index;
+}
+
+static void FlushRun(SpriteBatch* batch, SpriteLayer layer, int quadCount)
+{
+	batch->flush(layer, batch->flushBuffer, quadCount * 4, batch->userData);
+	batch->stats.drawCalls++;
+	batch->stats.vertices += quadCount * 4;
+}
+
+//----------------------------------------------------------------------------------
+// Sprite Batch Functions Definition
+//----------------------------------------------------------------------------------
+void InitSpriteBatch(SpriteBatch* batch, int capacity, int atlasWidth, int atlasHeight, SpriteFlushCallback flush, void* userData)
+{
+	batch->texelWidth = 1.0f / atlasWidth;
+	batch->texelHeight = 1.0f / atlasHeight;
+	batch->quads = (SpriteVertex*)malloc((size_t)capacity * 4 * sizeof(SpriteVertex));
+	batch->keys = (unsigned long long*)malloc((size_t)capacity * 2 * sizeof(unsigned long long));
+	batch->count = 0;
+	batch->capacity = capacity;
+	batch->flushBuffer = (SpriteVertex*)malloc(SPRITE_BATCH_MAX_QUADS * 4 * sizeof(SpriteVertex));
+	batch->flush = flush;
+	batch->userData = userData;
+	memset(&batch->stats, 0, sizeof(SpriteBatchStats));
+}
+
+void UnloadSpriteBatch(SpriteBatch* batch)
+{
+	free(batch->quads);
+	free(batch->keys);
+	free(batch->flushBuffer);
+	memset(batch, 0, sizeof(SpriteBatch));
+}
+
+void BeginSpriteBatch(SpriteBatch* batch)
+{
+	batch->count = 0;
+	memset(&batch->stats, 0, sizeof(SpriteBatchStats));
+}
+
+void EndSpriteBatch(SpriteBatch* batch)
+{
+	int count = batch->count;
+	batch->stats.sprites = count;
+
+	//stable counting sort by layer into the second half of keys, then order each layer by sort key
+	//when it isn't already (particles all share one key and skip the sort)
+	unsigned long long* sorted = batch->keys + batch->capacity;
+	int layerStart[SPRITE_LAYER_COUNT + 1] = { 0 };
+	for (int i = 0; i < count; i++) layerStart[(batch->keys[i] >> 56) + 1]++;
+	for (int l = 0; l < SPRITE_LAYER_COUNT; l++) layerStart[l + 1] += layerStart[l];
+
+	int fill[SPRITE_LAYER_COUNT];
+	memcpy(fill, layerStart, sizeof(fill));
+	for (int i = 0; i < count; i++) sorted[fill[batch->keys[i] >> 56]++] = batch->keys[i];
+
+	for (int l = 0; l < SPRITE_LAYER_COUNT; l++)
+	{
+		unsigned long long* first = sorted + layerStart[l];
+		unsigned long long* last = sorted + layerStart[l + 1];
+		if (!std::is_sorted(first, last)) std::sort(first, last);
+	}
+
+	for (int l = 0; l < SPRITE_LAYER_COUNT; l++)
+	{
+		int run = 0;
+		for (int i = layerStart[l]; i < layerStart[l + 1]; i++)
+		{
+			int quad = (int)(sorted[i] & 0xFFFFFFFF);
+			memcpy(batch->flushBuffer + run * 4, batch->quads + quad * 4, 4 * sizeof(SpriteVertex));
+
+			if (++run == SPRITE_BATCH_MAX_QUADS)
+			{
+				FlushRun(batch, (SpriteLayer)l, run);
+				run = 0;
+			}
+		}
+		if (run > 0) FlushRun(batch, (SpriteLayer)l, run);
+	}
+
+	batch->count = 0;
+}
+
+bool SubmitSprite(SpriteBatch* batch, SpriteLayer layer, int sortKey, const AtlasSprite* sprite,
+	float x, float y, float width, float height, float originX, float originY, float degrees, unsigned int color)
+{
+	if (batch->count == batch->capacity) return false;
+
+	float u0 = sprite->x * batch->texelWidth, u1 = (sprite->x + sprite->width) * batch->texelWidth;
+	float v0 = sprite->y * batch->texelHeight, v1 = (sprite->y + sprite->height) * batch->texelHeight;
+
+	//corners relative to the origin, rotated like DrawTexturePro
+	float cx[4] = { -originX, -originX, width - originX, width - originX };
+	float cy[4] = { -originY, height - originY, height - originY, -originY };
+	float us[4] = { u0, u0, u1, u1 };
+	float vs[4] = { v0, v1, v1, v0 };
+
+	float c = 1, s = 0;
+	if (degrees != 0)
+	{
+		c = cosf(degrees * 3.14159265f / 180.0f);
+		s = sinf(degrees * 3.14159265f / 180.0f);
+	}
+
+	SpriteVertex* q = batch->quads + batch->count * 4;
+	for (int i = 0; i < 4; i++)
+		q[i] = { x + cx[i] * c - cy[i] * s, y + cx[i] * s + cy[i] * c, us[i], vs[i], color };
+
+	batch->keys[batch->count] = SpriteKey(layer, sortKey, batch->count);
+	batch->count++;
+	return true;
+}
+
+bool SubmitSpriteTriangle(SpriteBatch* batch, SpriteLayer layer, int sortKey, const AtlasSprite* sprite,
+	float x1, float y1, float x2, float y2, float x3, float y3, unsigned int color)
+{
+	if (batch->count == batch->capacity) return false;
+
+	float u = (sprite->x + sprite->width * 0.5f) * batch->texelWidth;
+	float v = (sprite->y + sprite->height * 0.5f) * batch->texelHeight;
+
+	//a quad with its last corner repeated, so triangles share the layer's draw call
+	SpriteVertex* q = batch->quads + batch->count * 4;
+	q[0] = { x1, y1, u, v, color };
+	q[1] = { x2, y2, u, v, color };
+	q[2] = { x3, y3, u, v, color };
+	q[3] = { x3, y3, u, v, color };
+
+	batch->keys[batch->count] = SpriteKey(layer, sortKey, batch->count);
+	batch->count++;
+	return true;
+}
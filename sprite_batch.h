@@ -0,0 +1,72 @@
+/*******************************************************************************************
+*
+*   Sprite Batch - sorted, layered submission of atlas sprites
+*
+*   Entities submit quads during the frame instead of drawing. EndSpriteBatch sorts them by
+*   layer and sort key and hands each layer to the flush callback as long vertex runs, so a
+*   layer costs a draw call per GPU batch rather than per sprite. The game flushes through
+*   rlgl in pieces of its batch size (smaller on GLES2), headless code just counts.
+*
+********************************************************************************************/
+
+#ifndef SPRITE_BATCH_H
+#define SPRITE_BATCH_H
+
+#include "sprite_atlas.h"
+
+#define SPRITE_BATCH_MAX_QUADS         8192     // Quads per flush, the callback splits it to its GPU batch size
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef enum SpriteLayer { LAYER_DEBRIS = 0, LAYER_TANKS, LAYER_PROJECTILES, LAYER_EFFECTS, LAYER_OVERLAY, SPRITE_LAYER_COUNT } SpriteLayer;    // Drawn in this order
+
+typedef struct SpriteVertex {
+	float x, y;
+	float u, v;
+	unsigned int color;             // RGBA bytes, as raylib's Color
+} SpriteVertex;
+
+// Quads as 4 vertices: top-left, bottom-left, bottom-right, top-right (RL_QUADS order)
+typedef void (*SpriteFlushCallback)(SpriteLayer layer, const SpriteVertex* vertices, int vertexCount, void* userData);
+
+typedef struct SpriteBatchStats {
+	int sprites;                    // Last frame
+	int drawCalls;
+	int vertices;
+} SpriteBatchStats;
+
+typedef struct SpriteBatch {
+	float texelWidth, texelHeight;  // 1 / atlas size
+
+	SpriteVertex* quads;            // 4 per submitted sprite, in submission order
+	unsigned long long* keys;       // Layer, sort key and quad index packed for one sort
+	int count;
+	int capacity;
+
+	SpriteVertex* flushBuffer;      // SPRITE_BATCH_MAX_QUADS quads
+
+	SpriteFlushCallback flush;
+	void* userData;
+	SpriteBatchStats stats;
+} SpriteBatch;
+
+//----------------------------------------------------------------------------------
+// Sprite Batch Functions Declaration
+//----------------------------------------------------------------------------------
+void InitSpriteBatch(SpriteBatch* batch, int capacity, int atlasWidth, int atlasHeight, SpriteFlushCallback flush, void* userData);
+void UnloadSpriteBatch(SpriteBatch* batch);
+
+void BeginSpriteBatch(SpriteBatch* batch);
+void EndSpriteBatch(SpriteBatch* batch);      // Sort and flush everything submitted since Begin
+
+// Sprite scaled to width x height, rotated by degrees around (originX, originY) of the scaled sprite, like DrawTexturePro
+// Lower sort keys draw first within a layer, returns false once the batch is full
+bool SubmitSprite(SpriteBatch* batch, SpriteLayer layer, int sortKey, const AtlasSprite* sprite,
+	float x, float y, float width, float height, float originX, float originY, float degrees, unsigned int color);
+
+// Flat triangle textured from the middle of sprite (use a solid one)
+bool SubmitSpriteTriangle(SpriteBatch* batch, SpriteLayer layer, int sortKey, const AtlasSprite* sprite,
+	float x1, float y1, float x2, float y2, float x3, float y3, unsigned int color);
+
+#endif // SPRITE_BATCH_H
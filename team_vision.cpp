@@ -0,0 +1,485 @@
+/*******************************************************************************************
+*
+*   Team Vision - per-team visibility and fog of war from bit-row shadowcasting
+*
+********************************************************************************************/
+
+#include "team_vision.h"
+#include "parallel_for.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition (local)
+//----------------------------------------------------------------------------------
+static inline bool GetBit(const unsigned long long* line, int pos)
+{
+	return (line[pos >> 6] >> (pos & 63)) & 1;
+}
+
+// First position in [from, to) whose bit is value, to if none
+static int FindBit(const unsigned long long* line, int from, int to, bool value)
+{
+	if (from >= to) return to;
+
+	unsigned long long flip = value ? 0 : ~0ull;
+	int word = from >> 6;
+	unsigned long long bits = (line[word] ^ flip) & (~0ull << (from & 63));
+	while (bits == 0)
+	{
+		if (++word << 6 >= to) return to;
+		bits = line[word] ^ flip;
+	}
+
+	int pos = (word << 6) + __builtin_ctzll(bits);
+	return pos < to ? pos : to;
+}
+
+static void SetBits(unsigned long long* line, int from, int to)
+{
+	//[from, to)
+	while (from < to)
+	{
+		int word = from >> 6, bit = from & 63;
+		int n = to - from < 64 - bit ? to - from : 64 - bit;
+		unsigned long long run = n == 64 ? ~0ull : ((1ull << n) - 1) << bit;
+		line[word] |= run;
+		from += n;
+	}
+}
+
+// Rounded a / b for b > 0, halves away from zero
+static inline int RoundDiv(int a, int b)
+{
+	return a >= 0 ? (2 * a + b) / (2 * b) : -((-2 * a + b) / (2 * b));
+}
+
+static inline int CeilDiv(int a, int b)
+{
+	return a >= 0 ? (a + b - 1) / b : -(-a / b);
+}
+
+static void PackRows(TeamVision* vision, int x0, int y0, int x1, int y1)
+{
+	int w0 = x0 >> 6, w1 = (x1 + 63) >> 6;
+	for (int y = y0; y < y1; y++)
+		for (int w = w0; w < w1; w++)
+		{
+			unsigned long long word = 0;
+			int end = (w + 1) * 64 < vision->width ? (w + 1) * 64 : vision->width;
+			for (int x = w * 64; x < end; x++)
+				if (vision->mask[y * vision->width + x]) word |= 1ull << (x & 63);
+			vision->rowBits[y * vision->wordsPerRow + w] = word;
+		}
+}
+
+static void PackColumns(TeamVision* vision, int x0, int y0, int x1, int y1)
+{
+	int w0 = y0 >> 6, w1 = (y1 + 63) >> 6;
+	for (int x = x0; x < x1; x++)
+		for (int w = w0; w < w1; w++)
+		{
+			unsigned long long word = 0;
+			int end = (w + 1) * 64 < vision->height ? (w + 1) * 64 : vision->height;
+			for (int y = w * 64; y < end; y++)
+				if (vision->mask[y * vision->width + x]) word |= 1ull << (y & 63);
+			vision->columnBits[x * vision->wordsPerColumn + w] = word;
+		}
+}
+
+static void MarkWindowTiles(TeamVision* vision, const VisionUnit* unit)
+{
+	int size = 2 * vision->radius + 1;
+	int tx0 = unit->windowX < 0 ? 0 : unit->windowX / VISION_TILE_SIZE;
+	int ty0 = unit->windowY < 0 ? 0 : unit->windowY / VISION_TILE_SIZE;
+	int tx1 = (unit->windowX + size - 1) / VISION_TILE_SIZE, ty1 = (unit->windowY + size - 1) / VISION_TILE_SIZE;
+	if (tx1 >= vision->tilesX) tx1 = vision->tilesX - 1;
+	if (ty1 >= vision->tilesY) ty1 = vision->tilesY - 1;
+
+	bool* dirty = vision->dirtyTiles[unit->team];
+	for (int ty = ty0; ty <= ty1; ty++)
+		for (int tx = tx0; tx <= tx1; tx++) dirty[ty * vision->tilesX + tx] = true;
+}
+
+// Symmetric shadowcasting over one quadrant, lines are rows (vertical) or columns, direction +-1
+static void CastQuadrant(const TeamVision* vision, VisionUnit* unit, float* slopes, bool vertical, int direction)
+{
+	const unsigned long long* lines = vertical ? vision->rowBits : vision->columnBits;
+	int lineWords = vertical ? vision->wordsPerRow : vision->wordsPerColumn;
+	int lineLength = vertical ? vision->width : vision->height;
+	int lineCount = vertical ? vision->height : vision->width;
+	int center = vertical ? unit->x : unit->y;
+	int origin = vertical ? unit->y : unit->x;
+	int radius = vision->radius;
+
+	float* current = slopes;
+	float* next = slopes + 2 * (radius + 2);
+	current[0] = -1;
+	current[1] = 1;
+	int count = 1;
+
+	for (int depth = 1; depth <= radius && count > 0; depth++)
+	{
+		int line = origin + direction * depth;
+		if (line < 0 || line >= lineCount) break;
+
+		const unsigned long long* bits = lines + (size_t)line * lineWords;
+		int reach = (int)sqrtf((float)(radius * radius - depth * depth));
+		int nextCount = 0;
+
+		for (int i = 0; i < count; i++)
+		{
+			float start = current[2 * i], end = current[2 * i + 1];
+			int lo = center + (int)floorf(depth * start + 0.5f);
+			int hi = center + (int)ceilf(depth * end - 0.5f);
+			if (lo < center - reach) lo = center - reach;
+			if (hi > center + reach) hi = center + reach;
+			if (lo < 0) lo = 0;
+			if (hi > lineLength - 1) hi = lineLength - 1;
+
+			//walls are seen, open runs only where the centres are inside the interval
+			for (int pos = lo; pos <= hi; )
+			{
+				bool wall = GetBit(bits, pos);
+				int last = FindBit(bits, pos, hi + 1, !wall) - 1;
+				int a = pos, b = last;
+				if (!wall)
+				{
+					if (a - center < depth * start) a++;
+					if (b - center > depth * end) b--;
+
+					float childStart = pos == lo ? start : (2 * (pos - center) - 1) / (2.0f * depth);
+					float childEnd = last == hi ? end : (2 * (last - center) + 1) / (2.0f * depth);
+					if (childStart < childEnd)
+					{
+						next[2 * nextCount] = childStart;
+						next[2 * nextCount + 1] = childEnd;
+						nextCount++;
+					}
+				}
+
+				if (a <= b)
+				{
+					if (vertical) SetBits(unit->window + (size_t)(line - unit->windowY) * vision->windowWords, a - unit->windowX, b + 1 - unit->windowX);
+					else
+					{
+						int bx = line - unit->windowX;
+						for (int y = a; y <= b; y++) unit->window[(size_t)(y - unit->windowY) * vision->windowWords + (bx >> 6)] |= 1ull << (bx & 63);
+					}
+				}
+				pos = last + 1;
+			}
+		}
+
+		float* swap = current;
+		current = next;
+		next = swap;
+		count = nextCount;
+	}
+}
+
+static void CastUnit(const TeamVision* vision, VisionUnit* unit, float* slopes)
+{
+	int size = 2 * vision->radius + 1;
+	unit->windowX = unit->x - vision->radius;
+	unit->windowY = unit->y - vision->radius;
+	memset(unit->window, 0, (size_t)size * vision->windowWords * sizeof(unsigned long long));
+
+	if ((unsigned int)unit->x < (unsigned int)vision->width && (unsigned int)unit->y < (unsigned int)vision->height)
+	{
+		unit->window[(size_t)vision->radius * vision->windowWords + (vision->radius >> 6)] |= 1ull << (vision->radius & 63);
+		CastQuadrant(vision, unit, slopes, true, -1);
+		CastQuadrant(vision, unit, slopes, true, 1);
+		CastQuadrant(vision, unit, slopes, false, -1);
+		CastQuadrant(vision, unit, slopes, false, 1);
+	}
+	unit->cast = true;
+}
+
+// One parallel chunk of the cast list, the chunk index picks its scratch
+static void CastUnits(int begin, int end, void* data)
+{
+	TeamVision* vision = (TeamVision*)data;
+	float* slopes = vision->slopes + (size_t)(begin / VISION_CAST_GRAIN) * 4 * (vision->radius + 2);
+	for (int i = begin; i < end; i++) CastUnit(vision, &vision->units[vision->castList[i]], slopes);
+}
+
+// 64 window bits from bit offset, zero outside the row
+static inline unsigned long long WindowBits(const unsigned long long* row, int words, int offset)
+{
+	if (offset <= -64) return 0;
+	if (offset < 0) return row[0] << -offset;
+
+	int word = offset >> 6, shift = offset & 63;
+	if (word >= words) return 0;
+	unsigned long long bits = row[word] >> shift;
+	if (shift != 0 && word + 1 < words) bits |= row[word + 1] << (64 - shift);
+	return bits;
+}
+
+static void ComposeTile(TeamVision* vision, int team, int tx, int ty)
+{
+	int y0 = ty * VISION_TILE_SIZE;
+	int y1 = y0 + VISION_TILE_SIZE < vision->height ? y0 + VISION_TILE_SIZE : vision->height;
+	int x0 = tx * VISION_TILE_SIZE;
+	int size = 2 * vision->radius + 1;
+
+	unsigned long long* visible = vision->visible[team];
+	unsigned long long* explored = vision->explored[team];
+	for (int y = y0; y < y1; y++) visible[y * vision->wordsPerRow + tx] = 0;
+
+	for (int u = 0; u < vision->unitCapacity; u++)
+	{
+		const VisionUnit* unit = &vision->units[u];
+		if (!unit->active || !unit->cast || unit->team != team) continue;
+		if (unit->windowX >= x0 + VISION_TILE_SIZE || unit->windowX + size <= x0) continue;
+
+		int r0 = unit->windowY > y0 ? unit->windowY : y0;
+		int r1 = unit->windowY + size < y1 ? unit->windowY + size : y1;
+		for (int y = r0; y < r1; y++)
+		{
+			unsigned long long bits = WindowBits(unit->window + (size_t)(y - unit->windowY) * vision->windowWords, vision->windowWords, x0 - unit->windowX);
+			visible[y * vision->wordsPerRow + tx] |= bits;
+			explored[y * vision->wordsPerRow + tx] |= bits;
+		}
+	}
+}
+
+// One parallel chunk of the compose list, tiles are disjoint words of the team masks
+static void ComposeTiles(int begin, int end, void* data)
+{
+	TeamVision* vision = (TeamVision*)data;
+	int tiles = vision->tilesX * vision->tilesY;
+	for (int i = begin; i < end; i++)
+	{
+		int team = vision->composeList[i] / tiles, t = vision->composeList[i] % tiles;
+		ComposeTile(vision, team, t % vision->tilesX, t / vision->tilesX);
+	}
+}
+
+// Any solid pixel in [from, to] of a line, the map ends count as open
+static bool AnySolid(const unsigned long long* line, int length, int from, int to)
+{
+	if (from > to)
+	{
+		int swap = from;
+		from = to;
+		to = swap;
+	}
+	if (from < 0) from = 0;
+	if (to > length - 1) to = length - 1;
+	return from <= to && FindBit(line, from, to + 1, true) <= to;
+}
+
+// Pixels strictly between the ends, as runs along the major axis sharing one minor coordinate
+static bool LineClear(const TeamVision* vision, int x0, int y0, int x1, int y1)
+{
+	int dx = x1 - x0, dy = y1 - y0;
+	bool horizontal = (dx < 0 ? -dx : dx) >= (dy < 0 ? -dy : dy);
+
+	int major = horizontal ? (dx < 0 ? -dx : dx) : (dy < 0 ? -dy : dy);
+	int minor = horizontal ? (dy < 0 ? -dy : dy) : (dx < 0 ? -dx : dx);
+	int majorStep = horizontal ? (dx < 0 ? -1 : 1) : (dy < 0 ? -1 : 1);
+	int minorStep = horizontal ? (dy < 0 ? -1 : 1) : (dx < 0 ? -1 : 1);
+	int majorStart = horizontal ? x0 : y0, minorStart = horizontal ? y0 : x0;
+	if (major < 2) return true;
+
+	const unsigned long long* lines = horizontal ? vision->rowBits : vision->columnBits;
+	int lineWords = horizontal ? vision->wordsPerRow : vision->wordsPerColumn;
+	int lineLength = horizontal ? vision->width : vision->height;
+	int lineCount = horizontal ? vision->height : vision->width;
+
+	//step m in [1, major - 1] sits at minor offset RoundDiv(m * minor, major)
+	int kFirst = RoundDiv(minor, major), kLast = RoundDiv((major - 1) * minor, major);
+	for (int k = kFirst; k <= kLast; k++)
+	{
+		int m0 = minor == 0 ? 1 : CeilDiv((2 * k - 1) * major, 2 * minor);
+		int m1 = minor == 0 ? major - 1 : CeilDiv((2 * k + 1) * major, 2 * minor) - 1;
+		if (m0 < 1) m0 = 1;
+		if (m1 > major - 1) m1 = major - 1;
+		if (m0 > m1) continue;
+
+		int line = minorStart + minorStep * k;
+		if (line < 0 || line >= lineCount) continue;
+		if (AnySolid(lines + (size_t)line * lineWords, lineLength, majorStart + majorStep * m0, majorStart + majorStep * m1)) return false;
+	}
+	return true;
+}
+
+//----------------------------------------------------------------------------------
+// Team Vision Functions Definition
+//----------------------------------------------------------------------------------
+void InitTeamVision(TeamVision* vision, const int* mask, int width, int height, int teamCount, int radius, int unitCapacity)
+{
+	vision->mask = mask;
+	vision->width = width;
+	vision->height = height;
+	vision->radius = radius;
+	vision->teamCount = teamCount > VISION_MAX_TEAMS ? VISION_MAX_TEAMS : teamCount;
+
+	vision->wordsPerRow = (width + 63) / 64;
+	vision->wordsPerColumn = (height + 63) / 64;
+	vision->rowBits = (unsigned long long*)calloc((size_t)vision->wordsPerRow * height, sizeof(unsigned long long));
+	vision->columnBits = (unsigned long long*)calloc((size_t)vision->wordsPerColumn * width, sizeof(unsigned long long));
+	PackRows(vision, 0, 0, width, height);
+	PackColumns(vision, 0, 0, width, height);
+
+	vision->windowWords = (2 * radius + 1 + 63) / 64;
+	vision->unitCapacity = unitCapacity;
+	vision->units = (VisionUnit*)calloc(unitCapacity, sizeof(VisionUnit));
+
+	vision->tilesX = (width + VISION_TILE_SIZE - 1) / VISION_TILE_SIZE;
+	vision->tilesY = (height + VISION_TILE_SIZE - 1) / VISION_TILE_SIZE;
+	for (int t = 0; t < VISION_MAX_TEAMS; t++)
+	{
+		bool used = t < vision->teamCount;
+		vision->visible[t] = used ? (unsigned long long*)calloc((size_t)vision->wordsPerRow * height, sizeof(unsigned long long)) : nullptr;
+		vision->explored[t] = used ? (unsigned long long*)calloc((size_t)vision->wordsPerRow * height, sizeof(unsigned long long)) : nullptr;
+		vision->dirtyTiles[t] = used ? (bool*)calloc(vision->tilesX * vision->tilesY, sizeof(bool)) : nullptr;
+	}
+
+	vision->castList = (int*)malloc(unitCapacity * sizeof(int));
+	vision->composeList = (int*)malloc((size_t)vision->teamCount * vision->tilesX * vision->tilesY * sizeof(int));
+	vision->slopes = (float*)malloc((size_t)(unitCapacity / VISION_CAST_GRAIN + 1) * 4 * (radius + 2) * sizeof(float));
+	memset(&vision->stats, 0, sizeof(VisionStats));
+}
+
+void UnloadTeamVision(TeamVision* vision)
+{
+	for (int u = 0; u < vision->unitCapacity; u++) free(vision->units[u].window);
+	for (int t = 0; t < VISION_MAX_TEAMS; t++)
+	{
+		free(vision->visible[t]);
+		free(vision->explored[t]);
+		free(vision->dirtyTiles[t]);
+		vision->visible[t] = nullptr;
+		vision->explored[t] = nullptr;
+		vision->dirtyTiles[t] = nullptr;
+	}
+	free(vision->units);
+	free(vision->rowBits);
+	free(vision->columnBits);
+	free(vision->castList);
+	free(vision->composeList);
+	free(vision->slopes);
+	vision->units = nullptr;
+}
+
+void OnTerrainChangedVision(const TerrainRect* rects, int count, unsigned int version, void* vision)
+{
+	TeamVision* v = (TeamVision*)vision;
+	int size = 2 * v->radius + 1;
+	for (int i = 0; i < count; i++)
+	{
+		TerrainRect r = rects[i];
+		PackRows(v, r.x, r.y, r.x + r.width, r.y + r.height);
+		PackColumns(v, r.x, r.y, r.x + r.width, r.y + r.height);
+
+		//every unit whose window holds part of the change sees it differently now
+		for (int u = 0; u < v->unitCapacity; u++)
+		{
+			VisionUnit* unit = &v->units[u];
+			if (!unit->active || !unit->cast) continue;
+			if (unit->windowX < r.x + r.width && unit->windowX + size > r.x && unit->windowY < r.y + r.height && unit->windowY + size > r.y)
+				unit->dirty = true;
+		}
+	}
+}
+
+int AddVisionUnit(TeamVision* vision, int team, int x, int y)
+{
+	if (team < 0 || team >= vision->teamCount) return -1;
+
+	for (int u = 0; u < vision->unitCapacity; u++)
+	{
+		VisionUnit* unit = &vision->units[u];
+		if (unit->active) continue;
+
+		if (unit->window == nullptr)
+			unit->window = (unsigned long long*)malloc((size_t)(2 * vision->radius + 1) * vision->windowWords * sizeof(unsigned long long));
+		unit->active = true;
+		unit->dirty = true;
+		unit->cast = false;
+		unit->team = team;
+		unit->x = x;
+		unit->y = y;
+		return u;
+	}
+	return -1;
+}
+
+void RemoveVisionUnit(TeamVision* vision, int unit)
+{
+	VisionUnit* u = &vision->units[unit];
+	if (u->cast) MarkWindowTiles(vision, u);
+	u->active = false;
+	u->cast = false;
+}
+
+void MoveVisionUnit(TeamVision* vision, int unit, int x, int y)
+{
+	VisionUnit* u = &vision->units[unit];
+	if (u->x == x && u->y == y) return;
+
+	u->x = x;
+	u->y = y;
+	u->dirty = true;
+}
+
+void UpdateTeamVision(TeamVision* vision)
+{
+	vision->stats.unitsCast = 0;
+	vision->stats.tilesComposed = 0;
+
+	//the tiles a dirty unit no longer sees, then its new view cast in parallel and the tiles it sees now
+	int castCount = 0;
+	for (int u = 0; u < vision->unitCapacity; u++)
+	{
+		VisionUnit* unit = &vision->units[u];
+		if (!unit->active || !unit->dirty) continue;
+
+		if (unit->cast) MarkWindowTiles(vision, unit);
+		vision->castList[castCount++] = u;
+	}
+
+	ParallelFor(castCount, VISION_CAST_GRAIN, CastUnits, vision);
+
+	for (int i = 0; i < castCount; i++)
+	{
+		VisionUnit* unit = &vision->units[vision->castList[i]];
+		MarkWindowTiles(vision, unit);
+		unit->dirty = false;
+	}
+	vision->stats.unitsCast = castCount;
+
+	int tiles = vision->tilesX * vision->tilesY, composeCount = 0;
+	for (int team = 0; team < vision->teamCount; team++)
+		for (int t = 0; t < tiles; t++)
+		{
+			if (!vision->dirtyTiles[team][t]) continue;
+			vision->composeList[composeCount++] = team * tiles + t;
+			vision->dirtyTiles[team][t] = false;
+		}
+
+	ParallelFor(composeCount, 1, ComposeTiles, vision);
+	vision->stats.tilesComposed = composeCount;
+}
+
+bool IsVisibleToTeam(const TeamVision* vision, int team, int x, int y)
+{
+	if ((unsigned int)x >= (unsigned int)vision->width || (unsigned int)y >= (unsigned int)vision->height) return false;
+	return GetBit(vision->visible[team] + (size_t)y * vision->wordsPerRow, x);
+}
+
+bool IsExploredByTeam(const TeamVision* vision, int team, int x, int y)
+{
+	if ((unsigned int)x >= (unsigned int)vision->width || (unsigned int)y >= (unsigned int)vision->height) return false;
+	return GetBit(vision->explored[team] + (size_t)y * vision->wordsPerRow, x);
+}
+
+void QueryLineOfSight(const TeamVision* vision, const int* x0s, const int* y0s, const int* x1s, const int* y1s, int count, bool* clear)
+{
+	for (int i = 0; i < count; i++) clear[i] = LineClear(vision, x0s[i], y0s[i], x1s[i], y1s[i]);
+}
@@ -0,0 +1,94 @@
+/*******************************************************************************************
+*
+*   Team Vision - per-team visibility and fog of war from bit-row shadowcasting
+*
+*   The terrain is packed twice, by rows and by columns, 64 pixels per word. A unit's view
+*   is symmetric shadowcasting in four quadrants out to the team radius: the up and down
+*   quadrants walk row words, left and right walk column words, and each scanned line is
+*   split into wall and open runs with bit scans instead of pixel by pixel. The result is
+*   the unit's own bit window around it.
+*
+*   A team's visible mask is the OR of its units' windows, kept per 64x64 tile (one word
+*   wide), and only tiles under a window that changed are recomposed. A unit is recast
+*   when it moves or when a terrain change reaches its window. Explored keeps everything
+*   a team has ever seen. Dirty units are cast in parallel on the thread pool, each chunk
+*   of units with its own scratch and writing only its units' windows, then the dirty
+*   tiles are composed in parallel; the result does not depend on the thread count.
+*   Line-of-sight queries test the pixels a line crosses as runs of
+*   row or column bits, endpoints excluded.
+*
+********************************************************************************************/
+
+#ifndef TEAM_VISION_H
+#define TEAM_VISION_H
+
+#include "terrain_events.h"
+
+#define VISION_MAX_TEAMS                 4
+#define VISION_TILE_SIZE                64      // One word of a mask row
+#define VISION_CAST_GRAIN                4       // Units per parallel cast chunk
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct VisionUnit {
+	bool active;
+	bool dirty;                     // Moved or its view changed since the last cast
+	bool cast;                      // window holds a view
+	int team;
+	int x, y;                       // Eye
+	int windowX, windowY;           // Map position of the window's top-left, as of the last cast
+	unsigned long long* window;     // (2 * radius + 1) rows of windowWords
+} VisionUnit;
+
+typedef struct VisionStats {
+	int unitsCast;                  // Last update
+	int tilesComposed;
+} VisionStats;
+
+typedef struct TeamVision {
+	const int* mask;                // 1 = solid, not owned
+	int width, height;
+	int radius;
+	int teamCount;
+
+	int wordsPerRow, wordsPerColumn;
+	unsigned long long* rowBits;    // Occupancy, row-major
+	unsigned long long* columnBits; // Occupancy, column-major
+
+	int windowWords;                // Per window row
+	int unitCapacity;
+	VisionUnit* units;
+
+	int tilesX, tilesY;
+	unsigned long long* visible[VISION_MAX_TEAMS];     // Row-major, wordsPerRow per row
+	unsigned long long* explored[VISION_MAX_TEAMS];
+	bool* dirtyTiles[VISION_MAX_TEAMS];
+
+	int* castList;                  // Units being cast this update
+	int* composeList;               // team * tiles + tile being composed this update
+	float* slopes;                  // Shadowcasting scratch, two rows of intervals per cast chunk
+	VisionStats stats;
+} TeamVision;
+
+//----------------------------------------------------------------------------------
+// Team Vision Functions Declaration
+//----------------------------------------------------------------------------------
+void InitTeamVision(TeamVision* vision, const int* mask, int width, int height, int teamCount, int radius, int unitCapacity);
+void UnloadTeamVision(TeamVision* vision);
+
+void OnTerrainChangedVision(const TerrainRect* rects, int count, unsigned int version, void* vision);   // Terrain events subscriber
+
+int AddVisionUnit(TeamVision* vision, int team, int x, int y);     // Returns the unit id, -1 if full
+void RemoveVisionUnit(TeamVision* vision, int unit);
+void MoveVisionUnit(TeamVision* vision, int unit, int x, int y);   // Only a real move marks it for recasting
+
+void UpdateTeamVision(TeamVision* vision);      // Recast dirty units and recompose the tiles they touch
+
+bool IsVisibleToTeam(const TeamVision* vision, int team, int x, int y);
+bool IsExploredByTeam(const TeamVision* vision, int team, int x, int y);
+
+// clear[i] set when no solid pixel lies strictly between (x0s[i], y0s[i]) and (x1s[i], y1s[i])
+void QueryLineOfSight(const TeamVision* vision, const int* x0s, const int* y0s, const int* x1s, const int* y1s, int count, bool* clear);
+
+#endif // TEAM_VISION_H
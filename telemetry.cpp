@@ -0,0 +1,220 @@
+/*******************************************************************************************
+*
+*   Telemetry - per-tick simulation recorder for offline analysis
+*
+********************************************************************************************/
+
+#include "telemetry.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#if !defined(PLATFORM_WEB)
+	#include <thread>
+	#include <chrono>
+#endif
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct TelemetryRing {
+	alignas(64) std::atomic<unsigned int> head;     // Next slot the game thread writes
+	alignas(64) std::atomic<unsigned int> tail;     // Next slot the writer reads
+	alignas(64) unsigned int* records;              // TELEMETRY_RING_SIZE x columns words
+	int columns;
+} TelemetryRing;
+
+//----------------------------------------------------------------------------------
+// Module Variables Definition (local)
+//----------------------------------------------------------------------------------
+static const TelemetryColumn tickColumns[] = {
+	{ "tick", false }, { "player_x", true }, { "player_y", true }, { "player_tilt", true }, { "player_action", false },
+	{ "ball_active", false }, { "ball_x", true }, { "ball_y", true }, { "carves", false },
+	{ "input_ms", true }, { "logic_ms", true }, { "flush_ms", true }, { "draw_ms", true },
+};
+static const TelemetryColumn carveColumns[] = {
+	{ "tick", false }, { "x", false }, { "y", false }, { "width", false }, { "height", false },
+};
+
+static_assert(sizeof(TelemetryTick) == sizeof(tickColumns) / sizeof(TelemetryColumn) * 4, "one 4-byte field per tick column");
+static_assert(sizeof(TelemetryCarve) == sizeof(carveColumns) / sizeof(TelemetryColumn) * 4, "one 4-byte field per carve column");
+
+static TelemetryRing rings[TELEMETRY_KIND_COUNT];
+static FILE* file = nullptr;
+static std::atomic<bool> running(false);
+static std::atomic<bool> stopping(false);
+static std::atomic<long> recorded(0), dropped(0), bytesWritten(0);
+
+#if !defined(PLATFORM_WEB)
+static std::thread writer;
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition (local)
+//----------------------------------------------------------------------------------
+static void PushRecord(TelemetryRing* ring, const void* record)
+{
+	unsigned int head = ring->head.load(std::memory_order_relaxed);
+	if (head - ring->tail.load(std::memory_order_acquire) == TELEMETRY_RING_SIZE)
+	{
+		dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	memcpy(ring->records + (head & (TELEMETRY_RING_SIZE - 1)) * ring->columns, record, ring->columns * 4);
+	ring->head.store(head + 1, std::memory_order_release);
+	recorded.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Move up to maxRows records from the ring into column-major storage, returns rows moved
+static int DrainRing(TelemetryRing* ring, unsigned int* block, int row, int maxRows)
+{
+	unsigned int tail = ring->tail.load(std::memory_order_relaxed);
+	unsigned int available = ring->head.load(std::memory_order_acquire) - tail;
+	int rows = (int)available < maxRows ? (int)available : maxRows;
+
+	for (int r = 0; r < rows; r++)
+	{
+		const unsigned int* record = ring->records + ((tail + r) & (TELEMETRY_RING_SIZE - 1)) * ring->columns;
+		for (int c = 0; c < ring->columns; c++) block[c * TELEMETRY_BLOCK_ROWS + row + r] = record[c];
+	}
+
+	ring->tail.store(tail + rows, std::memory_order_release);
+	return rows;
+}
+
+static void WriteBlock(int kind, const unsigned int* block, int rows, int columns)
+{
+	unsigned int header[2] = { (unsigned int)kind, (unsigned int)rows };
+	fwrite(header, 4, 2, file);
+	for (int c = 0; c < columns; c++) fwrite(block + c * TELEMETRY_BLOCK_ROWS, 4, rows, file);
+	fflush(file);
+
+	bytesWritten.fetch_add(8 + (long)rows * columns * 4, std::memory_order_relaxed);
+}
+
+#if !defined(PLATFORM_WEB)
+static void WriterLoop()
+{
+	unsigned int* blocks[TELEMETRY_KIND_COUNT];
+	int rows[TELEMETRY_KIND_COUNT] = { 0 };
+	for (int k = 0; k < TELEMETRY_KIND_COUNT; k++)
+		blocks[k] = (unsigned int*)malloc((size_t)rings[k].columns * TELEMETRY_BLOCK_ROWS * 4);
+
+	for (;;)
+	{
+		bool stop = stopping.load(std::memory_order_acquire);
+		int moved = 0;
+
+		for (int k = 0; k < TELEMETRY_KIND_COUNT; k++)
+		{
+			int n = DrainRing(&rings[k], blocks[k], rows[k], TELEMETRY_BLOCK_ROWS - rows[k]);
+			rows[k] += n;
+			moved += n;
+
+			if (rows[k] == TELEMETRY_BLOCK_ROWS)
+			{
+				WriteBlock(k, blocks[k], rows[k], rings[k].columns);
+				rows[k] = 0;
+			}
+		}
+
+		//stop was seen before this drain, so nothing recorded before StopTelemetry is left behind
+		if (stop && moved == 0) break;
+		if (moved == 0) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	for (int k = 0; k < TELEMETRY_KIND_COUNT; k++)
+	{
+		if (rows[k] > 0) WriteBlock(k, blocks[k], rows[k], rings[k].columns);
+		free(blocks[k]);
+	}
+}
+#endif
+
+//----------------------------------------------------------------------------------
+// Telemetry Functions Definition
+//----------------------------------------------------------------------------------
+bool StartTelemetry(const char* path)
+{
+#if defined(PLATFORM_WEB)
+	return false;       // No writer thread and nowhere to keep the file
+#else
+	if (running.load()) return false;
+
+	file = fopen(path, "wb");
+	if (file == nullptr) return false;
+
+	unsigned int header[2];
+	memcpy(header, "TLM1", 4);
+	header[1] = TELEMETRY_VERSION;
+	fwrite(header, 4, 2, file);
+
+	for (int k = 0; k < TELEMETRY_KIND_COUNT; k++)
+	{
+		const TelemetryColumn* columns;
+		rings[k].columns = GetTelemetryColumns((TelemetryKind)k, &columns);
+		rings[k].records = (unsigned int*)malloc((size_t)rings[k].columns * TELEMETRY_RING_SIZE * 4);
+		rings[k].head.store(0);
+		rings[k].tail.store(0);
+	}
+
+	recorded.store(0);
+	dropped.store(0);
+	bytesWritten.store(8);
+	stopping.store(false);
+	running.store(true);
+	writer = std::thread(WriterLoop);
+	return true;
+#endif
+}
+
+void StopTelemetry(void)
+{
+#if !defined(PLATFORM_WEB)
+	if (!running.load()) return;
+
+	running.store(false);
+	stopping.store(true, std::memory_order_release);
+	writer.join();
+
+	fclose(file);
+	file = nullptr;
+	for (int k = 0; k < TELEMETRY_KIND_COUNT; k++)
+	{
+		free(rings[k].records);
+		rings[k].records = nullptr;
+	}
+#endif
+}
+
+bool IsTelemetryRunning(void)
+{
+	return running.load(std::memory_order_relaxed);
+}
+
+void RecordTelemetryTick(const TelemetryTick* tick)
+{
+	if (running.load(std::memory_order_relaxed)) PushRecord(&rings[TELEMETRY_TICK], tick);
+}
+
+void RecordTelemetryCarve(const TelemetryCarve* carve)
+{
+	if (running.load(std::memory_order_relaxed)) PushRecord(&rings[TELEMETRY_CARVE], carve);
+}
+
+TelemetryStats GetTelemetryStats(void)
+{
+	return { recorded.load(), dropped.load(), bytesWritten.load() };
+}
+
+int GetTelemetryColumns(TelemetryKind kind, const TelemetryColumn** columns)
+{
+	switch (kind)
+	{
+		case TELEMETRY_TICK: *columns = tickColumns; return sizeof(tickColumns) / sizeof(TelemetryColumn);
+		case TELEMETRY_CARVE: *columns = carveColumns; return sizeof(carveColumns) / sizeof(TelemetryColumn);
+		default: *columns = nullptr; return 0;
+	}
+}
@@ -0,0 +1,74 @@
+/*******************************************************************************************
+*
+*   Telemetry - per-tick simulation recorder for offline analysis
+*
+*   The game thread pushes fixed-size records into single-producer single-consumer ring
+*   buffers, never blocking: a full ring drops the record and counts it. A background
+*   thread drains the rings and writes them column by column in blocks, so recording can
+*   stay on in release builds. "telemetry_dump" turns a file back into CSV.
+*
+*   File layout, little endian:
+*       "TLM1", uint32 version
+*       blocks: uint32 kind (TelemetryKind), uint32 rows,
+*               then every column of the kind in order, rows x 4 bytes each
+*
+*   Every record field is 4 bytes wide, field order is column order.
+*
+********************************************************************************************/
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#define TELEMETRY_VERSION                 1
+#define TELEMETRY_RING_SIZE            4096     // Records per ring, power of two, ~68 s of ticks at 60 fps
+#define TELEMETRY_BLOCK_ROWS            512     // Rows per written block
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef enum TelemetryKind { TELEMETRY_TICK = 0, TELEMETRY_CARVE, TELEMETRY_KIND_COUNT } TelemetryKind;
+
+typedef enum TelemetryPhase { PHASE_INPUT = 0, PHASE_LOGIC, PHASE_FLUSH, PHASE_DRAW, TELEMETRY_PHASE_COUNT } TelemetryPhase;
+
+typedef struct TelemetryTick {
+	unsigned int tick;
+	float playerX, playerY;
+	float playerTilt;
+	int playerAction;
+	int ballActive;
+	float ballX, ballY;
+	int carves;                                 // Carves made this tick
+	float phaseMs[TELEMETRY_PHASE_COUNT];
+} TelemetryTick;
+
+typedef struct TelemetryCarve {
+	unsigned int tick;
+	int x, y;
+	int width, height;
+} TelemetryCarve;
+
+typedef struct TelemetryColumn {
+	const char* name;
+	bool isFloat;                               // Otherwise a 32-bit integer
+} TelemetryColumn;
+
+typedef struct TelemetryStats {
+	long recorded;
+	long dropped;                               // Ring was full
+	long bytesWritten;
+} TelemetryStats;
+
+//----------------------------------------------------------------------------------
+// Telemetry Functions Declaration
+//----------------------------------------------------------------------------------
+bool StartTelemetry(const char* path);          // Opens the file and starts the writer thread
+void StopTelemetry(void);                       // Drains what is left and closes the file
+bool IsTelemetryRunning(void);
+
+void RecordTelemetryTick(const TelemetryTick* tick);       // Game thread only
+void RecordTelemetryCarve(const TelemetryCarve* carve);
+
+TelemetryStats GetTelemetryStats(void);
+int GetTelemetryColumns(TelemetryKind kind, const TelemetryColumn** columns);   // Returns the column count
+
+#endif // TELEMETRY_H
@@ -0,0 +1,109 @@
+/*******************************************************************************************
+*
+*   telemetry_dump - export a recorded telemetry file to CSV
+*
+*   Usage: telemetry_dump <in.tlm> <out>
+*
+*   Writes <out>_tick.csv and <out>_carve.csv, one row per record with a header line of
+*   column names.
+*
+********************************************************************************************/
+
+#include "telemetry.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------------
+// Main entry point
+//----------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		printf("usage: %s <in.tlm> <out>\n", argv[0]);
+		return 1;
+	}
+
+	FILE* in = fopen(argv[1], "rb");
+	if (in == nullptr)
+	{
+		printf("telemetry_dump: can't open %s\n", argv[1]);
+		return 1;
+	}
+
+	unsigned int header[2];
+	if (fread(header, 4, 2, in) != 2 || memcmp(header, "TLM1", 4) != 0 || header[1] != TELEMETRY_VERSION)
+	{
+		printf("telemetry_dump: %s is not a version %d telemetry file\n", argv[1], TELEMETRY_VERSION);
+		fclose(in);
+		return 1;
+	}
+
+	const char* names[TELEMETRY_KIND_COUNT] = { "tick", "carve" };
+	FILE* out[TELEMETRY_KIND_COUNT];
+	long written[TELEMETRY_KIND_COUNT] = { 0 };
+	for (int k = 0; k < TELEMETRY_KIND_COUNT; k++)
+	{
+		char path[1024];
+		snprintf(path, sizeof(path), "%s_%s.csv", argv[2], names[k]);
+		out[k] = fopen(path, "w");
+		if (out[k] == nullptr)
+		{
+			printf("telemetry_dump: can't write %s\n", path);
+			return 1;
+		}
+
+		const TelemetryColumn* columns;
+		int count = GetTelemetryColumns((TelemetryKind)k, &columns);
+		for (int c = 0; c < count; c++) fprintf(out[k], "%s%s", c ? "," : "", columns[c].name);
+		fprintf(out[k], "\n");
+	}
+
+	bool ok = true;
+	unsigned int* block = (unsigned int*)malloc((size_t)TELEMETRY_BLOCK_ROWS * 64 * 4);
+	unsigned int blockHeader[2];
+	while (fread(blockHeader, 4, 2, in) == 2)
+	{
+		unsigned int kind = blockHeader[0], rows = blockHeader[1];
+		if (kind >= TELEMETRY_KIND_COUNT || rows > TELEMETRY_BLOCK_ROWS)
+		{
+			ok = false;
+			break;
+		}
+
+		const TelemetryColumn* columns;
+		int count = GetTelemetryColumns((TelemetryKind)kind, &columns);
+		if (fread(block, 4, (size_t)rows * count, in) != (size_t)rows * count)
+		{
+			ok = false;     // Truncated, keep what was complete
+			break;
+		}
+
+		//columns are stored one after the other, rows interleave them back
+		for (unsigned int r = 0; r < rows; r++)
+		{
+			for (int c = 0; c < count; c++)
+			{
+				unsigned int word = block[c * rows + r];
+				if (columns[c].isFloat)
+				{
+					float f;
+					memcpy(&f, &word, 4);
+					fprintf(out[kind], "%s%g", c ? "," : "", f);
+				}
+				else fprintf(out[kind], "%s%d", c ? "," : "", (int)word);
+			}
+			fprintf(out[kind], "\n");
+		}
+		written[kind] += rows;
+	}
+
+	printf("telemetry_dump: %ld ticks, %ld carves%s\n", written[TELEMETRY_TICK], written[TELEMETRY_CARVE], ok ? "" : ", file truncated");
+
+	free(block);
+	for (int k = 0; k < TELEMETRY_KIND_COUNT; k++) fclose(out[k]);
+	fclose(in);
+	return ok ? 0 : 1;
+}
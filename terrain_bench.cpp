@@ -0,0 +1,1920 @@
+/*******************************************************************************************
+*
+*   Terrain benchmarks - headless, no raylib or window required
+*
+*   Build with "make bench", run "./terrain_bench [name]" (no name runs everything).
+*
+********************************************************************************************/
+
+#include "debris.h"
+#include "spatial_hash.h"
+#include "occupancy_pyramid.h"
+#include "terrain_sdf.h"
+#include "terrain_normals.h"
+#include "terrain_tiles.h"
+#include "pixel_mask.h"
+#include "telemetry.h"
+#include "sprite_batch.h"
+#include "fixed_physics.h"
+#include "carve_queue.h"
+#include "terrain_bits.h"
+#include "trajectory_cache.h"
+#include "terrain_material.h"
+#include "thread_pool.h"
+#include "job_scheduler.h"
+#include "parallel_for.h"
+#include "match_checkpoint.h"
+#include "terrain_gen.h"
+#include "terrain_store.h"
+#include "terrain_contours.h"
+#include "nav_graph.h"
+#include "team_vision.h"
+#include "terrain_density.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include <chrono>
+#include <thread>
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition (local)
+//----------------------------------------------------------------------------------
+static double NowMs()
+{
+	using namespace std::chrono;
+	return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Flat ground at groundY with a few hills, every solid pixel a brownish colour
+static void MakeTestTerrain(int* mask, unsigned int* pixels, int width, int height, int groundY)
+{
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+		{
+			int hill = (x / 97 % 3) * 24;
+			int solid = y >= groundY - hill;
+			mask[y * width + x] = solid;
+			pixels[y * width + x] = solid ? 0xFF2F4F7Fu : 0;
+		}
+}
+
+//----------------------------------------------------------------------------------
+// Benchmarks
+//----------------------------------------------------------------------------------
+
+// 100k live particles must integrate and settle well inside a 16.6 ms frame
+static void BenchDebris()
+{
+	const int width = 4096, height = 1024, ticks = 600, target = 100000;
+
+	int* mask = (int*)calloc(width * height, sizeof(int));
+	unsigned int* pixels = (unsigned int*)calloc(width * height, sizeof(unsigned int));
+	MakeTestTerrain(mask, pixels, width, height, 900);
+
+	DebrisPool pool;
+	InitDebrisPool(&pool, DEBRIS_MAX_PARTICLES);
+
+	double total = 0, worst = 0;
+	long settled = 0, live = 0;
+	for (int t = 0; t < ticks; t++)
+	{
+		//keep the pool topped up, as a barrage would
+		for (int i = 0; pool.count < target; i++)
+		{
+			float x = (float)((t * 7919 + i * 104729) % width);
+			EmitDebris(&pool, x, 300.0f + (i % 200), x, 500.0f, 0xFF3366CCu);
+		}
+
+		TerrainRect dirty;
+		double t0 = NowMs();
+		settled += UpdateDebris(&pool, 9.81f / 60, mask, (unsigned char*)pixels, width, height, &dirty);
+		double dt = NowMs() - t0;
+
+		total += dt;
+		if (dt > worst) worst = dt;
+		live += pool.count;
+
+		//let the ground re-open so it never fills up
+		if (t % 60 == 59) MakeTestTerrain(mask, pixels, width, height, 900);
+	}
+
+	printf("debris: %d ticks, avg live %ld, avg %.3f ms/tick, worst %.3f ms, settled %ld px\n",
+		ticks, live / ticks, total / ticks, worst, settled);
+
+	UnloadDebrisPool(&pool);
+	free(mask);
+	free(pixels);
+}
+
+// 10k shells against 500 tanks: hashed rebuild + pair query versus the all-pairs check
+static void BenchSpatialHash()
+{
+	const int tanks = 500, shells = 10000, ticks = 120;
+	const float width = 16384, height = 2048;
+
+	SpatialEntry* ents = (SpatialEntry*)calloc(tanks + shells, sizeof(SpatialEntry));
+	unsigned int seed = 12345;
+	for (int i = 0; i < tanks + shells; i++)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		ents[i].x = (seed >> 8) % (int)width;
+		seed = seed * 1664525u + 1013904223u;
+		ents[i].y = (seed >> 8) % (int)height;
+		ents[i].radius = i < tanks ? 14.0f : 3.0f;
+		ents[i].kind = i < tanks ? SPATIAL_TANK : SPATIAL_PROJECTILE;
+	}
+
+	SpatialHash hash;
+	InitSpatialHash(&hash, 64, tanks + shells);
+	SpatialPair* pairs = (SpatialPair*)calloc(shells, sizeof(SpatialPair));
+
+	double hashed = 0, naive = 0;
+	long hashedHits = 0, naiveHits = 0;
+	for (int t = 0; t < ticks; t++)
+	{
+		for (int i = tanks; i < tanks + shells; i++) ents[i].y = fmodf(ents[i].y + 3.0f, height);
+
+		double t0 = NowMs();
+		ClearSpatialHash(&hash);
+		for (int i = 0; i < tanks + shells; i++)
+			AddSpatialEntry(&hash, (SpatialKind)ents[i].kind, i, ents[i].x, ents[i].y, ents[i].radius);
+		BuildSpatialHash(&hash);
+		hashedHits += QuerySpatialPairs(&hash, SPATIAL_TANK, SPATIAL_PROJECTILE, pairs, shells);
+		double t1 = NowMs();
+
+		for (int a = 0; a < tanks; a++)
+			for (int b = tanks; b < tanks + shells; b++)
+			{
+				float dx = ents[a].x - ents[b].x, dy = ents[a].y - ents[b].y, r = ents[a].radius + ents[b].radius;
+				if (dx * dx + dy * dy <= r * r) naiveHits++;
+			}
+		double t2 = NowMs();
+
+		hashed += t1 - t0;
+		naive += t2 - t1;
+	}
+
+	printf("spatial: %d tanks x %d shells, hash %.3f ms/tick (%ld hits), all-pairs %.3f ms/tick (%ld hits)\n",
+		tanks, shells, hashed / ticks, hashedHits, naive / ticks, naiveHits);
+
+	UnloadSpatialHash(&hash);
+	free(pairs);
+	free(ents);
+}
+
+// Shots raycast across open sky: pyramid skipping versus stepping every pixel of the mask
+static void BenchPyramid()
+{
+	const int width = 4096, height = 1024, rays = 20000;
+
+	int* mask = (int*)calloc(width * height, sizeof(int));
+	unsigned int* pixels = (unsigned int*)calloc(width * height, sizeof(unsigned int));
+	MakeTestTerrain(mask, pixels, width, height, 900);
+
+	OccupancyPyramid pyramid;
+	double t0 = NowMs();
+	InitOccupancyPyramid(&pyramid, mask, width, height);
+	double build = NowMs() - t0;
+
+	int pyramidHits = 0, naiveHits = 0, agree = 0;
+	long naiveLookups = 0;
+	double pyramidMs = 0, naiveMs = 0;
+	for (int r = 0; r < rays; r++)
+	{
+		float x0 = (float)(r * 37 % width), y0 = (float)(r * 13 % 600);
+		float x1 = (float)((r * 101 + 1500) % width), y1 = (float)height - 1;
+
+		int hx = -1, hy = -1;
+		double a = NowMs();
+		if (RaycastOccupancy(&pyramid, x0, y0, x1, y1, &hx, &hy)) pyramidHits++;
+		double b = NowMs();
+
+		//reference: one mask read per pixel step
+		int nx = -1, ny = -1;
+		float dx = x1 - x0, dy = y1 - y0;
+		int steps = (int)(fabsf(dx) > fabsf(dy) ? fabsf(dx) : fabsf(dy));
+		for (int i = 0; i <= steps; i++)
+		{
+			int px = (int)(x0 + dx * i / steps), py = (int)(y0 + dy * i / steps);
+			naiveLookups++;
+			if (mask[py * width + px]) { nx = px; ny = py; naiveHits++; break; }
+		}
+		double c = NowMs();
+
+		if (abs(nx - hx) <= 1 && abs(ny - hy) <= 1) agree++;
+		pyramidMs += b - a;
+		naiveMs += c - b;
+	}
+
+	printf("pyramid: build %.2f ms, %d rays, pyramid %.3f ms (%.1f lookups/ray), per-pixel %.3f ms (%.1f lookups/ray), hits %d/%d, agree %d\n",
+		build, rays, pyramidMs, (double)pyramid.lookups / rays, naiveMs, (double)naiveLookups / rays, pyramidHits, naiveHits, agree);
+
+	//a blast-sized carve only touches the ancestors of its own cells
+	for (int y = 850; y < 914; y++)
+		for (int x = 2000; x < 2064; x++) mask[y * width + x] = 0;
+	t0 = NowMs();
+	UpdateOccupancyPyramid(&pyramid, { 2000, 850, 64, 64 });
+	printf("pyramid: 64x64 carve update %.4f ms\n", NowMs() - t0);
+
+	UnloadOccupancyPyramid(&pyramid);
+	free(mask);
+	free(pixels);
+}
+
+// Full build, band refresh after a carve, and sphere-traced shots
+static void BenchSdf()
+{
+	const int width = 4096, height = 1024, rays = 20000;
+
+	int* mask = (int*)calloc(width * height, sizeof(int));
+	unsigned int* pixels = (unsigned int*)calloc(width * height, sizeof(unsigned int));
+	MakeTestTerrain(mask, pixels, width, height, 900);
+
+	TerrainSdf sdf;
+	double t0 = NowMs();
+	InitTerrainSdf(&sdf, mask, width, height);
+	double build = NowMs() - t0;
+
+	int wrongSign = 0;
+	for (int i = 0; i < width * height; i += 7)
+		if ((mask[i] != 0) != (sdf.dist[i] < 0)) wrongSign++;
+
+	for (int y = 850; y < 914; y++)
+		for (int x = 2000; x < 2064; x++) mask[y * width + x] = 0;
+	t0 = NowMs();
+	UpdateTerrainSdf(&sdf, { 2000, 850, 64, 64 });
+	double update = NowMs() - t0;
+
+	int hits = 0;
+	t0 = NowMs();
+	for (int r = 0; r < rays; r++)
+	{
+		float hx, hy;
+		if (SphereTraceTerrainSdf(&sdf, (float)(r * 37 % width), (float)(r * 13 % 600), (float)((r * 101 + 1500) % width), height - 1.0f, 3.0f, &hx, &hy)) hits++;
+	}
+	double trace = NowMs() - t0;
+
+	printf("sdf: %.1f KB, build %.2f ms, 64x64 carve refresh %.3f ms, %d rays traced in %.3f ms (%d hits), sign mismatches %d\n",
+		width * height / 1024.0, build, update, rays, trace, hits, wrongSign);
+
+	UnloadTerrainSdf(&sdf);
+	free(mask);
+	free(pixels);
+}
+
+// Contact normals for many shells at once, cold tiles and then cached tiles
+static void BenchNormals()
+{
+	const int width = 4096, height = 1024, points = 100000;
+
+	int* mask = (int*)calloc(width * height, sizeof(int));
+	unsigned int* pixels = (unsigned int*)calloc(width * height, sizeof(unsigned int));
+	MakeTestTerrain(mask, pixels, width, height, 900);
+
+	float* xs = (float*)calloc(points, sizeof(float));
+	float* ys = (float*)calloc(points, sizeof(float));
+	TerrainNormal* out = (TerrainNormal*)calloc(points, sizeof(TerrainNormal));
+	for (int i = 0; i < points; i++)
+	{
+		xs[i] = (float)(i * 41 % width);
+		ys[i] = (float)(900 - (i * 41 % width / 97 % 3) * 24);
+	}
+
+	TerrainNormalCache cache;
+	InitTerrainNormalCache(&cache, mask, width, height);
+
+	double t0 = NowMs();
+	QueryTerrainNormals(&cache, xs, ys, points, out);
+	double cold = NowMs() - t0;
+	t0 = NowMs();
+	QueryTerrainNormals(&cache, xs, ys, points, out);
+	double warm = NowMs() - t0;
+
+	int flat = 0;
+	for (int i = 0; i < points; i++) if (out[i].slope < 1.0f) flat++;
+
+	printf("normals: %d points, cold %.3f ms, cached %.3f ms, %ld tile recomputes, %d on flat ground\n",
+		points, cold, warm, cache.misses, flat);
+
+	UnloadTerrainNormalCache(&cache);
+	free(xs);
+	free(ys);
+	free(out);
+	free(mask);
+	free(pixels);
+}
+
+static void NoTileUpload(int tile, TerrainRect rect, void* userData) {}
+static void NoTileDraw(int tile, TerrainRect rect, void* userData) {}
+
+// Camera panning over a 16k map: draws stay at the visible tiles, uploads only on first sight or after a carve
+static void BenchTiles()
+{
+	const int width = 16384, height = 2048, viewW = 1024, viewH = 768, frames = 600;
+
+	TerrainTiles tiles;
+	InitTerrainTiles(&tiles, width, height, { NoTileUpload, NoTileDraw, nullptr });
+
+	int maxDraws = 0;
+	for (int f = 0; f < frames; f++)
+	{
+		float viewX = (float)(f * 16 % (width - viewW));
+		DrawTerrainTiles(&tiles, viewX, 1024, viewW, viewH);
+		if (tiles.stats.drawCalls > maxDraws) maxDraws = tiles.stats.drawCalls;
+
+		//a carve every 10 frames, half of them off screen
+		if (f % 10 == 0)
+		{
+			TerrainRect carve = { (int)viewX + (f % 20 == 0 ? 400 : 8000) % width, 1400, 64, 64 };
+			OnTerrainChangedTiles(&carve, 1, 0, &tiles);
+		}
+	}
+
+	printf("tiles: %d tiles, %d frames, max %d draws/frame, %.1f draws/frame avg, %.1f MB uploaded (full map %.1f MB)\n",
+		tiles.tilesX * tiles.tilesY, frames, maxDraws, (double)tiles.stats.totalDrawCalls / frames,
+		tiles.stats.totalUploadBytes / 1048576.0, (double)width * height * 4 / 1048576.0);
+
+	UnloadTerrainTiles(&tiles);
+}
+
+// Broadphase candidates narrowed to exact hits: packed word ANDs versus testing pixel by pixel
+static void BenchPixelMask()
+{
+	const int tanks = 500, shells = 10000, ticks = 60, angles = 19;
+	const int width = 4096, height = 1024;
+
+	//32x32 sprite with transparent corners: a dome on a track, like cannon.png
+	unsigned char* sprite = (unsigned char*)calloc(32 * 32, 4);
+	for (int y = 0; y < 32; y++)
+		for (int x = 0; x < 32; x++)
+		{
+			bool dome = (x - 16) * (x - 16) + (y - 20) * (y - 20) < 100;
+			bool track = y >= 24 && x >= 2 && x < 30;
+			sprite[(y * 32 + x) * 4 + 3] = (dome || track) ? 255 : 0;
+		}
+
+	PixelMask tankMasks[angles], shellMask;
+	for (int i = 0; i < angles; i++) BuildRotatedPixelMask(&tankMasks[i], sprite, 32, 32, 0, 16, 32, (i - angles / 2) * 5.0f);
+	BuildCirclePixelMask(&shellMask, 3);
+
+	SpatialEntry* ents = (SpatialEntry*)calloc(tanks + shells, sizeof(SpatialEntry));
+	int* tankAngle = (int*)calloc(tanks, sizeof(int));
+	unsigned int seed = 4242;
+	for (int i = 0; i < tanks + shells; i++)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		ents[i].x = (float)((seed >> 8) % width);
+		seed = seed * 1664525u + 1013904223u;
+		ents[i].y = (float)((seed >> 8) % height);
+		if (i < tanks) tankAngle[i] = (seed >> 4) % angles;
+	}
+
+	SpatialHash hash;
+	InitSpatialHash(&hash, 64, tanks + shells);
+	SpatialPair* pairs = (SpatialPair*)calloc(shells * 4, sizeof(SpatialPair));
+	PixelMaskTest* tests = (PixelMaskTest*)calloc(shells * 4, sizeof(PixelMaskTest));
+	bool* hits = (bool*)calloc(shells * 4, sizeof(bool));
+
+	double packed = 0, perPixel = 0;
+	long candidates = 0, packedHits = 0, pixelHits = 0;
+	for (int t = 0; t < ticks; t++)
+	{
+		for (int i = tanks; i < tanks + shells; i++) ents[i].y = fmodf(ents[i].y + 3.0f, (float)height);
+
+		ClearSpatialHash(&hash);
+		for (int i = 0; i < tanks + shells; i++)
+			AddSpatialEntry(&hash, i < tanks ? SPATIAL_TANK : SPATIAL_PROJECTILE, i, ents[i].x, ents[i].y + (i < tanks ? -12.0f : 0.0f), i < tanks ? 23.0f : 3.0f);
+		BuildSpatialHash(&hash);
+		int count = QuerySpatialPairs(&hash, SPATIAL_TANK, SPATIAL_PROJECTILE, pairs, shells * 4);
+		candidates += count;
+
+		for (int i = 0; i < count; i++)
+		{
+			int a = hash.entries[pairs[i].a].id, b = hash.entries[pairs[i].b].id;
+			tests[i] = { &tankMasks[tankAngle[a]], (int)ents[a].x, (int)ents[a].y, &shellMask, (int)ents[b].x, (int)ents[b].y };
+		}
+
+		double t0 = NowMs();
+		packedHits += TestPixelMaskPairs(tests, count, hits);
+		double t1 = NowMs();
+
+		for (int i = 0; i < count; i++)
+		{
+			const PixelMaskTest* m = &tests[i];
+			bool hit = false;
+			for (int y = 0; y < m->b->height && !hit; y++)
+				for (int x = 0; x < m->b->width && !hit; x++)
+				{
+					if (!(m->b->bits[y * m->b->wordsPerRow + (x >> 6)] >> (x & 63) & 1)) continue;
+					int ax = m->bx - m->b->originX + x - (m->ax - m->a->originX);
+					int ay = m->by - m->b->originY + y - (m->ay - m->a->originY);
+					if (ax < 0 || ay < 0 || ax >= m->a->width || ay >= m->a->height) continue;
+					hit = m->a->bits[ay * m->a->wordsPerRow + (ax >> 6)] >> (ax & 63) & 1;
+				}
+			pixelHits += hit;
+		}
+		double t2 = NowMs();
+
+		packed += t1 - t0;
+		perPixel += t2 - t1;
+	}
+
+	printf("pixelmask: %.0f candidate pairs/tick, packed %.3f ms/tick (%ld hits), per-pixel %.3f ms/tick (%ld hits)\n",
+		(double)candidates / ticks, packed / ticks, packedHits, perPixel / ticks, pixelHits);
+
+	for (int i = 0; i < angles; i++) UnloadPixelMask(&tankMasks[i]);
+	UnloadPixelMask(&shellMask);
+	UnloadSpatialHash(&hash);
+	free(hits);
+	free(tests);
+	free(pairs);
+	free(tankAngle);
+	free(ents);
+	free(sprite);
+}
+
+// Cost on the game thread of recording a tick and a carve, with the writer draining in the background
+static void BenchTelemetry()
+{
+	const int bursts = 100, burstTicks = 1024;
+	const char* path = "/tmp/terrain_bench.tlm";
+
+	if (!StartTelemetry(path))
+	{
+		printf("telemetry: can't write %s\n", path);
+		return;
+	}
+
+	double recording = 0;
+	for (int b = 0; b < bursts; b++)
+	{
+		double t0 = NowMs();
+		for (int i = 0; i < burstTicks; i++)
+		{
+			unsigned int tick = b * burstTicks + i;
+			TelemetryTick rec = { tick, 100.0f + i, 300.0f, 2.5f, 1, 1, 400.0f, 200.0f - i, 1, { 0.01f, 0.2f, 0.05f, 3.0f } };
+			TelemetryCarve carve = { tick, i, 300, 64, 64 };
+			RecordTelemetryTick(&rec);
+			RecordTelemetryCarve(&carve);
+		}
+		recording += NowMs() - t0;
+
+		//a burst is ~17 s of game time, give the writer a moment like the frames in between would
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	}
+
+	StopTelemetry();
+	TelemetryStats stats = GetTelemetryStats();
+	double perTick = recording / (bursts * burstTicks);
+
+	printf("telemetry: %ld records, %ld dropped, %.1f KB written, %.0f ns per tick+carve (%.4f%% of a 16.6 ms frame)\n",
+		stats.recorded, stats.dropped, stats.bytesWritten / 1024.0, perTick * 1e6, perTick / 16.6 * 100);
+	remove(path);
+}
+
+static void CountSpriteFlush(SpriteLayer layer, const SpriteVertex* vertices, int vertexCount, void* userData)
+{
+	*(long*)userData += vertexCount;
+}
+
+// A crowded frame: every sprite drawn on its own versus sorted per-layer batches
+static void BenchSprites()
+{
+	const int tanks = 500, shells = 5000, particles = 100000, frames = 60;
+
+	SpriteAtlas atlas = { 0 };
+	const char* names[] = { "cannon", "shell", "pixel" };
+	const int sizes[] = { 32, 21, 3 };
+	for (int i = 0; i < 3; i++)
+	{
+		strcpy(atlas.sprites[i].name, names[i]);
+		atlas.sprites[i].width = atlas.sprites[i].height = sizes[i];
+	}
+	atlas.count = 3;
+	PackSpriteAtlas(&atlas, 256);
+
+	long flushed = 0;
+	SpriteBatch batch;
+	InitSpriteBatch(&batch, tanks + shells + particles + 1, atlas.width, atlas.height, CountSpriteFlush, &flushed);
+
+	const AtlasSprite* cannon = FindAtlasSprite(&atlas, "cannon");
+	const AtlasSprite* shell = FindAtlasSprite(&atlas, "shell");
+	const AtlasSprite* pixel = FindAtlasSprite(&atlas, "pixel");
+
+	double total = 0;
+	for (int f = 0; f < frames; f++)
+	{
+		double t0 = NowMs();
+		BeginSpriteBatch(&batch);
+
+		//submitted interleaved, the way entity updates would produce them
+		for (int i = 0; i < particles; i++)
+		{
+			SubmitSprite(&batch, LAYER_DEBRIS, 0, pixel, (float)(i % 4096), (float)(i / 4096 + f), 1, 1, 0, 0, 0, 0xFF7F4F2F);
+			if (i < shells) SubmitSprite(&batch, LAYER_PROJECTILES, 0, shell, (float)(i * 7 % 4096), (float)(i % 1024), 21, 21, 10.5f, 10.5f, 0, 0xFF000080);
+			if (i < tanks) SubmitSprite(&batch, LAYER_TANKS, (i * 37) % 1024, cannon, (float)(i * 8), (float)((i * 37) % 1024), 32, 32, 16, 32, (float)(i % 30 - 15), 0xFFFFFFFF);
+		}
+		SubmitSpriteTriangle(&batch, LAYER_OVERLAY, 0, pixel, 0, 0, 10, 0, 5, 10, 0x64FFFFFF);
+
+		EndSpriteBatch(&batch);
+		total += NowMs() - t0;
+	}
+
+	printf("sprites: atlas %dx%d, %d sprites/frame, %d draw calls and %d vertices/frame batched (%d unbatched), %.2f ms/frame\n",
+		atlas.width, atlas.height, batch.stats.sprites, batch.stats.drawCalls, batch.stats.vertices, batch.stats.sprites, total / frames);
+
+	UnloadSpriteBatch(&batch);
+}
+
+// Shell flight in Q16.16 against the same flight in floats, the hash must match across builds
+static void BenchFixedPhysics()
+{
+	const int bodies = 100000, steps = 600;
+
+	fixed* fixedState = (fixed*)malloc(bodies * 4 * sizeof(fixed));
+	float* floatState = (float*)malloc(bodies * 4 * sizeof(float));
+	FixedBodies fb = { fixedState, fixedState + bodies, fixedState + 2 * bodies, fixedState + 3 * bodies, bodies };
+	float* x = floatState, *y = floatState + bodies, *vx = floatState + 2 * bodies, *vy = floatState + 3 * bodies;
+
+	for (int i = 0; i < bodies; i++)
+	{
+		//launch at every angle and a spread of powers, the way the game fires
+		int angle = i * 7 % (FIXED_ANGLE_TURN / 2);
+		fixed speed = IntToFixed(5 + i % 20);
+		fb.x[i] = IntToFixed(i % 1024);
+		fb.y[i] = IntToFixed(700);
+		fb.vx[i] = FixedMul(FixedCos(angle), speed);
+		fb.vy[i] = -FixedMul(FixedSin(angle), speed);
+
+		x[i] = FixedToFloat(fb.x[i]);
+		y[i] = FixedToFloat(fb.y[i]);
+		vx[i] = FixedToFloat(fb.vx[i]);
+		vy[i] = FixedToFloat(fb.vy[i]);
+	}
+
+	double t0 = NowMs();
+	for (int s = 0; s < steps; s++) StepFixedBodies(&fb, 10715);
+	double t1 = NowMs();
+	for (int s = 0; s < steps; s++)
+		for (int i = 0; i < bodies; i++)
+		{
+			x[i] += vx[i];
+			y[i] += vy[i];
+			vy[i] += 9.81f / 60;
+		}
+	double t2 = NowMs();
+
+	unsigned long long h = 14695981039346656037ull;
+	float drift = 0;
+	for (int i = 0; i < bodies * 4; i++)
+	{
+		h = (h ^ (unsigned int)fixedState[i]) * 1099511628211ull;
+		drift = fmaxf(drift, fabsf(FixedToFloat(fixedState[i]) - floatState[i]));
+	}
+
+	printf("fixed: %d bodies x %d steps, fixed %.3f ms/step, float %.3f ms/step, max drift %.3f px, state hash %016llx\n",
+		bodies, steps, (t1 - t0) / steps, (t2 - t1) / steps, drift, h);
+
+	free(fixedState);
+	free(floatState);
+}
+
+// A 1000-impact barrage in one tick: carving each blast as it lands versus one coalesced pass
+static void BenchCarveQueue()
+{
+	const int width = 4096, height = 1024, impacts = 1000, stampSize = 64;
+
+	int* stampMask = (int*)calloc(stampSize * stampSize, sizeof(int));
+	for (int y = 0; y < stampSize; y++)
+		for (int x = 0; x < stampSize; x++)
+			stampMask[y * stampSize + x] = (x - 32) * (x - 32) + (y - 32) * (y - 32) < 30 * 30;
+
+	int* immediateMask = (int*)malloc(width * height * sizeof(int));
+	int* queuedMask = (int*)malloc(width * height * sizeof(int));
+	unsigned int* pixels = (unsigned int*)malloc(width * height * sizeof(unsigned int));
+	MakeTestTerrain(immediateMask, pixels, width, height, 600);
+	memcpy(queuedMask, immediateMask, width * height * sizeof(int));
+
+	//most shells land in one crater field, as in a focused barrage
+	int* xs = (int*)malloc(impacts * sizeof(int));
+	int* ys = (int*)malloc(impacts * sizeof(int));
+	unsigned int seed = 777;
+	for (int i = 0; i < impacts; i++)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		xs[i] = 1000 + (int)((seed >> 8) % 600);
+		seed = seed * 1664525u + 1013904223u;
+		ys[i] = 540 + (int)((seed >> 8) % 200);
+	}
+
+	InitTerrainEvents(width, height);
+
+	//immediate: every pixel of every stamp, a publish per blast
+	long visitedImmediate = 0, clearedImmediate = 0;
+	double t0 = NowMs();
+	for (int i = 0; i < impacts; i++)
+	{
+		for (int y = 0; y < stampSize; y++)
+			for (int x = 0; x < stampSize; x++)
+			{
+				int mx = xs[i] + x, my = ys[i] + y;
+				if (!stampMask[y * stampSize + x] || mx < 0 || my < 0 || mx >= width || my >= height) continue;
+				visitedImmediate++;
+				if (immediateMask[my * width + mx] == 1)
+				{
+					immediateMask[my * width + mx] = 0;
+					clearedImmediate++;
+				}
+			}
+		PublishTerrainChange({ xs[i], ys[i], stampSize, stampSize });
+	}
+	FlushTerrainChanges();
+	double t1 = NowMs();
+
+	CarveStamp stamp;
+	BuildCarveStamp(&stamp, stampMask, stampSize, stampSize);
+	CarveQueue queue;
+	InitCarveQueue(&queue, width, height, impacts);
+
+	double t2 = NowMs();
+	for (int i = 0; i < impacts; i++) QueueCarve(&queue, &stamp, xs[i], ys[i]);
+	FlushCarveQueue(&queue, queuedMask, nullptr, nullptr);
+	FlushTerrainChanges();
+	double t3 = NowMs();
+
+	bool same = memcmp(immediateMask, queuedMask, width * height * sizeof(int)) == 0;
+	printf("carves: %d impacts, immediate %.2f ms (%ld px visited, %d rects), queued %.2f ms (%d px visited, %d rects), %ld cleared, masks %s\n",
+		impacts, t1 - t0, visitedImmediate, impacts, t3 - t2, queue.stats.pixelsVisited, queue.stats.rectsPublished,
+		clearedImmediate, same ? "match" : "DIFFER");
+
+	UnloadCarveQueue(&queue);
+	UnloadCarveStamp(&stamp);
+	UnloadTerrainEvents();
+	free(xs);
+	free(ys);
+	free(pixels);
+	free(queuedMask);
+	free(immediateMask);
+	free(stampMask);
+}
+
+// What HasPixelAt costs today: raylib's GetImageColor, a bounds check and a format switch per point
+__attribute__((noinline)) static unsigned char ImageAlphaAt(const unsigned char* rgba, int width, int height, int format, int x, int y)
+{
+	if (x < 0 || y < 0 || x >= width || y >= height) return 0;
+	switch (format)
+	{
+		case 7: return rgba[(y * width + x) * 4 + 3];
+		default: return 255;
+	}
+}
+
+// A million mixed points (some off the map): the HasPixelAt loop versus batched scalar and AVX2 queries
+static void BenchTerrainPoints()
+{
+	const int width = 16384, height = 2048, points = 1 << 20, rounds = 10;
+
+	int* mask = (int*)malloc((size_t)width * height * sizeof(int));
+	unsigned int* pixels = (unsigned int*)malloc((size_t)width * height * sizeof(unsigned int));
+	MakeTestTerrain(mask, pixels, width, height, 1400);
+
+	int* xs = (int*)malloc(points * sizeof(int));
+	int* ys = (int*)malloc(points * sizeof(int));
+	unsigned int seed = 99;
+	for (int i = 0; i < points; i++)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		xs[i] = (int)((seed >> 8) % (width + 200)) - 100;
+		seed = seed * 1664525u + 1013904223u;
+		ys[i] = (int)((seed >> 8) % (height + 200)) - 100;
+	}
+
+	TerrainBits bits;
+	InitTerrainBits(&bits, mask, width, height);
+	bool hasSimd = bits.simd;
+	unsigned long long* solid = (unsigned long long*)malloc((points / 64 + 1) * sizeof(unsigned long long));
+
+	long loopHits = 0;
+	double t0 = NowMs();
+	for (int r = 0; r < rounds; r++)
+		for (int i = 0; i < points; i++) loopHits += ImageAlphaAt((const unsigned char*)pixels, width, height, 7, xs[i], ys[i]) == 255;
+	double t1 = NowMs();
+
+	long batchHits[2] = { 0 };
+	double batchMs[2] = { 0 };
+	for (int simd = 0; simd <= (hasSimd ? 1 : 0); simd++)
+	{
+		bits.simd = simd;
+		double b0 = NowMs();
+		for (int r = 0; r < rounds; r++) QueryTerrainPoints(&bits, xs, ys, points, solid);
+		batchMs[simd] = NowMs() - b0;
+		for (int i = 0; i < points / 64; i++) batchHits[simd] += __builtin_popcountll(solid[i]) * rounds;
+	}
+
+	double total = (double)points * rounds;
+	printf("points: HasPixelAt loop %.0f Mpts/s (%ld solid), batched scalar %.0f Mpts/s (%ld), AVX2 %s%.0f Mpts/s (%ld)\n",
+		total / (t1 - t0) / 1000, loopHits, total / batchMs[0] / 1000, batchHits[0],
+		hasSimd ? "" : "unavailable ", hasSimd ? total / batchMs[1] / 1000 : 0.0, batchHits[1]);
+
+	UnloadTerrainBits(&bits);
+	free(solid);
+	free(xs);
+	free(ys);
+	free(pixels);
+	free(mask);
+}
+
+// Simulated shot with no cache, as the preview would run it every frame
+static TrajectoryResult SimulateShotUncached(OccupancyPyramid* terrain, const TrajectoryShot* shot)
+{
+	fixed x = shot->x, y = shot->y, vx = shot->vx, vy = shot->vy;
+	FixedBodies body = { &x, &y, &vx, &vy, 1 };
+	TrajectoryResult result = { false, 0, 0, 0 };
+	for (int step = 1; step <= TRAJECTORY_MAX_STEPS; step++)
+	{
+		float fromX = FixedToFloat(x), fromY = FixedToFloat(y);
+		StepFixedBodies(&body, shot->gravity);
+		float toX = FixedToFloat(x), toY = FixedToFloat(y);
+		result.steps = step;
+		if (RaycastOccupancy(terrain, fromX, fromY, toX, toY, &result.x, &result.y))
+		{
+			result.hit = true;
+			break;
+		}
+		if (toX < 0 || toX >= terrain->width || toY >= terrain->height) break;
+	}
+	return result;
+}
+
+// A fan of aimed shots re-evaluated every frame while craters land elsewhere on the map
+static void BenchTrajectoryCache()
+{
+	const int width = 2048, height = 768, shots = 64, frames = 600, carveEvery = 10, blast = 32;
+
+	int* mask = (int*)calloc(width * height, sizeof(int));
+	unsigned int* pixels = (unsigned int*)calloc(width * height, sizeof(unsigned int));
+	MakeTestTerrain(mask, pixels, width, height, 500);
+
+	InitTerrainEvents(width, height);
+	OccupancyPyramid pyramid;
+	InitOccupancyPyramid(&pyramid, mask, width, height);
+	SubscribeTerrainChanges(OnTerrainChangedPyramid, &pyramid);
+	TrajectoryCache cache;
+	InitTrajectoryCache(&cache, &pyramid, 256);
+
+	TrajectoryShot fan[shots];
+	for (int i = 0; i < shots; i++)
+	{
+		int angle = 2000 + (i % 16) * 700;
+		fixed speed = IntToFixed(4 + i / 16 * 2);
+		fan[i] = { IntToFixed(200 + (i % 4) * 400), IntToFixed(100), FixedMul(FixedCos(angle), speed), -FixedMul(FixedSin(angle), speed), 10715 };
+	}
+
+	double cachedMs = 0, uncachedMs = 0;
+	int mismatches = 0;
+	unsigned int seed = 4242;
+	for (int f = 0; f < frames; f++)
+	{
+		if (f % carveEvery == carveEvery - 1)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			int cx = (int)((seed >> 8) % (width - blast)), cy = 450 + (int)((seed >> 12) % 200);
+			for (int y = cy; y < cy + blast; y++)
+				for (int x = cx; x < cx + blast; x++) mask[y * width + x] = 0;
+			PublishTerrainChange({ cx, cy, blast, blast });
+			FlushTerrainChanges();
+		}
+
+		TrajectoryResult cached[shots], uncached[shots];
+		double t0 = NowMs();
+		for (int i = 0; i < shots; i++) cached[i] = QueryTrajectory(&cache, &fan[i]);
+		double t1 = NowMs();
+		for (int i = 0; i < shots; i++) uncached[i] = SimulateShotUncached(&pyramid, &fan[i]);
+		double t2 = NowMs();
+
+		cachedMs += t1 - t0;
+		uncachedMs += t2 - t1;
+		for (int i = 0; i < shots; i++)
+			if (cached[i].hit != uncached[i].hit || cached[i].x != uncached[i].x || cached[i].y != uncached[i].y) mismatches++;
+	}
+
+	printf("trajectory: %d shots x %d frames, uncached %.2f ms, cached %.2f ms, hit rate %.1f%% (%ld stale), %d mismatches\n",
+		shots, frames, uncachedMs, cachedMs, GetTrajectoryHitRate(&cache) * 100, cache.stale, mismatches);
+
+	UnloadTrajectoryCache(&cache);
+	UnloadOccupancyPyramid(&pyramid);
+	UnloadTerrainEvents();
+	free(pixels);
+	free(mask);
+}
+
+// The carves barrage on binary terrain versus the same terrain with a hardness plane, then layered rock
+static void BenchMaterials()
+{
+	const int width = 4096, height = 1024, impacts = 1000, stampSize = 64, damage = 4;
+
+	int* stampMask = (int*)calloc(stampSize * stampSize, sizeof(int));
+	for (int y = 0; y < stampSize; y++)
+		for (int x = 0; x < stampSize; x++)
+			stampMask[y * stampSize + x] = (x - 32) * (x - 32) + (y - 32) * (y - 32) < 30 * 30;
+
+	int* original = (int*)malloc(width * height * sizeof(int));
+	int* mask = (int*)malloc(width * height * sizeof(int));
+	int* binary = (int*)malloc(width * height * sizeof(int));
+	unsigned int* pixels = (unsigned int*)malloc(width * height * sizeof(unsigned int));
+	MakeTestTerrain(original, pixels, width, height, 600);
+
+	int* xs = (int*)malloc(impacts * sizeof(int));
+	int* ys = (int*)malloc(impacts * sizeof(int));
+	unsigned int seed = 777;
+	for (int i = 0; i < impacts; i++)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		xs[i] = 1000 + (int)((seed >> 8) % 600);
+		seed = seed * 1664525u + 1013904223u;
+		ys[i] = 540 + (int)((seed >> 8) % 200);
+	}
+
+	InitTerrainEvents(width, height);
+	CarveStamp stamp;
+	BuildCarveStamp(&stamp, stampMask, stampSize, stampSize);
+	CarveQueue queue;
+	InitCarveQueue(&queue, width, height, impacts);
+
+	//one tick per impact so hardness wears down blast by blast
+	double ms[4] = { 0 };
+	int cleared[4] = { 0 };
+	bool same = true;
+	TerrainMaterials materials;
+	for (int run = 0; run < 4; run++)
+	{
+		memcpy(mask, original, width * height * sizeof(int));
+		if (run > 0)
+		{
+			InitTerrainMaterials(&materials, mask, width, height, MATERIAL_DIRT);
+			if (run == 3) LayerTerrainMaterials(&materials, mask, 48, 0);
+			materials.simd = run != 1;
+			SetCarveMaterials(&queue, &materials, damage);
+		}
+		else SetCarveMaterials(&queue, nullptr, 0);
+
+		double t0 = NowMs();
+		for (int i = 0; i < impacts; i++)
+		{
+			QueueCarve(&queue, &stamp, xs[i], ys[i]);
+			cleared[run] += FlushCarveQueue(&queue, mask, nullptr, nullptr);
+			FlushTerrainChanges();
+		}
+		ms[run] = NowMs() - t0;
+
+		//all dirt against a blast that outdoes it has to carve exactly what the binary run did
+		if (run == 0) memcpy(binary, mask, width * height * sizeof(int));
+		if (run == 1 || run == 2) same = same && memcmp(binary, mask, width * height * sizeof(int)) == 0;
+		if (run > 0) UnloadTerrainMaterials(&materials);
+	}
+
+	printf("materials: %d blasts, binary %.2f ms, dirt plane scalar %.2f ms, SSE2 %.2f ms (%d cleared, masks %s), layered rock %.2f ms (%d cleared), 4 bits/px\n",
+		impacts, ms[0], ms[1], ms[2], cleared[2], same ? "match" : "DIFFER", ms[3], cleared[3]);
+
+	UnloadCarveQueue(&queue);
+	UnloadCarveStamp(&stamp);
+	UnloadTerrainEvents();
+	free(xs);
+	free(ys);
+	free(pixels);
+	free(binary);
+	free(mask);
+	free(original);
+	free(stampMask);
+}
+
+// Bench job state: a barrage's carves, refreshed one per slice, and an independent pyramid rebuild
+typedef struct BenchSdfJob {
+	TerrainSdf* sdf;
+	TerrainRect rects[40];
+	int count;
+} BenchSdfJob;
+
+typedef struct BenchPyramidJob {
+	const int* mask;
+	int width, height;
+	long lookups;
+} BenchPyramidJob;
+
+static JobStatus BenchSdfSlice(void* data)
+{
+	BenchSdfJob* job = (BenchSdfJob*)data;
+	if (job->count > 0) UpdateTerrainSdf(job->sdf, job->rects[--job->count]);
+	return job->count > 0 ? JOB_YIELD : JOB_DONE;
+}
+
+static JobStatus BenchPyramidRebuild(void* data)
+{
+	BenchPyramidJob* job = (BenchPyramidJob*)data;
+	OccupancyPyramid pyramid;
+	InitOccupancyPyramid(&pyramid, job->mask, job->width, job->height);
+	job->lookups += pyramid.levelWidth[1];
+	UnloadOccupancyPyramid(&pyramid);
+	return JOB_DONE;
+}
+
+// Barrages of 40 carves every 30 frames: SDF refresh inline in the frame versus sliced in a 2 ms budget
+static void BenchJobScheduler()
+{
+	const int width = 4096, height = 1024, frames = 600, every = 30, blast = 64;
+
+	int* mask = (int*)calloc(width * height, sizeof(int));
+	unsigned int* pixels = (unsigned int*)calloc(width * height, sizeof(unsigned int));
+	MakeTestTerrain(mask, pixels, width, height, 600);
+	TerrainSdf sdf;
+	InitTerrainSdf(&sdf, mask, width, height);
+
+	//at least one worker, so the parallel path runs even on a single core
+	InitThreadPool(std::thread::hardware_concurrency() > 2 ? -1 : 1);
+	InitJobScheduler();
+
+	BenchSdfJob sdfJobs[2];
+	BenchPyramidJob pyramidJob = { mask, width, height, 0 };
+	double worstFrame[2] = { 0 }, totalMs[2] = { 0 };
+	for (int mode = 0; mode < 2; mode++)
+	{
+		unsigned int seed = 31337;
+		for (int f = 0; f < frames; f++)
+		{
+			double t0 = NowMs();
+			if (f % every == 0)
+			{
+				BenchSdfJob* job = &sdfJobs[(f / every) & 1];
+				job->sdf = &sdf;
+				job->count = 40;
+				for (int i = 0; i < job->count; i++)
+				{
+					seed = seed * 1664525u + 1013904223u;
+					job->rects[i] = { (int)((seed >> 8) % (width - blast)), 520 + (int)((seed >> 4) % 300), blast, blast };
+				}
+
+				if (mode == 0) while (BenchSdfSlice(job) == JOB_YIELD) {}
+				else
+				{
+					SubmitJob("sdf refresh", BenchSdfSlice, job, JOB_PRIORITY_NORMAL, false);
+					SubmitJob("pyramid rebuild", BenchPyramidRebuild, &pyramidJob, JOB_PRIORITY_LOW, true);
+				}
+			}
+			if (mode == 1) RunScheduledJobs(JOB_FRAME_BUDGET);
+
+			double ms = NowMs() - t0;
+			totalMs[mode] += ms;
+			if (ms > worstFrame[mode]) worstFrame[mode] = ms;
+		}
+	}
+	UnloadJobScheduler();
+
+	JobReport reports[JOB_REPORTS];
+	int count = GetJobReports(reports, JOB_REPORTS);
+	double worstSlice = 0;
+	int maxFrames = 0;
+	for (int i = 0; i < count; i++)
+	{
+		if (reports[i].parallel) continue;
+		if (reports[i].longestSliceMs > worstSlice) worstSlice = reports[i].longestSliceMs;
+		if (reports[i].frames > maxFrames) maxFrames = reports[i].frames;
+	}
+	JobSchedulerStats stats = GetJobSchedulerStats();
+
+	printf("jobs: %d workers, inline worst frame %.2f ms (total %.1f), scheduled worst frame %.2f ms (total %.1f), longest slice %.2f ms\n",
+		GetThreadPoolWorkers(), worstFrame[0], totalMs[0], worstFrame[1], totalMs[1], worstSlice);
+	printf("jobs: %d finished, latency mean %.2f ms max %.2f ms, sdf refresh spans up to %d frames\n",
+		stats.finished, stats.meanLatencyMs, stats.maxLatencyMs, maxFrames);
+
+	ShutdownThreadPool();
+	UnloadTerrainSdf(&sdf);
+	free(mask);
+	free(pixels);
+}
+
+// Full-map passes as the game runs them, for the core-scaling bench
+typedef struct BenchMapPass {
+	const unsigned int* pixels;
+	unsigned int* out;
+	int* mask;
+	int width;
+} BenchMapPass;
+
+static void BenchAlphaRows(int y0, int y1, void* data)
+{
+	BenchMapPass* pass = (BenchMapPass*)data;
+	for (int y = y0; y < y1; y++)
+		for (int x = 0; x < pass->width; x++)
+			pass->mask[y * pass->width + x] = (pass->pixels[y * pass->width + x] >> 24) > 0 ? 1 : 0;
+}
+
+static void BenchBlankRows(int y0, int y1, void* data)
+{
+	BenchMapPass* pass = (BenchMapPass*)data;
+	for (int y = y0; y < y1; y++)
+		for (int x = 0; x < pass->width; x++)
+		{
+			int ix = y * pass->width + x;
+			pass->out[ix] = pass->mask[ix] == 0 ? 0 : pass->pixels[ix];
+		}
+}
+
+static void BenchShadeTile(int x0, int y0, int x1, int y1, void* data)
+{
+	BenchMapPass* pass = (BenchMapPass*)data;
+	for (int y = y0; y < y1; y++)
+		for (int x = x0; x < x1; x++)
+		{
+			unsigned int c = pass->out[y * pass->width + x];
+			float shade = 0.4f + 0.6f * (float)(y & 255) / 255.0f;
+			unsigned int r = (unsigned int)((c & 0xFF) * shade), g = (unsigned int)(((c >> 8) & 0xFF) * shade), b = (unsigned int)(((c >> 16) & 0xFF) * shade);
+			pass->out[y * pass->width + x] = (c & 0xFF000000u) | (b << 16) | (g << 8) | r;
+		}
+}
+
+static unsigned long long Checksum(const unsigned int* data, int count)
+{
+	unsigned long long h = 1469598103934665603ull;
+	for (int i = 0; i < count; i++) h = (h ^ data[i]) * 1099511628211ull;
+	return h;
+}
+
+// Alpha-to-mask and blank row passes and a tile shading pass on a large map at 1, 2, 4 and N threads
+static void BenchParallelFor()
+{
+	const int width = 8192, height = 4096, repeats = 3;
+
+	int* mask = (int*)calloc((size_t)width * height, sizeof(int));
+	unsigned int* pixels = (unsigned int*)calloc((size_t)width * height, sizeof(unsigned int));
+	unsigned int* out = (unsigned int*)calloc((size_t)width * height, sizeof(unsigned int));
+	MakeTestTerrain(mask, pixels, width, height, 2000);
+	BenchMapPass pass = { pixels, out, mask, width };
+
+	int hardware = (int)std::thread::hardware_concurrency();
+	int counts[4] = { 1, 2, 4, hardware > 4 ? hardware : 0 };
+	double base[3] = { 0 };
+	unsigned long long baseSum = 0;
+
+	printf("parallel: %dx%d map, %d hardware threads, best of %d\n", width, height, hardware, repeats);
+	for (int c = 0; c < 4 && counts[c] > 0; c++)
+	{
+		ShutdownThreadPool();
+		InitThreadPool(counts[c] - 1);
+
+		double best[3] = { 1e9, 1e9, 1e9 };
+		for (int r = 0; r < repeats; r++)
+		{
+			double t0 = NowMs();
+			ParallelForRows(height, PARALLEL_ROW_BAND, BenchAlphaRows, &pass);
+			double t1 = NowMs();
+			ParallelForRows(height, PARALLEL_ROW_BAND, BenchBlankRows, &pass);
+			double t2 = NowMs();
+			ParallelForTiles(width, height, TERRAIN_TILE_SIZE, BenchShadeTile, &pass);
+			double t3 = NowMs();
+
+			if (t1 - t0 < best[0]) best[0] = t1 - t0;
+			if (t2 - t1 < best[1]) best[1] = t2 - t1;
+			if (t3 - t2 < best[2]) best[2] = t3 - t2;
+		}
+
+		unsigned long long sum = Checksum(out, width * height) ^ Checksum((const unsigned int*)mask, width * height);
+		if (c == 0)
+		{
+			memcpy(base, best, sizeof(base));
+			baseSum = sum;
+		}
+
+		printf("parallel: %2d threads, alpha rows %6.2f ms (%.2fx), blank rows %6.2f ms (%.2fx), shade tiles %6.2f ms (%.2fx), output %s\n",
+			counts[c], best[0], base[0] / best[0], best[1], base[1] / best[1], best[2], base[2] / best[2], sum == baseSum ? "same" : "DIFFERS");
+	}
+
+	ShutdownThreadPool();
+	free(out);
+	free(pixels);
+	free(mask);
+}
+
+static void BlankBenchPixel(int x, int y, int carve, void* userData)
+{
+	unsigned int* pixels = (unsigned int*)userData;
+	pixels[y * 8192 + x] = 0;
+}
+
+// Checkpoints after 10, 100 and 1000 blasts on a large map: size and speed against a full dump, and a round trip
+static void BenchCheckpoint()
+{
+	const int width = 8192, height = 2048, stampSize = 64;
+	const int rounds[3] = { 10, 100, 1000 };
+
+	int* stampMask = (int*)calloc(stampSize * stampSize, sizeof(int));
+	for (int y = 0; y < stampSize; y++)
+		for (int x = 0; x < stampSize; x++)
+			stampMask[y * stampSize + x] = (x - 32) * (x - 32) + (y - 32) * (y - 32) < 30 * 30;
+
+	int* mask = (int*)malloc((size_t)width * height * sizeof(int));
+	unsigned int* pixels = (unsigned int*)malloc((size_t)width * height * sizeof(unsigned int));
+	MakeTestTerrain(mask, pixels, width, height, 1000);
+	int* savedMask = (int*)malloc((size_t)width * height * sizeof(int));
+	unsigned int* savedPixels = (unsigned int*)malloc((size_t)width * height * sizeof(unsigned int));
+
+	InitTerrainEvents(width, height);
+	TerrainMaterials materials;
+	InitTerrainMaterials(&materials, mask, width, height, MATERIAL_DIRT);
+	LayerTerrainMaterials(&materials, mask, 48, 8);
+	unsigned char* savedHardness = (unsigned char*)malloc((size_t)materials.bytesPerRow * height);
+
+	MatchCheckpoint checkpoint;
+	InitMatchCheckpoint(&checkpoint, mask, pixels, &materials, width, height);
+	SubscribeTerrainChanges(OnTerrainChangedCheckpoint, &checkpoint);
+
+	CarveStamp stamp;
+	BuildCarveStamp(&stamp, stampMask, stampSize, stampSize);
+	CarveQueue queue;
+	InitCarveQueue(&queue, width, height, 64);
+	SetCarveMaterials(&queue, &materials, 4);
+
+	double fullBytes = (double)width * height * (sizeof(int) + sizeof(unsigned int)) + (double)materials.bytesPerRow * height;
+	unsigned int seed = 2024;
+	int blasts = 0;
+	for (int r = 0; r < 3; r++)
+	{
+		for (; blasts < rounds[r]; blasts++)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			QueueCarve(&queue, &stamp, (int)((seed >> 8) % width) - 32, 950 + (int)((seed >> 4) % 150));
+			FlushCarveQueue(&queue, mask, BlankBenchPixel, pixels);
+
+			//a settled debris pixel now and then
+			int dx = (int)((seed >> 3) % width), dy = 900;
+			mask[dy * width + dx] = 1;
+			pixels[dy * width + dx] = 0xFF336699u;
+			PublishTerrainChange({ dx, dy, 1, 1 });
+			FlushTerrainChanges();
+		}
+
+		int size = 0;
+		double t0 = NowMs();
+		unsigned char* data = SaveMatchCheckpoint(&checkpoint, &blasts, sizeof(int), &size);
+		double t1 = NowMs();
+
+		memcpy(savedMask, mask, (size_t)width * height * sizeof(int));
+		memcpy(savedPixels, pixels, (size_t)width * height * sizeof(unsigned int));
+		memcpy(savedHardness, materials.hardness, (size_t)materials.bytesPerRow * height);
+
+		//more damage after the save, then go back to it
+		for (int i = 0; i < 50; i++)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			QueueCarve(&queue, &stamp, (int)((seed >> 8) % width) - 32, 950 + (int)((seed >> 4) % 150));
+		}
+		FlushCarveQueue(&queue, mask, BlankBenchPixel, pixels);
+		FlushTerrainChanges();
+
+		//a cut-off buffer must be refused before anything is touched
+		int restoredBlasts = 0;
+		bool rejected = !LoadMatchCheckpoint(&checkpoint, data, size - 3, &restoredBlasts, sizeof(int)) && restoredBlasts == 0;
+
+		double t2 = NowMs();
+		bool loaded = LoadMatchCheckpoint(&checkpoint, data, size, &restoredBlasts, sizeof(int));
+		double t3 = NowMs();
+		FlushTerrainChanges();
+
+		bool same = rejected && loaded && restoredBlasts == blasts &&
+			memcmp(savedMask, mask, (size_t)width * height * sizeof(int)) == 0 &&
+			memcmp(savedPixels, pixels, (size_t)width * height * sizeof(unsigned int)) == 0 &&
+			memcmp(savedHardness, materials.hardness, (size_t)materials.bytesPerRow * height) == 0;
+
+		printf("checkpoint: %dx%d, %4d blasts, %7.1f KB (%.2f%% of a %.0f MB dump), save %.2f ms, load %.2f ms, round trip %s\n",
+			width, height, blasts, size / 1024.0, 100.0 * size / fullBytes, fullBytes / (1024 * 1024), t1 - t0, t3 - t2, same ? "exact" : "DIFFERS");
+		free(data);
+	}
+
+	UnloadCarveQueue(&queue);
+	UnloadCarveStamp(&stamp);
+	UnloadMatchCheckpoint(&checkpoint);
+	UnloadTerrainMaterials(&materials);
+	UnloadTerrainEvents();
+	free(savedHardness);
+	free(savedPixels);
+	free(savedMask);
+	free(pixels);
+	free(mask);
+	free(stampMask);
+}
+
+// Dense mask against run-length columns on open, generated, cave-heavy and cratered maps: memory, queries and carves
+static void BenchTerrainStore()
+{
+	const int width = 4096, height = 1024, queries = 2000000, probes = 200000, blasts = 1000, radius = 24;
+	const char* names[4] = { "hills", "generated", "caves", "cratered" };
+
+	int* source = (int*)malloc((size_t)width * height * sizeof(int));
+	int* dense = (int*)malloc((size_t)width * height * sizeof(int));
+	unsigned int* pixels = (unsigned int*)malloc((size_t)width * height * sizeof(unsigned int));
+	int* xs = (int*)malloc(queries * sizeof(int));
+	int* ys = (int*)malloc(queries * sizeof(int));
+	TerrainRect* rects = (TerrainRect*)malloc(blasts * sizeof(TerrainRect));
+
+	unsigned int seed = 77;
+	for (int i = 0; i < queries; i++)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		xs[i] = (int)((seed >> 8) % width);
+		ys[i] = (int)((seed >> 4) % height);
+	}
+
+	for (int m = 0; m < 4; m++)
+	{
+		if (m == 0 || m == 3) MakeTestTerrain(source, pixels, width, height, 700);
+		else
+		{
+			TerrainGenParams params = DefaultTerrainGenParams(1234, width, height);
+			params.caveDensity = m == 1 ? 10 : 60;
+			GenerateTerrain(&params, nullptr, source);
+		}
+
+		//a long match worth of craters, carved straight into the source
+		if (m == 3)
+		{
+			TerrainStore crater;
+			InitTerrainStore(&crater, TERRAIN_BACKEND_DENSE, source, width, height);
+			for (int i = 0; i < 3000; i++) CarveTerrainCircle(&crater, (i * 7919) % width, 640 + (i * 104729) % 360, radius);
+			UnloadTerrainStore(&crater);
+		}
+		memcpy(dense, source, (size_t)width * height * sizeof(int));
+
+		TerrainStore stores[2];
+		InitTerrainStore(&stores[0], TERRAIN_BACKEND_DENSE, dense, width, height);
+		InitTerrainStore(&stores[1], TERRAIN_BACKEND_COLUMNS, source, width, height);
+
+		//columns following the dense mask through terrain events, as the game would keep them
+		TerrainStore follower;
+		InitTerrainStore(&follower, TERRAIN_BACKEND_COLUMNS, dense, width, height);
+
+		double queryMs[2], probeMs[2], carveMs[2];
+		long bytes[2], hits[2] = { 0 }, found[2] = { 0 };
+		for (int b = 0; b < 2; b++)
+		{
+			bytes[b] = GetTerrainStoreBytes(&stores[b]);
+
+			double t0 = NowMs();
+			for (int i = 0; i < queries; i++) hits[b] += IsTerrainSolid(&stores[b], xs[i], ys[i]);
+			double t1 = NowMs();
+			for (int i = 0; i < probes; i++) found[b] += FindTerrainBelow(&stores[b], xs[i], ys[i], 256);
+			double t2 = NowMs();
+			for (int i = 0; i < blasts; i++) rects[i] = CarveTerrainCircle(&stores[b], xs[i], ys[i], radius);
+			double t3 = NowMs();
+
+			queryMs[b] = t1 - t0;
+			probeMs[b] = t2 - t1;
+			carveMs[b] = t3 - t2;
+		}
+
+		double t0 = NowMs();
+		OnTerrainChangedStore(rects, blasts, 0, &follower);
+		double followMs = NowMs() - t0;
+
+		bool same = hits[0] == hits[1] && found[0] == found[1];
+		for (int y = 0; y < height && same; y++)
+			for (int x = 0; x < width; x++)
+				if (IsTerrainSolid(&stores[0], x, y) != IsTerrainSolid(&stores[1], x, y) ||
+					IsTerrainSolid(&stores[0], x, y) != IsTerrainSolid(&follower, x, y)) { same = false; break; }
+
+		printf("store %-9s dense %6.0f KB, columns %6.0f KB (%5.1fx smaller, %.0f KB after carves)\n", names[m],
+			bytes[0] / 1024.0, bytes[1] / 1024.0, (double)bytes[0] / bytes[1], GetTerrainStoreBytes(&stores[1]) / 1024.0);
+		printf("          %dM points dense %.1f ms, columns %.1f ms | %dk probes down %.1f / %.1f ms | %d carves %.1f / %.1f ms | %s\n",
+			queries / 1000000, queryMs[0], queryMs[1], probes / 1000, probeMs[0], probeMs[1], blasts, carveMs[0], carveMs[1], same ? "match" : "MISMATCH");
+		printf("          columns following the mask: %.4f ms per changed rect\n", followMs / blasts);
+
+		UnloadTerrainStore(&follower);
+		UnloadTerrainStore(&stores[1]);
+		UnloadTerrainStore(&stores[0]);
+	}
+
+	free(rects);
+	free(ys);
+	free(xs);
+	free(pixels);
+	free(dense);
+	free(source);
+}
+
+static void CountContourLoop(const ContourPoint* points, int count, void* userData)
+{
+	*(long*)userData += count;
+}
+
+// Contour upkeep after a carve must follow the blast size, not the map size
+static void BenchContours()
+{
+	const int widths[2] = { 2048, 8192 }, height = 1024, radii[4] = { 8, 16, 32, 64 }, blasts = 200;
+
+	for (int w = 0; w < 2; w++)
+	{
+		int width = widths[w];
+		int* mask = (int*)malloc((size_t)width * height * sizeof(int));
+		TerrainGenParams params = DefaultTerrainGenParams(99, width, height);
+		GenerateTerrain(&params, nullptr, mask);
+
+		TerrainContours contours;
+		double t0 = NowMs();
+		InitTerrainContours(&contours, mask, width, height);
+		double full = NowMs() - t0;
+		printf("contours: %dx%d full extraction %.1f ms, %ld segments\n", width, height, full, contours.stats.totalSegments);
+
+		TerrainStore store;
+		InitTerrainStore(&store, TERRAIN_BACKEND_DENSE, mask, width, height);
+		unsigned int seed = 5;
+		for (int r = 0; r < 4; r++)
+		{
+			double total = 0;
+			long tiles = 0, segments = 0;
+			for (int i = 0; i < blasts; i++)
+			{
+				seed = seed * 1664525u + 1013904223u;
+				TerrainRect rect = CarveTerrainCircle(&store, (int)((seed >> 8) % width), 300 + (int)((seed >> 4) % 500), radii[r]);
+
+				double t1 = NowMs();
+				UpdateTerrainContours(&contours, rect);
+				total += NowMs() - t1;
+				tiles += contours.stats.tilesRebuilt;
+				segments += contours.stats.segmentsRebuilt;
+			}
+			printf("          radius %2d: %.3f ms per carve, %.1f tiles, %.0f segments re-extracted\n",
+				radii[r], total / blasts, (double)tiles / blasts, (double)segments / blasts);
+		}
+
+		//the patched tiles must equal a fresh extraction of the carved map
+		TerrainContours fresh;
+		InitTerrainContours(&fresh, mask, width, height);
+		bool same = fresh.stats.totalSegments == contours.stats.totalSegments;
+		for (int t = 0; t < fresh.tilesX * fresh.tilesY && same; t++)
+			same = fresh.tiles[t].count == contours.tiles[t].count &&
+				memcmp(fresh.tiles[t].segments, contours.tiles[t].segments, fresh.tiles[t].count * sizeof(ContourSegment)) == 0;
+
+		long points = 0;
+		double t2 = NowMs();
+		int loops = TraceTerrainContours(&contours, CountContourLoop, &points);
+		double trace = NowMs() - t2;
+		printf("          after carves %s a fresh extraction, stitched %d loops (%ld points from %ld segments) in %.1f ms\n",
+			same ? "matches" : "DIFFERS FROM", loops, points, contours.stats.totalSegments, trace);
+
+		UnloadTerrainContours(&fresh);
+		UnloadTerrainStore(&store);
+		UnloadTerrainContours(&contours);
+		free(mask);
+	}
+}
+
+// Nav graph repair per carve against a full build, and thousands of units pathing to four goals on cached fields
+static void BenchNavGraph()
+{
+	const int width = 4096, height = 1024, carves = 200, units = 10000, goals = 4, frames = 60;
+	const NavParams params = { 3, 4, 62, 8 };
+
+	int* mask = (int*)malloc((size_t)width * height * sizeof(int));
+	TerrainGenParams gen = DefaultTerrainGenParams(31, width, height);
+	gen.caveDensity = 20;
+	GenerateTerrain(&gen, nullptr, mask);
+
+	NavGraph graph;
+	double t0 = NowMs();
+	InitNavGraph(&graph, mask, width, height, params);
+	double full = NowMs() - t0;
+	printf("nav: %dx%d full build %.1f ms, %d nodes\n", width, height, full, graph.stats.nodeCount);
+
+	TerrainStore store;
+	InitTerrainStore(&store, TERRAIN_BACKEND_DENSE, mask, width, height);
+	unsigned int seed = 11;
+	double repair = 0;
+	long tiles = 0;
+	for (int i = 0; i < carves; i++)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		TerrainRect rect = CarveTerrainCircle(&store, (int)((seed >> 8) % width), 250 + (int)((seed >> 4) % 500), 24);
+		double t1 = NowMs();
+		UpdateNavGraph(&graph, rect);
+		repair += NowMs() - t1;
+		tiles += graph.stats.tilesRebuilt;
+	}
+
+	//repaired tiles must equal a fresh build of the carved map
+	NavGraph fresh;
+	InitNavGraph(&fresh, mask, width, height, params);
+	bool same = fresh.stats.nodeCount == graph.stats.nodeCount;
+	for (int t = 0; t < fresh.tilesX * fresh.tilesY && same; t++)
+	{
+		const NavTile* a = &fresh.tiles[t];
+		const NavTile* b = &graph.tiles[t];
+		same = a->count == b->count && memcmp(a->nodes, b->nodes, a->count * sizeof(NavNode)) == 0 &&
+			memcmp(a->columnStart, b->columnStart, sizeof(a->columnStart)) == 0 &&
+			memcmp(a->surface, b->surface, a->columnStart[TERRAIN_TILE_SIZE] * sizeof(NavSurface)) == 0;
+	}
+	UnloadNavGraph(&fresh);
+	printf("     %d carves: %.3f ms per repair (%.1f tiles), %s a fresh build\n", carves, repair / carves, (double)tiles / carves, same ? "matches" : "DIFFERS FROM");
+
+	//units on surface points, a quarter heading to each goal
+	int* xs = (int*)malloc(units * sizeof(int));
+	int* ys = (int*)malloc(units * sizeof(int));
+	NavStep* steps = (NavStep*)malloc(units * sizeof(NavStep));
+	for (int i = 0; i < units; i++)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		xs[i] = (int)((seed >> 8) % width);
+		ys[i] = 0;
+		while (ys[i] < height - 1 && !mask[ys[i] * width + xs[i]]) ys[i]++;
+	}
+	int goalX[goals], goalY[goals];
+	for (int g = 0; g < goals; g++)
+	{
+		goalX[g] = (g * 2 + 1) * width / (goals * 2);
+		goalY[g] = 0;
+	}
+
+	NavCache cache;
+	InitNavCache(&cache, &graph, 8);
+	double frameTotal = 0, frameWorst = 0;
+	long reachable = 0;
+	for (int f = 0; f < frames; f++)
+	{
+		//a blast every 15 frames invalidates every field
+		if (f > 0 && f % 15 == 0)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			UpdateNavGraph(&graph, CarveTerrainCircle(&store, (int)((seed >> 8) % width), 250 + (int)((seed >> 4) % 500), 24));
+		}
+
+		double t1 = NowMs();
+		for (int g = 0; g < goals; g++)
+		{
+			const NavField* field = GetNavField(&cache, goalX[g], goalY[g]);
+			int first = g * units / goals, count = units / goals;
+			QueryNavSteps(&graph, field, xs + first, ys + first, count, steps + first);
+		}
+		double dt = NowMs() - t1;
+		frameTotal += dt;
+		if (dt > frameWorst) frameWorst = dt;
+	}
+	for (int i = 0; i < units; i++) reachable += steps[i].cost >= 0;
+
+	//along every path the remaining cost must fall and the last point must be the goal
+	int pathsChecked = 0, pathsBad = 0, pointsX[512], pointsY[512];
+	for (int i = 0; i < units && pathsChecked < 200; i++)
+	{
+		if (steps[i].cost < 0) continue;
+		int g = i / (units / goals);
+		const NavField* field = GetNavField(&cache, goalX[g], goalY[g]);
+		int count = GetNavPath(&graph, field, xs[i], ys[i], pointsX, pointsY, 512);
+		bool good = count > 1 && pointsX[count - 1] == field->goalX && pointsY[count - 1] == field->goalY;
+
+		int last = INT_MAX;
+		for (int k = 0; k < count && good; k++)
+		{
+			NavStep step;
+			QueryNavSteps(&graph, field, &pointsX[k], &pointsY[k], 1, &step);
+			good = step.cost >= 0 && step.cost <= last;
+			last = step.cost;
+		}
+		pathsChecked++;
+		pathsBad += !good;
+	}
+
+	printf("     %d units, %d goals: %.2f ms per frame (worst %.2f with field rebuilds), %ld reachable, fields %ld hits / %ld builds, %d/%d paths good\n",
+		units, goals, frameTotal / frames, frameWorst, reachable, cache.hits, cache.misses, pathsChecked - pathsBad, pathsChecked);
+
+	UnloadNavCache(&cache);
+	free(steps);
+	free(ys);
+	free(xs);
+	UnloadTerrainStore(&store);
+	UnloadNavGraph(&graph);
+	free(mask);
+}
+
+//----------------------------------------------------------------------------------
+// Team vision
+//----------------------------------------------------------------------------------
+// Same shadowcasting a pixel at a time, the reference for one unit's window
+static void CastVisionScalar(const int* mask, int width, int height, int ux, int uy, int radius, unsigned char* seen)
+{
+	int size = 2 * radius + 1;
+	memset(seen, 0, (size_t)size * size);
+	seen[radius * size + radius] = 1;
+
+	float* current = (float*)malloc(4 * (radius + 2) * sizeof(float));
+	float* next = current + 2 * (radius + 2);
+	for (int quadrant = 0; quadrant < 4; quadrant++)
+	{
+		bool vertical = quadrant < 2;
+		int direction = quadrant % 2 == 0 ? -1 : 1;
+		int center = vertical ? ux : uy, origin = vertical ? uy : ux;
+		int length = vertical ? width : height, lines = vertical ? height : width;
+		current[0] = -1;
+		current[1] = 1;
+		int count = 1;
+
+		for (int depth = 1; depth <= radius && count > 0; depth++)
+		{
+			int line = origin + direction * depth;
+			if (line < 0 || line >= lines) break;
+			int reach = (int)sqrtf((float)(radius * radius - depth * depth));
+			int nextCount = 0;
+
+			for (int i = 0; i < count; i++)
+			{
+				float start = current[2 * i], end = current[2 * i + 1];
+				int lo = center + (int)floorf(depth * start + 0.5f), hi = center + (int)ceilf(depth * end - 0.5f);
+				if (lo < center - reach) lo = center - reach;
+				if (hi > center + reach) hi = center + reach;
+				if (lo < 0) lo = 0;
+				if (hi > length - 1) hi = length - 1;
+
+				int open = -1;
+				for (int pos = lo; pos <= hi; pos++)
+				{
+					int px = vertical ? pos : line, py = vertical ? line : pos;
+					bool wall = mask[py * width + px] != 0;
+					bool symmetric = pos - center >= depth * start && pos - center <= depth * end;
+					if (wall || symmetric) seen[(py - uy + radius) * size + (px - ux + radius)] = 1;
+
+					if (!wall && open < 0) open = pos;
+					if ((wall && open >= 0) || (!wall && pos == hi))
+					{
+						int last = wall ? pos - 1 : pos;
+						float childStart = open == lo ? start : (2 * (open - center) - 1) / (2.0f * depth);
+						float childEnd = last == hi ? end : (2 * (last - center) + 1) / (2.0f * depth);
+						if (childStart < childEnd)
+						{
+							next[2 * nextCount] = childStart;
+							next[2 * nextCount + 1] = childEnd;
+							nextCount++;
+						}
+						open = -1;
+					}
+				}
+			}
+
+			float* swap = current;
+			current = next;
+			next = swap;
+			count = nextCount;
+		}
+	}
+	free(current < next ? current : next);
+}
+
+// Pixels strictly between the ends, one at a time
+static bool LineClearScalar(const int* mask, int width, int height, int x0, int y0, int x1, int y1)
+{
+	int dx = x1 - x0, dy = y1 - y0;
+	int adx = dx < 0 ? -dx : dx, ady = dy < 0 ? -dy : dy;
+	int major = adx >= ady ? adx : ady;
+	for (int m = 1; m < major; m++)
+	{
+		//same rounding as the batched query, halves away from zero
+		int numX = m * dx, numY = m * dy;
+		int x = x0 + (numX >= 0 ? (2 * numX + major) / (2 * major) : -((-2 * numX + major) / (2 * major)));
+		int y = y0 + (numY >= 0 ? (2 * numY + major) / (2 * major) : -((-2 * numY + major) / (2 * major)));
+		if (x >= 0 && x < width && y >= 0 && y < height && mask[y * width + x]) return false;
+	}
+	return true;
+}
+
+static void BenchTeamVision()
+{
+	const int width = 8192, height = 2048, units = 200, radius = 160, frames = 60, moved = 20, carves = 40, queries = 100000;
+
+	int* mask = (int*)malloc((size_t)width * height * sizeof(int));
+	TerrainGenParams gen = DefaultTerrainGenParams(47, width, height);
+	gen.caveDensity = 20;
+	GenerateTerrain(&gen, nullptr, mask);
+
+	//units stand on the first solid below a random column, eyes a few pixels up
+	int* ux = (int*)malloc(units * sizeof(int));
+	int* uy = (int*)malloc(units * sizeof(int));
+	unsigned int seed = 5;
+	for (int i = 0; i < units; i++)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		ux[i] = (int)((seed >> 8) % width);
+		uy[i] = 0;
+		while (uy[i] < height - 1 && !mask[uy[i] * width + ux[i]]) uy[i]++;
+		uy[i] = uy[i] > 16 ? uy[i] - 16 : 0;
+	}
+
+	TeamVision vision;
+	InitTeamVision(&vision, mask, width, height, 2, radius, units);
+	for (int i = 0; i < units; i++) AddVisionUnit(&vision, i % 2, ux[i], uy[i]);
+	double t0 = NowMs();
+	UpdateTeamVision(&vision);
+	double full = NowMs() - t0;
+	printf("vision: %dx%d, %d units radius %d: full cast %.2f ms on the caller (%d tiles composed)\n", width, height, units, radius, full, vision.stats.tilesComposed);
+
+	//the same cast on the pool must give the same masks, the rest runs on the pool too
+	InitThreadPool(std::thread::hardware_concurrency() > 2 ? -1 : 1);
+	TeamVision pooled;
+	InitTeamVision(&pooled, mask, width, height, 2, radius, units);
+	for (int i = 0; i < units; i++) AddVisionUnit(&pooled, i % 2, ux[i], uy[i]);
+	t0 = NowMs();
+	UpdateTeamVision(&pooled);
+	double pooledFull = NowMs() - t0;
+	bool pooledSame = true;
+	for (int t = 0; t < 2; t++) pooledSame = pooledSame && memcmp(pooled.visible[t], vision.visible[t], (size_t)vision.wordsPerRow * height * sizeof(unsigned long long)) == 0;
+	UnloadTeamVision(&pooled);
+	printf("        full cast %.2f ms with %d pool workers (%.2fx, %u hardware threads), %s\n", pooledFull, GetThreadPoolWorkers(), full / pooledFull,
+		std::thread::hardware_concurrency(), pooledSame ? "same masks" : "MASKS DIFFER");
+
+	//the bit casts must equal the pixel-at-a-time reference
+	int size = 2 * radius + 1;
+	unsigned char* seen = (unsigned char*)malloc((size_t)size * size);
+	int windowsChecked = 20, windowsBad = 0;
+	t0 = NowMs();
+	for (int i = 0; i < windowsChecked; i++) CastVisionScalar(mask, width, height, ux[i], uy[i], radius, seen);
+	double scalar = (NowMs() - t0) / windowsChecked;
+	for (int i = 0; i < windowsChecked; i++)
+	{
+		CastVisionScalar(mask, width, height, ux[i], uy[i], radius, seen);
+		const VisionUnit* unit = &vision.units[i];
+		bool good = true;
+		for (int y = 0; y < size && good; y++)
+			for (int x = 0; x < size && good; x++)
+				good = seen[y * size + x] == ((unit->window[y * vision.windowWords + (x >> 6)] >> (x & 63)) & 1);
+		windowsBad += !good;
+	}
+	printf("        per unit %.3f ms, pixel-at-a-time %.3f ms, %d/%d windows match\n", full / units, scalar, windowsChecked - windowsBad, windowsChecked);
+
+	//a tenth of the units move each frame, a blast every 15 frames
+	TerrainStore store;
+	InitTerrainStore(&store, TERRAIN_BACKEND_DENSE, mask, width, height);
+	double frameTotal = 0, frameWorst = 0;
+	long cast = 0, composed = 0;
+	for (int f = 0; f < frames; f++)
+	{
+		if (f > 0 && f % 15 == 0)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			int u = (int)((seed >> 8) % units);
+			TerrainRect rect = CarveTerrainCircle(&store, ux[u] + 40, uy[u] + 20, 24);
+			OnTerrainChangedVision(&rect, 1, 0, &vision);
+		}
+
+		double t1 = NowMs();
+		for (int i = 0; i < moved; i++)
+		{
+			int u = (f * moved + i) % units;
+			seed = seed * 1664525u + 1013904223u;
+			ux[u] += (int)((seed >> 8) % 7) - 3;
+			if (ux[u] < 0) ux[u] = 0;
+			if (ux[u] > width - 1) ux[u] = width - 1;
+			MoveVisionUnit(&vision, u, ux[u], uy[u]);
+		}
+		UpdateTeamVision(&vision);
+		double dt = NowMs() - t1;
+		frameTotal += dt;
+		if (dt > frameWorst) frameWorst = dt;
+		cast += vision.stats.unitsCast;
+		composed += vision.stats.tilesComposed;
+	}
+
+	//blasts with no unit moving recast only the units that can see them
+	double carveTotal = 0;
+	long carveCast = 0;
+	for (int i = 0; i < carves; i++)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		TerrainRect rect = CarveTerrainCircle(&store, (int)((seed >> 8) % width), 200 + (int)((seed >> 4) % 800), 24);
+		double t1 = NowMs();
+		OnTerrainChangedVision(&rect, 1, 0, &vision);
+		UpdateTeamVision(&vision);
+		carveTotal += NowMs() - t1;
+		carveCast += vision.stats.unitsCast;
+	}
+
+	//incremental results must equal a fresh cast of the final map and positions
+	TeamVision fresh;
+	InitTeamVision(&fresh, mask, width, height, 2, radius, units);
+	for (int i = 0; i < units; i++) AddVisionUnit(&fresh, i % 2, ux[i], uy[i]);
+	UpdateTeamVision(&fresh);
+	size_t words = (size_t)vision.wordsPerRow * height;
+	bool same = true;
+	for (int t = 0; t < 2; t++) same = same && memcmp(fresh.visible[t], vision.visible[t], words * sizeof(unsigned long long)) == 0;
+	UnloadTeamVision(&fresh);
+
+	printf("        %d frames, %d moving: %.3f ms per frame (worst %.3f), %.1f casts, %.1f tiles\n",
+		frames, moved, frameTotal / frames, frameWorst, (double)cast / frames, (double)composed / frames);
+	printf("        %d blasts: %.3f ms per update, %.1f units recast, %s a fresh cast\n", carves, carveTotal / carves, (double)carveCast / carves, same ? "matches" : "DIFFERS FROM");
+
+	//batched line of sight between random unit pairs and random points
+	int* qx0 = (int*)malloc(queries * 4 * sizeof(int));
+	int* qy0 = qx0 + queries;
+	int* qx1 = qy0 + queries;
+	int* qy1 = qx1 + queries;
+	bool* clear = (bool*)malloc(queries * sizeof(bool));
+	for (int i = 0; i < queries; i++)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		int u = (int)((seed >> 8) % units);
+		qx0[i] = ux[u];
+		qy0[i] = uy[u];
+		seed = seed * 1664525u + 1013904223u;
+		qx1[i] = ux[u] + (int)((seed >> 8) % 801) - 400;
+		qy1[i] = uy[u] + (int)((seed >> 4) % 401) - 200;
+	}
+	t0 = NowMs();
+	QueryLineOfSight(&vision, qx0, qy0, qx1, qy1, queries, clear);
+	double batched = NowMs() - t0;
+
+	int mismatches = 0, clearCount = 0;
+	t0 = NowMs();
+	for (int i = 0; i < queries; i++)
+	{
+		bool reference = LineClearScalar(mask, width, height, qx0[i], qy0[i], qx1[i], qy1[i]);
+		mismatches += reference != clear[i];
+		clearCount += clear[i];
+	}
+	double reference = NowMs() - t0;
+	printf("        %d line of sight queries: %.2f ms batched, %.2f ms pixel-at-a-time, %d clear, %d mismatches\n",
+		queries, batched, reference, clearCount, mismatches);
+
+	free(clear);
+	free(qx0);
+	UnloadTerrainStore(&store);
+	free(seen);
+	UnloadTeamVision(&vision);
+	ShutdownThreadPool();
+	free(uy);
+	free(ux);
+	free(mask);
+}
+
+//----------------------------------------------------------------------------------
+// Terrain density
+//----------------------------------------------------------------------------------
+static void BenchTerrainDensity()
+{
+	const int width = 8192, height = 2048, carves = 500, checks = 5000, queries = 1000000;
+
+	int* mask = (int*)malloc((size_t)width * height * sizeof(int));
+	TerrainGenParams gen = DefaultTerrainGenParams(53, width, height);
+	GenerateTerrain(&gen, nullptr, mask);
+
+	TerrainDensity density;
+	double t0 = NowMs();
+	InitTerrainDensity(&density, mask, width, height);
+	double full = NowMs() - t0;
+
+	//a plain summed-area table, rebuilt downstream of the carve, is the baseline
+	int* plain = (int*)malloc((size_t)(width + 1) * (height + 1) * sizeof(int));
+	t0 = NowMs();
+	for (int x = 0; x <= width; x++) plain[x] = 0;
+	for (int y = 1; y <= height; y++)
+	{
+		int run = 0;
+		plain[(size_t)y * (width + 1)] = 0;
+		for (int x = 1; x <= width; x++)
+		{
+			run += mask[(size_t)(y - 1) * width + x - 1] != 0;
+			plain[(size_t)y * (width + 1) + x] = plain[(size_t)(y - 1) * (width + 1) + x] + run;
+		}
+	}
+	double plainFull = NowMs() - t0;
+	printf("density: %dx%d full build %.1f ms, plain table %.1f ms\n", width, height, full, plainFull);
+
+	TerrainStore store;
+	InitTerrainStore(&store, TERRAIN_BACKEND_DENSE, mask, width, height);
+	unsigned int seed = 17;
+	double update = 0, plainUpdate = 0;
+	long tiles = 0, strips = 0;
+	for (int i = 0; i < carves; i++)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		TerrainRect rect = CarveTerrainCircle(&store, (int)((seed >> 8) % width), (int)((seed >> 4) % height), 24);
+		double t1 = NowMs();
+		UpdateTerrainDensity(&density, rect);
+		update += NowMs() - t1;
+		tiles += density.stats.tilesRebuilt;
+		strips += density.stats.stripsUpdated;
+
+		//the plain table redoes every row from the carve down, right of it
+		t1 = NowMs();
+		int x0 = rect.x < 0 ? 0 : rect.x, y0 = rect.y < 0 ? 0 : rect.y;
+		for (int y = y0 + 1; y <= height; y++)
+		{
+			int run = plain[(size_t)y * (width + 1) + x0] - plain[(size_t)(y - 1) * (width + 1) + x0];
+			for (int x = x0 + 1; x <= width; x++)
+			{
+				run += mask[(size_t)(y - 1) * width + x - 1] != 0;
+				plain[(size_t)y * (width + 1) + x] = plain[(size_t)(y - 1) * (width + 1) + x] + run;
+			}
+		}
+		plainUpdate += NowMs() - t1;
+	}
+	printf("         %d carves: %.3f ms per update (%.1f tiles, %.1f strips), plain table %.3f ms\n",
+		carves, update / carves, (double)tiles / carves, (double)strips / carves, plainUpdate / carves);
+
+	//random rects against the carved mask pixel by pixel, and the plain table
+	TerrainRect* rects = (TerrainRect*)malloc(queries * sizeof(TerrainRect));
+	int* sums = (int*)malloc(queries * sizeof(int));
+	for (int i = 0; i < queries; i++)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		rects[i].x = (int)((seed >> 8) % (width + 64)) - 32;
+		seed = seed * 1664525u + 1013904223u;
+		rects[i].y = (int)((seed >> 8) % (height + 64)) - 32;
+		rects[i].width = 1 + (int)((seed >> 4) % 96);
+		rects[i].height = 1 + (int)((seed >> 12) % 96);
+	}
+	t0 = NowMs();
+	QueryTerrainSums(&density, rects, queries, sums);
+	double batched = NowMs() - t0;
+
+	int mismatches = 0;
+	t0 = NowMs();
+	for (int i = 0; i < checks; i++)
+	{
+		TerrainRect r = rects[i];
+		int reference = 0;
+		for (int y = r.y; y < r.y + r.height; y++)
+			for (int x = r.x; x < r.x + r.width; x++)
+				if (x >= 0 && x < width && y >= 0 && y < height) reference += mask[y * width + x] != 0;
+		mismatches += reference != sums[i];
+	}
+	double pixels = (NowMs() - t0) / checks * queries;
+	for (int i = 0; i < queries; i++)
+	{
+		TerrainRect r = rects[i];
+		int x0 = r.x < 0 ? 0 : r.x > width ? width : r.x, y0 = r.y < 0 ? 0 : r.y > height ? height : r.y;
+		int x1 = r.x + r.width > width ? width : r.x + r.width, y1 = r.y + r.height > height ? height : r.y + r.height;
+		int reference = x0 >= x1 || y0 >= y1 ? 0 : plain[(size_t)y1 * (width + 1) + x1] - plain[(size_t)y0 * (width + 1) + x1] -
+			plain[(size_t)y1 * (width + 1) + x0] + plain[(size_t)y0 * (width + 1) + x0];
+		mismatches += reference != sums[i];
+	}
+
+	//the repaired blocks must equal a fresh build
+	TerrainDensity fresh;
+	InitTerrainDensity(&fresh, mask, width, height);
+	int ts = density.tilesX * density.tilesY;
+	bool same = memcmp(fresh.local, density.local, (size_t)ts * TERRAIN_TILE_SIZE * TERRAIN_TILE_SIZE * sizeof(unsigned short)) == 0 &&
+		memcmp(fresh.above, density.above, (size_t)ts * TERRAIN_TILE_SIZE * sizeof(int)) == 0 &&
+		memcmp(fresh.left, density.left, (size_t)ts * TERRAIN_TILE_SIZE * sizeof(int)) == 0 &&
+		memcmp(fresh.grid, density.grid, ts * sizeof(int)) == 0;
+	UnloadTerrainDensity(&fresh);
+
+	printf("         %d rect queries: %.2f ms batched (%.1f ns each), ~%.0f ms pixel by pixel, %d mismatches, %s a fresh build\n",
+		queries, batched, batched * 1e6 / queries, pixels, mismatches, same ? "matches" : "DIFFERS FROM");
+
+	free(sums);
+	free(rects);
+	UnloadTerrainStore(&store);
+	free(plain);
+	UnloadTerrainDensity(&density);
+	free(mask);
+}
+
+//----------------------------------------------------------------------------------
+// Main entry point
+//----------------------------------------------------------------------------------
+typedef struct Benchmark {
+	const char* name;
+	void (*run)();
+} Benchmark;
+
+static const Benchmark benchmarks[] = {
+	{ "debris", BenchDebris },
+	{ "spatial", BenchSpatialHash },
+	{ "pyramid", BenchPyramid },
+	{ "sdf", BenchSdf },
+	{ "normals", BenchNormals },
+	{ "tiles", BenchTiles },
+	{ "pixelmask", BenchPixelMask },
+	{ "telemetry", BenchTelemetry },
+	{ "sprites", BenchSprites },
+	{ "fixed", BenchFixedPhysics },
+	{ "carves", BenchCarveQueue },
+	{ "points", BenchTerrainPoints },
+	{ "trajectory", BenchTrajectoryCache },
+	{ "materials", BenchMaterials },
+	{ "jobs", BenchJobScheduler },
+	{ "parallel", BenchParallelFor },
+	{ "checkpoint", BenchCheckpoint },
+	{ "store", BenchTerrainStore },
+	{ "contours", BenchContours },
+	{ "nav", BenchNavGraph },
+	{ "vision", BenchTeamVision },
+	{ "density", BenchTerrainDensity },
+};
+
+int main(int argc, char** argv)
+{
+	int count = sizeof(benchmarks) / sizeof(benchmarks[0]);
+	for (int i = 0; i < count; i++)
+	{
+		if (argc > 1 && strcmp(argv[1], benchmarks[i].name) != 0) continue;
+		benchmarks[i].run();
+	}
+
+	return 0;
+}
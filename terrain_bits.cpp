@@ -0,0 +1,136 @@
+/*******************************************************************************************
+*
+*   Terrain Bits - packed solid bitset of the terrain for batched point queries
+*
+********************************************************************************************/
+
+#include "terrain_bits.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define TERRAIN_BITS_AVX2
+	#include <immintrin.h>
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition (local)
+//----------------------------------------------------------------------------------
+static inline bool ScalarPoint(const TerrainBits* bits, int x, int y)
+{
+	//unsigned compares fold the four bounds checks into two
+	if ((unsigned int)x >= (unsigned int)bits->width || (unsigned int)y >= (unsigned int)bits->height) return false;
+	return (bits->words[y * bits->wordsPerRow + (x >> 5)] >> (x & 31)) & 1;
+}
+
+static void QueryPointsScalar(const TerrainBits* bits, const int* xs, const int* ys, int first, int count, unsigned long long* solid)
+{
+	for (int i = first; i < count; i++)
+		if (ScalarPoint(bits, xs[i], ys[i])) solid[i >> 6] |= 1ull << (i & 63);
+}
+
+#if defined(TERRAIN_BITS_AVX2)
+// 8 points per step: bounds as one mask, masked gather of the words, variable shift to the bit
+__attribute__((target("avx2")))
+static int QueryPointsAvx2(const TerrainBits* bits, const int* xs, const int* ys, int count, unsigned long long* solid)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i one = _mm256_set1_epi32(1);
+	const __m256i w = _mm256_set1_epi32(bits->width);
+	const __m256i h = _mm256_set1_epi32(bits->height);
+	const __m256i stride = _mm256_set1_epi32(bits->wordsPerRow);
+	const __m256i low5 = _mm256_set1_epi32(31);
+
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i x = _mm256_loadu_si256((const __m256i*)(xs + i));
+		__m256i y = _mm256_loadu_si256((const __m256i*)(ys + i));
+
+		//0 <= x < w and 0 <= y < h, out of range lanes are never loaded
+		__m256i inside = _mm256_and_si256(
+			_mm256_and_si256(_mm256_cmpgt_epi32(x, _mm256_sub_epi32(zero, one)), _mm256_cmpgt_epi32(w, x)),
+			_mm256_and_si256(_mm256_cmpgt_epi32(y, _mm256_sub_epi32(zero, one)), _mm256_cmpgt_epi32(h, y)));
+
+		__m256i index = _mm256_add_epi32(_mm256_mullo_epi32(y, stride), _mm256_srli_epi32(x, 5));
+		__m256i word = _mm256_mask_i32gather_epi32(zero, (const int*)bits->words, index, inside, 4);
+		__m256i bit = _mm256_and_si256(_mm256_srlv_epi32(word, _mm256_and_si256(x, low5)), one);
+
+		unsigned int lanes = (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(bit, one)));
+		solid[i >> 6] |= (unsigned long long)lanes << (i & 63);
+	}
+
+	return i;
+}
+#endif
+
+//----------------------------------------------------------------------------------
+// Terrain Bits Functions Definition
+//----------------------------------------------------------------------------------
+void InitTerrainBits(TerrainBits* bits, const int* mask, int width, int height)
+{
+	bits->mask = mask;
+	bits->width = width;
+	bits->height = height;
+	bits->wordsPerRow = (width + 31) / 32;
+	bits->words = (unsigned int*)calloc((size_t)bits->wordsPerRow * height, sizeof(unsigned int));
+
+#if defined(TERRAIN_BITS_AVX2)
+	bits->simd = __builtin_cpu_supports("avx2");
+#else
+	bits->simd = false;
+#endif
+
+	UpdateTerrainBits(bits, { 0, 0, width, height });
+}
+
+void UnloadTerrainBits(TerrainBits* bits)
+{
+	free(bits->words);
+	memset(bits, 0, sizeof(TerrainBits));
+}
+
+void UpdateTerrainBits(TerrainBits* bits, TerrainRect rect)
+{
+	int x0 = rect.x < 0 ? 0 : rect.x;
+	int y0 = rect.y < 0 ? 0 : rect.y;
+	int x1 = rect.x + rect.width > bits->width ? bits->width : rect.x + rect.width;
+	int y1 = rect.y + rect.height > bits->height ? bits->height : rect.y + rect.height;
+
+	//whole words covering the rect, rebuilt straight from the mask
+	int w0 = x0 >> 5, w1 = (x1 + 31) >> 5;
+	for (int y = y0; y < y1; y++)
+	{
+		const int* row = bits->mask + y * bits->width;
+		for (int w = w0; w < w1; w++)
+		{
+			unsigned int word = 0;
+			int end = (w + 1) * 32 < bits->width ? (w + 1) * 32 : bits->width;
+			for (int x = w * 32; x < end; x++) word |= (unsigned int)(row[x] == 1) << (x & 31);
+			bits->words[y * bits->wordsPerRow + w] = word;
+		}
+	}
+}
+
+void OnTerrainChangedBits(const TerrainRect* rects, int count, unsigned int version, void* data)
+{
+	for (int i = 0; i < count; i++) UpdateTerrainBits((TerrainBits*)data, rects[i]);
+}
+
+bool IsTerrainBitSolid(const TerrainBits* bits, int x, int y)
+{
+	return ScalarPoint(bits, x, y);
+}
+
+void QueryTerrainPoints(const TerrainBits* bits, const int* xs, const int* ys, int count, unsigned long long* solid)
+{
+	memset(solid, 0, ((count + 63) / 64) * sizeof(unsigned long long));
+
+	int done = 0;
+#if defined(TERRAIN_BITS_AVX2)
+	if (bits->simd) done = QueryPointsAvx2(bits, xs, ys, count, solid);
+#endif
+
+	QueryPointsScalar(bits, xs, ys, done, count, solid);
+}
@@ -0,0 +1,43 @@
+/*******************************************************************************************
+*
+*   Terrain Bits - packed solid bitset of the terrain for batched point queries
+*
+*   One bit per pixel, 32 per word, rows padded to a word. A query takes arrays of points
+*   and returns a bitset of solid flags; bounds are checked 8 points at a time and the
+*   words are fetched with an AVX2 gather when the CPU has it (checked at runtime), with a
+*   scalar loop otherwise. Points outside the map are never solid.
+*
+********************************************************************************************/
+
+#ifndef TERRAIN_BITS_H
+#define TERRAIN_BITS_H
+
+#include "terrain_events.h"
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct TerrainBits {
+	const int* mask;                // Source mask, 1 = solid, not owned
+	int width, height;
+	int wordsPerRow;
+	unsigned int* words;            // Bit x & 31 of word x >> 5 in the row
+
+	bool simd;                      // Use the AVX2 kernel, defaults to what the CPU supports
+} TerrainBits;
+
+//----------------------------------------------------------------------------------
+// Terrain Bits Functions Declaration
+//----------------------------------------------------------------------------------
+void InitTerrainBits(TerrainBits* bits, const int* mask, int width, int height);
+void UnloadTerrainBits(TerrainBits* bits);
+
+void UpdateTerrainBits(TerrainBits* bits, TerrainRect rect);    // Repack the rows under rect from the mask
+void OnTerrainChangedBits(const TerrainRect* rects, int count, unsigned int version, void* bits);   // Terrain events subscriber
+
+bool IsTerrainBitSolid(const TerrainBits* bits, int x, int y);
+
+// Bit i of solid (count bits, 64 per word) set when point (xs[i], ys[i]) is solid
+void QueryTerrainPoints(const TerrainBits* bits, const int* xs, const int* ys, int count, unsigned long long* solid);
+
+#endif // TERRAIN_BITS_H
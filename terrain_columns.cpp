@@ -0,0 +1,230 @@
+/*******************************************************************************************
+*
+*   Terrain Columns - terrain stored as run-length solid spans per column
+*
+********************************************************************************************/
+
+#include "terrain_columns.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition (local)
+//----------------------------------------------------------------------------------
+static inline TerrainSpan* ColumnSpans(TerrainColumn* column)
+{
+	return column->capacity > TERRAIN_COLUMN_INLINE_SPANS ? column->heap : column->local;
+}
+
+static inline const TerrainSpan* ColumnSpans(const TerrainColumn* column)
+{
+	return column->capacity > TERRAIN_COLUMN_INLINE_SPANS ? column->heap : column->local;
+}
+
+// Index of the first span with bottom > y, count if none
+static int FirstSpanEndingAfter(const TerrainSpan* spans, int count, int y)
+{
+	int lo = 0, hi = count;
+	while (lo < hi)
+	{
+		int mid = (lo + hi) >> 1;
+		if (spans[mid].bottom <= y) lo = mid + 1;
+		else hi = mid;
+	}
+	return lo;
+}
+
+static void ReserveSpans(TerrainColumn* column, int count)
+{
+	if (count <= column->capacity) return;
+
+	//a column of 65535 rows never has more than 32768 spans
+	int capacity = column->capacity * 2;
+	if (capacity > 32768) capacity = 32768;
+	if (capacity < count) capacity = count;
+
+	TerrainSpan* spans = (TerrainSpan*)malloc(capacity * sizeof(TerrainSpan));
+	memcpy(spans, ColumnSpans(column), column->count * sizeof(TerrainSpan));
+	if (column->capacity > TERRAIN_COLUMN_INLINE_SPANS) free(column->heap);
+
+	column->heap = spans;
+	column->capacity = (unsigned short)capacity;
+}
+
+// Spans [first, last) become the pieceCount pieces
+static void ReplaceSpans(TerrainColumn* column, int first, int last, const TerrainSpan* pieces, int pieceCount)
+{
+	int count = column->count - (last - first) + pieceCount;
+	ReserveSpans(column, count);
+
+	TerrainSpan* spans = ColumnSpans(column);
+	memmove(spans + first + pieceCount, spans + last, (column->count - last) * sizeof(TerrainSpan));
+	memcpy(spans + first, pieces, pieceCount * sizeof(TerrainSpan));
+	column->count = (unsigned short)count;
+}
+
+static void EncodeColumn(TerrainColumns* columns, const int* mask, int x)
+{
+	TerrainColumn* column = &columns->columns[x];
+	int width = columns->width, height = columns->height;
+
+	//count first so the column is sized once
+	int count = 0;
+	for (int y = 0, last = 0; y < height; y++)
+	{
+		int solid = mask[y * width + x] != 0;
+		count += solid & !last;
+		last = solid;
+	}
+
+	ReserveSpans(column, count);
+	TerrainSpan* spans = ColumnSpans(column);
+	int n = 0;
+	for (int y = 0; y < height; )
+	{
+		if (!mask[y * width + x]) { y++; continue; }
+
+		int top = y;
+		while (y < height && mask[y * width + x]) y++;
+		spans[n].top = (unsigned short)top;
+		spans[n].bottom = (unsigned short)y;
+		n++;
+	}
+	column->count = (unsigned short)n;
+}
+
+//----------------------------------------------------------------------------------
+// Terrain Columns Functions Definition
+//----------------------------------------------------------------------------------
+void InitTerrainColumns(TerrainColumns* columns, const int* mask, int width, int height)
+{
+	columns->width = width;
+	columns->height = height;
+	columns->columns = (TerrainColumn*)calloc(width, sizeof(TerrainColumn));
+	for (int x = 0; x < width; x++) columns->columns[x].capacity = TERRAIN_COLUMN_INLINE_SPANS;
+
+	if (mask != nullptr) EncodeTerrainColumns(columns, mask, 0, width);
+}
+
+void UnloadTerrainColumns(TerrainColumns* columns)
+{
+	for (int x = 0; x < columns->width; x++)
+		if (columns->columns[x].capacity > TERRAIN_COLUMN_INLINE_SPANS) free(columns->columns[x].heap);
+
+	free(columns->columns);
+	columns->columns = nullptr;
+}
+
+void EncodeTerrainColumns(TerrainColumns* columns, const int* mask, int x0, int x1)
+{
+	if (x0 < 0) x0 = 0;
+	if (x1 > columns->width) x1 = columns->width;
+	for (int x = x0; x < x1; x++) EncodeColumn(columns, mask, x);
+}
+
+void EncodeTerrainColumnRows(TerrainColumns* columns, const int* mask, TerrainRect rect)
+{
+	int x0 = rect.x < 0 ? 0 : rect.x, y0 = rect.y < 0 ? 0 : rect.y;
+	int x1 = rect.x + rect.width > columns->width ? columns->width : rect.x + rect.width;
+	int y1 = rect.y + rect.height > columns->height ? columns->height : rect.y + rect.height;
+
+	//clear the rows, then fill the mask's runs back; runs touching the edges merge with the spans outside
+	for (int x = x0; x < x1; x++)
+	{
+		CarveTerrainColumn(columns, x, y0, y1);
+		for (int y = y0; y < y1; )
+		{
+			if (!mask[y * columns->width + x]) { y++; continue; }
+
+			int top = y;
+			while (y < y1 && mask[y * columns->width + x]) y++;
+			FillTerrainColumn(columns, x, top, y);
+		}
+	}
+}
+
+bool IsTerrainColumnSolid(const TerrainColumns* columns, int x, int y)
+{
+	if ((unsigned int)x >= (unsigned int)columns->width || (unsigned int)y >= (unsigned int)columns->height) return false;
+
+	const TerrainColumn* column = &columns->columns[x];
+	const TerrainSpan* spans = ColumnSpans(column);
+	int i = FirstSpanEndingAfter(spans, column->count, y);
+	return i < column->count && spans[i].top <= y;
+}
+
+int FindTerrainColumnBelow(const TerrainColumns* columns, int x, int y, int maxDistance)
+{
+	if ((unsigned int)x >= (unsigned int)columns->width || y >= columns->height) return -1;
+
+	const TerrainColumn* column = &columns->columns[x];
+	const TerrainSpan* spans = ColumnSpans(column);
+	int i = FirstSpanEndingAfter(spans, column->count, y);
+	if (i == column->count) return -1;
+
+	int distance = spans[i].top > y ? spans[i].top - y : 0;
+	return distance <= maxDistance ? distance : -1;
+}
+
+void CarveTerrainColumn(TerrainColumns* columns, int x, int y0, int y1)
+{
+	if ((unsigned int)x >= (unsigned int)columns->width) return;
+	if (y0 < 0) y0 = 0;
+	if (y1 > columns->height) y1 = columns->height;
+	if (y0 >= y1) return;
+
+	TerrainColumn* column = &columns->columns[x];
+	const TerrainSpan* spans = ColumnSpans(column);
+	int first = FirstSpanEndingAfter(spans, column->count, y0);
+	int last = first;
+	while (last < column->count && spans[last].top < y1) last++;
+	if (first == last) return;
+
+	//what survives of the overlapped spans is at most a head and a tail
+	TerrainSpan pieces[2];
+	int pieceCount = 0;
+	if (spans[first].top < y0) pieces[pieceCount++] = { spans[first].top, (unsigned short)y0 };
+	if (spans[last - 1].bottom > y1) pieces[pieceCount++] = { (unsigned short)y1, spans[last - 1].bottom };
+
+	ReplaceSpans(column, first, last, pieces, pieceCount);
+}
+
+void FillTerrainColumn(TerrainColumns* columns, int x, int y0, int y1)
+{
+	if ((unsigned int)x >= (unsigned int)columns->width) return;
+	if (y0 < 0) y0 = 0;
+	if (y1 > columns->height) y1 = columns->height;
+	if (y0 >= y1) return;
+
+	//spans overlapping or touching [y0, y1) merge into one
+	TerrainColumn* column = &columns->columns[x];
+	const TerrainSpan* spans = ColumnSpans(column);
+	int first = FirstSpanEndingAfter(spans, column->count, y0 - 1);
+	int last = first;
+	while (last < column->count && spans[last].top <= y1) last++;
+
+	TerrainSpan merged = { (unsigned short)y0, (unsigned short)y1 };
+	if (first < last)
+	{
+		if (spans[first].top < merged.top) merged.top = spans[first].top;
+		if (spans[last - 1].bottom > merged.bottom) merged.bottom = spans[last - 1].bottom;
+	}
+
+	ReplaceSpans(column, first, last, &merged, 1);
+}
+
+const TerrainSpan* GetTerrainColumnSpans(const TerrainColumns* columns, int x, int* count)
+{
+	*count = columns->columns[x].count;
+	return ColumnSpans(&columns->columns[x]);
+}
+
+long GetTerrainColumnsBytes(const TerrainColumns* columns)
+{
+	long bytes = (long)columns->width * sizeof(TerrainColumn);
+	for (int x = 0; x < columns->width; x++)
+		if (columns->columns[x].capacity > TERRAIN_COLUMN_INLINE_SPANS) bytes += columns->columns[x].capacity * sizeof(TerrainSpan);
+
+	return bytes;
+}
@@ -0,0 +1,59 @@
+/*******************************************************************************************
+*
+*   Terrain Columns - terrain stored as run-length solid spans per column
+*
+*   Each column keeps its solid pixels as sorted, disjoint [top, bottom) spans. A map of
+*   ground under sky is one span per column, caves and craters add one each. A carve is
+*   an interval subtraction per column and a settled pixel an interval union, neither
+*   touches more than the spans it overlaps. Columns of up to two spans are stored inline,
+*   longer ones on the heap. Maps are limited to 65535 rows.
+*
+********************************************************************************************/
+
+#ifndef TERRAIN_COLUMNS_H
+#define TERRAIN_COLUMNS_H
+
+#include "terrain_events.h"
+
+#define TERRAIN_COLUMN_INLINE_SPANS      2
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct TerrainSpan {
+	unsigned short top, bottom;     // [top, bottom)
+} TerrainSpan;
+
+typedef struct TerrainColumn {
+	unsigned short count;
+	unsigned short capacity;        // TERRAIN_COLUMN_INLINE_SPANS while inline
+	union {
+		TerrainSpan local[TERRAIN_COLUMN_INLINE_SPANS];
+		TerrainSpan* heap;
+	};
+} TerrainColumn;
+
+typedef struct TerrainColumns {
+	int width, height;
+	TerrainColumn* columns;
+} TerrainColumns;
+
+//----------------------------------------------------------------------------------
+// Terrain Columns Functions Declaration
+//----------------------------------------------------------------------------------
+void InitTerrainColumns(TerrainColumns* columns, const int* mask, int width, int height);   // mask 1 = solid, may be null (all empty)
+void UnloadTerrainColumns(TerrainColumns* columns);
+
+void EncodeTerrainColumns(TerrainColumns* columns, const int* mask, int x0, int x1);   // Re-encode columns [x0, x1) from the mask
+void EncodeTerrainColumnRows(TerrainColumns* columns, const int* mask, TerrainRect rect);  // Splice rect's rows from the mask into its columns
+
+bool IsTerrainColumnSolid(const TerrainColumns* columns, int x, int y);     // False off the map
+int FindTerrainColumnBelow(const TerrainColumns* columns, int x, int y, int maxDistance);  // Rows down to the first solid pixel, -1 if none within maxDistance
+
+void CarveTerrainColumn(TerrainColumns* columns, int x, int y0, int y1);   // Clear [y0, y1) of column x
+void FillTerrainColumn(TerrainColumns* columns, int x, int y0, int y1);    // Set [y0, y1) of column x
+
+const TerrainSpan* GetTerrainColumnSpans(const TerrainColumns* columns, int x, int* count);
+long GetTerrainColumnsBytes(const TerrainColumns* columns);     // Column headers and heap spans
+
+#endif // TERRAIN_COLUMNS_H
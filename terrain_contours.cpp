@@ -0,0 +1,291 @@
+/*******************************************************************************************
+*
+*   Terrain Contours - marching squares outline of the solid terrain, rebuilt per dirty tile
+*
+********************************************************************************************/
+
+#include "terrain_contours.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------------
+// Module Variables Definition (local)
+//----------------------------------------------------------------------------------
+// Cell (i, j) has corners a (i-1, j-1), b (i, j-1), c (i, j), d (i-1, j), case a*8 + b*4 + c*2 + d
+// Edge midpoints 0 top, 1 right, 2 bottom, 3 left, as half pixel offsets from corner a
+static const int edgeX[4] = { 1, 2, 1, 0 };
+static const int edgeY[4] = { 0, 1, 2, 1 };
+static const int stepX[4] = { 0, 1, 0, -1 };       // Cell across each edge
+static const int stepY[4] = { -1, 0, 1, 0 };
+
+// from, to pairs per case, -1 ends the list, saddles keep the solid corners apart
+static const signed char caseEdges[16][4] = {
+	{ -1, -1, -1, -1 },
+	{ 3, 2, -1, -1 },       // d
+	{ 2, 1, -1, -1 },       // c
+	{ 3, 1, -1, -1 },       // c d
+	{ 1, 0, -1, -1 },       // b
+	{ 1, 0, 3, 2 },         // b d
+	{ 2, 0, -1, -1 },       // b c
+	{ 3, 0, -1, -1 },       // b c d
+	{ 0, 3, -1, -1 },       // a
+	{ 0, 2, -1, -1 },       // a d
+	{ 0, 3, 2, 1 },         // a c
+	{ 0, 1, -1, -1 },       // a c d
+	{ 1, 3, -1, -1 },       // a b
+	{ 1, 2, -1, -1 },       // a b d
+	{ 2, 3, -1, -1 },       // a b c
+	{ -1, -1, -1, -1 }
+};
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition (local)
+//----------------------------------------------------------------------------------
+static inline int Sample(const TerrainContours* contours, int x, int y)
+{
+	if ((unsigned int)x >= (unsigned int)contours->width || (unsigned int)y >= (unsigned int)contours->height) return 0;
+	return contours->mask[y * contours->width + x] != 0;
+}
+
+static void PushSegment(ContourTile* tile, int cell, int ox, int oy, int from, int to)
+{
+	if (tile->count == tile->capacity)
+	{
+		tile->capacity = tile->capacity > 0 ? tile->capacity * 2 : 64;
+		tile->segments = (ContourSegment*)realloc(tile->segments, tile->capacity * sizeof(ContourSegment));
+		tile->cells = (unsigned short*)realloc(tile->cells, tile->capacity * sizeof(unsigned short));
+	}
+
+	ContourSegment* segment = &tile->segments[tile->count];
+	segment->from = { ox + edgeX[from], oy + edgeY[from] };
+	segment->to = { ox + edgeX[to], oy + edgeY[to] };
+	tile->cells[tile->count++] = (unsigned short)cell;
+}
+
+static void RebuildTile(TerrainContours* contours, int tx, int ty)
+{
+	ContourTile* tile = &contours->tiles[ty * contours->tilesX + tx];
+	contours->stats.totalSegments -= tile->count;
+	tile->count = 0;
+
+	int i0 = tx * TERRAIN_TILE_SIZE, j0 = ty * TERRAIN_TILE_SIZE;
+	int i1 = i0 + TERRAIN_TILE_SIZE < contours->width + 1 ? i0 + TERRAIN_TILE_SIZE : contours->width + 1;
+	int j1 = j0 + TERRAIN_TILE_SIZE < contours->height + 1 ? j0 + TERRAIN_TILE_SIZE : contours->height + 1;
+
+	for (int j = j0; j < j1; j++)
+	{
+		//the right corners of one cell are the left corners of the next
+		int a = Sample(contours, i0 - 1, j - 1), d = Sample(contours, i0 - 1, j);
+		for (int i = i0; i < i1; i++)
+		{
+			int b = Sample(contours, i, j - 1), c = Sample(contours, i, j);
+			const signed char* edges = caseEdges[a * 8 + b * 4 + c * 2 + d];
+			if (edges[0] >= 0)
+			{
+				int cell = (j - j0) * TERRAIN_TILE_SIZE + (i - i0);
+				PushSegment(tile, cell, 2 * (i - 1), 2 * (j - 1), edges[0], edges[1]);
+				if (edges[2] >= 0) PushSegment(tile, cell, 2 * (i - 1), 2 * (j - 1), edges[2], edges[3]);
+			}
+			a = b;
+			d = c;
+		}
+	}
+
+	contours->stats.tilesRebuilt++;
+	contours->stats.segmentsRebuilt += tile->count;
+	contours->stats.totalSegments += tile->count;
+}
+
+// Segment of cell (i, j) starting at point, -1 if none
+static int FindSegment(const TerrainContours* contours, int i, int j, ContourPoint from, int* tileIndex)
+{
+	if (i < 0 || j < 0 || i > contours->width || j > contours->height) return -1;
+
+	int tx = i / TERRAIN_TILE_SIZE, ty = j / TERRAIN_TILE_SIZE;
+	const ContourTile* tile = &contours->tiles[ty * contours->tilesX + tx];
+	int cell = (j - ty * TERRAIN_TILE_SIZE) * TERRAIN_TILE_SIZE + (i - tx * TERRAIN_TILE_SIZE);
+
+	//segments are in cell order, at most two per cell
+	int lo = 0, hi = tile->count;
+	while (lo < hi)
+	{
+		int mid = (lo + hi) >> 1;
+		if (tile->cells[mid] < cell) lo = mid + 1;
+		else hi = mid;
+	}
+
+	for (int s = lo; s < tile->count && tile->cells[s] == cell; s++)
+		if (tile->segments[s].from.x == from.x && tile->segments[s].from.y == from.y)
+		{
+			*tileIndex = ty * contours->tilesX + tx;
+			return s;
+		}
+
+	return -1;
+}
+
+// Edge of the cell with corner a at (ox, oy) that point sits on
+static int EdgeOf(ContourPoint point, int ox, int oy)
+{
+	for (int e = 0; e < 4; e++)
+		if (point.x == ox + edgeX[e] && point.y == oy + edgeY[e]) return e;
+	return -1;
+}
+
+//----------------------------------------------------------------------------------
+// Terrain Contours Functions Definition
+//----------------------------------------------------------------------------------
+void InitTerrainContours(TerrainContours* contours, const int* mask, int width, int height)
+{
+	contours->mask = mask;
+	contours->width = width;
+	contours->height = height;
+	contours->tilesX = (width + 1 + TERRAIN_TILE_SIZE - 1) / TERRAIN_TILE_SIZE;
+	contours->tilesY = (height + 1 + TERRAIN_TILE_SIZE - 1) / TERRAIN_TILE_SIZE;
+	contours->tiles = (ContourTile*)calloc(contours->tilesX * contours->tilesY, sizeof(ContourTile));
+	memset(&contours->stats, 0, sizeof(ContourStats));
+
+	for (int ty = 0; ty < contours->tilesY; ty++)
+		for (int tx = 0; tx < contours->tilesX; tx++) RebuildTile(contours, tx, ty);
+}
+
+void UnloadTerrainContours(TerrainContours* contours)
+{
+	for (int t = 0; t < contours->tilesX * contours->tilesY; t++)
+	{
+		free(contours->tiles[t].segments);
+		free(contours->tiles[t].cells);
+	}
+	free(contours->tiles);
+	contours->tiles = nullptr;
+}
+
+void UpdateTerrainContours(TerrainContours* contours, TerrainRect rect)
+{
+	contours->stats.tilesRebuilt = 0;
+	contours->stats.segmentsRebuilt = 0;
+
+	//cells i in [x, x + width] have a corner in the rect
+	int tx0 = rect.x < 0 ? 0 : rect.x / TERRAIN_TILE_SIZE;
+	int ty0 = rect.y < 0 ? 0 : rect.y / TERRAIN_TILE_SIZE;
+	int tx1 = (rect.x + rect.width) / TERRAIN_TILE_SIZE;
+	int ty1 = (rect.y + rect.height) / TERRAIN_TILE_SIZE;
+	if (tx1 >= contours->tilesX) tx1 = contours->tilesX - 1;
+	if (ty1 >= contours->tilesY) ty1 = contours->tilesY - 1;
+
+	for (int ty = ty0; ty <= ty1; ty++)
+		for (int tx = tx0; tx <= tx1; tx++) RebuildTile(contours, tx, ty);
+}
+
+void OnTerrainChangedContours(const TerrainRect* rects, int count, unsigned int version, void* contours)
+{
+	TerrainContours* c = (TerrainContours*)contours;
+	int tiles = 0, segments = 0;
+	for (int i = 0; i < count; i++)
+	{
+		UpdateTerrainContours(c, rects[i]);
+		tiles += c->stats.tilesRebuilt;
+		segments += c->stats.segmentsRebuilt;
+	}
+
+	c->stats.tilesRebuilt = tiles;
+	c->stats.segmentsRebuilt = segments;
+}
+
+int GetTerrainContourSegments(const TerrainContours* contours, TerrainRect rect, ContourSegment* segments, int maxSegments)
+{
+	int tx0 = rect.x < 0 ? 0 : rect.x / TERRAIN_TILE_SIZE;
+	int ty0 = rect.y < 0 ? 0 : rect.y / TERRAIN_TILE_SIZE;
+	int tx1 = (rect.x + rect.width) / TERRAIN_TILE_SIZE;
+	int ty1 = (rect.y + rect.height) / TERRAIN_TILE_SIZE;
+	if (tx1 >= contours->tilesX) tx1 = contours->tilesX - 1;
+	if (ty1 >= contours->tilesY) ty1 = contours->tilesY - 1;
+
+	int written = 0;
+	for (int ty = ty0; ty <= ty1; ty++)
+		for (int tx = tx0; tx <= tx1; tx++)
+		{
+			const ContourTile* tile = &contours->tiles[ty * contours->tilesX + tx];
+			int n = tile->count < maxSegments - written ? tile->count : maxSegments - written;
+			memcpy(segments + written, tile->segments, n * sizeof(ContourSegment));
+			written += n;
+			if (written == maxSegments) return written;
+		}
+
+	return written;
+}
+
+int TraceTerrainContours(const TerrainContours* contours, ContourLoopCallback callback, void* userData)
+{
+	int tileCount = contours->tilesX * contours->tilesY;
+	int* firstVisit = (int*)malloc((tileCount + 1) * sizeof(int));
+	firstVisit[0] = 0;
+	for (int t = 0; t < tileCount; t++) firstVisit[t + 1] = firstVisit[t] + contours->tiles[t].count;
+	bool* visited = (bool*)calloc(firstVisit[tileCount] + 1, sizeof(bool));
+
+	int capacity = 256, loops = 0;
+	ContourPoint* points = (ContourPoint*)malloc(capacity * sizeof(ContourPoint));
+
+	for (int t = 0; t < tileCount; t++)
+		for (int s = 0; s < contours->tiles[t].count; s++)
+		{
+			if (visited[firstVisit[t] + s]) continue;
+
+			//follow to-points through the neighbouring cells until back at the start
+			int count = 0, tile = t, segment = s;
+			int lastDx = 0, lastDy = 0, firstDx = 0, firstDy = 0;
+			for (;;)
+			{
+				visited[firstVisit[tile] + segment] = true;
+				const ContourSegment* current = &contours->tiles[tile].segments[segment];
+				int dx = current->to.x - current->from.x, dy = current->to.y - current->from.y;
+
+				//keep only the points where the direction turns
+				if (count == 0 || dx != lastDx || dy != lastDy)
+				{
+					if (count == capacity)
+					{
+						capacity *= 2;
+						points = (ContourPoint*)realloc(points, capacity * sizeof(ContourPoint));
+					}
+					if (count == 0)
+					{
+						firstDx = dx;
+						firstDy = dy;
+					}
+					points[count++] = current->from;
+				}
+				lastDx = dx;
+				lastDy = dy;
+
+				int cellIndex = contours->tiles[tile].cells[segment];
+				int tx = tile % contours->tilesX, ty = tile / contours->tilesX;
+				int i = tx * TERRAIN_TILE_SIZE + cellIndex % TERRAIN_TILE_SIZE;
+				int j = ty * TERRAIN_TILE_SIZE + cellIndex / TERRAIN_TILE_SIZE;
+				int edge = EdgeOf(current->to, 2 * (i - 1), 2 * (j - 1));
+
+				int nextTile = -1;
+				int next = FindSegment(contours, i + stepX[edge], j + stepY[edge], current->to, &nextTile);
+				if (next < 0 || visited[firstVisit[nextTile] + next]) break;
+
+				tile = nextTile;
+				segment = next;
+			}
+
+			//the start is a straight continuation of the closing run
+			if (count > 1 && lastDx == firstDx && lastDy == firstDy)
+			{
+				memmove(points, points + 1, (count - 1) * sizeof(ContourPoint));
+				count--;
+			}
+
+			callback(points, count, userData);
+			loops++;
+		}
+
+	free(points);
+	free(visited);
+	free(firstVisit);
+	return loops;
+}
@@ -0,0 +1,73 @@
+/*******************************************************************************************
+*
+*   Terrain Contours - marching squares outline of the solid terrain, rebuilt per dirty tile
+*
+*   Cells sit between four pixel centres, off-map pixels count as empty so every outline
+*   closes. Each cell gives at most two segments between edge midpoints, oriented with the
+*   solid side on the right (y down), and saddles keep the two solid corners apart. Points
+*   are in half pixels: pixel (x, y) has its centre at (2x, 2y), so segments from
+*   neighbouring cells share exact endpoints.
+*
+*   Segments are kept per TERRAIN_TILE_SIZE tile of cells and a carve only re-runs the
+*   tiles its rect reaches. Every vertex starts exactly one segment, so stitching across
+*   tile borders is a lookup in the neighbouring cell; loops are only traced when asked
+*   for, and simplified to the points where the direction turns.
+*
+********************************************************************************************/
+
+#ifndef TERRAIN_CONTOURS_H
+#define TERRAIN_CONTOURS_H
+
+#include "terrain_events.h"
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct ContourPoint {
+	int x, y;                       // Half pixels
+} ContourPoint;
+
+typedef struct ContourSegment {
+	ContourPoint from, to;          // Solid on the right going from -> to
+} ContourSegment;
+
+typedef struct ContourTile {
+	int count, capacity;
+	ContourSegment* segments;       // In cell order
+	unsigned short* cells;          // Cell of each segment, row-major within the tile
+} ContourTile;
+
+typedef struct ContourStats {
+	int tilesRebuilt;               // Last update
+	int segmentsRebuilt;
+	long totalSegments;             // Whole map
+} ContourStats;
+
+typedef struct TerrainContours {
+	const int* mask;                // 1 = solid, not owned
+	int width, height;
+	int tilesX, tilesY;             // Over the (width + 1) x (height + 1) cells
+	ContourTile* tiles;
+
+	ContourStats stats;
+} TerrainContours;
+
+// Called per traced loop, points are closed (the last joins the first)
+typedef void (*ContourLoopCallback)(const ContourPoint* points, int count, void* userData);
+
+//----------------------------------------------------------------------------------
+// Terrain Contours Functions Declaration
+//----------------------------------------------------------------------------------
+void InitTerrainContours(TerrainContours* contours, const int* mask, int width, int height);
+void UnloadTerrainContours(TerrainContours* contours);
+
+void UpdateTerrainContours(TerrainContours* contours, TerrainRect rect);   // Re-run the tiles whose cells touch rect
+void OnTerrainChangedContours(const TerrainRect* rects, int count, unsigned int version, void* contours);  // Terrain events subscriber
+
+// Segments of the tiles overlapping rect (pixels), returns how many were written
+int GetTerrainContourSegments(const TerrainContours* contours, TerrainRect rect, ContourSegment* segments, int maxSegments);
+
+// Stitch and trace every loop once, returns the number of loops
+int TraceTerrainContours(const TerrainContours* contours, ContourLoopCallback callback, void* userData);
+
+#endif // TERRAIN_CONTOURS_H
@@ -0,0 +1,195 @@
+/*******************************************************************************************
+*
+*   Terrain Density - summed-area table of the terrain mask in per-tile blocks
+*
+********************************************************************************************/
+
+#include "terrain_density.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TILE TERRAIN_TILE_SIZE
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition (local)
+//----------------------------------------------------------------------------------
+static void BuildLocal(TerrainDensity* density, int tx, int ty)
+{
+	unsigned short* local = density->local + (size_t)(ty * density->tilesX + tx) * TILE * TILE;
+	int x0 = tx * TILE, y0 = ty * TILE;
+	int w = density->width - x0 < TILE ? density->width - x0 : TILE;
+	int h = density->height - y0 < TILE ? density->height - y0 : TILE;
+
+	//pixels past the map edge count as empty, so the last row and column always hold the tile totals
+	for (int ly = 0; ly < TILE; ly++)
+	{
+		const int* row = ly < h ? density->mask + (size_t)(y0 + ly) * density->width + x0 : nullptr;
+		unsigned short* out = local + ly * TILE;
+		const unsigned short* up = ly > 0 ? out - TILE : nullptr;
+		int run = 0;
+		for (int lx = 0; lx < TILE; lx++)
+		{
+			if (ly < h && lx < w) run += row[lx] != 0;
+			out[lx] = (unsigned short)(run + (up ? up[lx] : 0));
+		}
+	}
+}
+
+static inline int TileTotal(const TerrainDensity* density, int tile)
+{
+	return density->local[(size_t)tile * TILE * TILE + TILE * TILE - 1];
+}
+
+// Solid pixels in [0, x) x [0, y), with 0 <= x <= width and 0 <= y <= height
+static inline int SumTo(const TerrainDensity* density, int x, int y)
+{
+	if (x == 0 || y == 0) return 0;
+
+	//the tile holding pixel (x - 1, y - 1), local coordinates 1..TILE
+	int tx = (x - 1) / TILE, ty = (y - 1) / TILE;
+	int lx = x - tx * TILE - 1, ly = y - ty * TILE - 1;
+	int tile = ty * density->tilesX + tx;
+	return density->grid[tile] + density->above[tile * TILE + lx] + density->left[tile * TILE + ly] +
+		density->local[(size_t)tile * TILE * TILE + ly * TILE + lx];
+}
+
+static void RebuildDirty(TerrainDensity* density)
+{
+	int tilesX = density->tilesX, tilesY = density->tilesY;
+	int minTx = tilesX, minTy = tilesY;
+	density->stats.tilesRebuilt = 0;
+	density->stats.stripsUpdated = 0;
+
+	for (int ty = 0; ty < tilesY; ty++)
+		for (int tx = 0; tx < tilesX; tx++)
+		{
+			if (!density->dirty[ty * tilesX + tx]) continue;
+			BuildLocal(density, tx, ty);
+			if (tx < minTx) minTx = tx;
+			if (ty < minTy) minTy = ty;
+			density->stats.tilesRebuilt++;
+		}
+	if (density->stats.tilesRebuilt == 0) return;
+
+	//above strips, down each tile column from its first dirty tile
+	for (int tx = minTx; tx < tilesX; tx++)
+	{
+		int first = 0;
+		while (first < tilesY && !density->dirty[first * tilesX + tx]) first++;
+		for (int ty = first + 1; ty < tilesY; ty++)
+		{
+			int tile = ty * tilesX + tx, up = tile - tilesX;
+			const unsigned short* bottom = density->local + (size_t)up * TILE * TILE + (TILE - 1) * TILE;
+			for (int lx = 0; lx < TILE; lx++) density->above[tile * TILE + lx] = density->above[up * TILE + lx] + bottom[lx];
+			density->stats.stripsUpdated++;
+		}
+	}
+
+	//left strips, along each tile row from its first dirty tile
+	for (int ty = minTy; ty < tilesY; ty++)
+	{
+		int first = 0;
+		while (first < tilesX && !density->dirty[ty * tilesX + first]) first++;
+		for (int tx = first + 1; tx < tilesX; tx++)
+		{
+			int tile = ty * tilesX + tx, prev = tile - 1;
+			const unsigned short* right = density->local + (size_t)prev * TILE * TILE + TILE - 1;
+			for (int ly = 0; ly < TILE; ly++) density->left[tile * TILE + ly] = density->left[prev * TILE + ly] + right[ly * TILE];
+			density->stats.stripsUpdated++;
+		}
+	}
+
+	//tile grid below and right of the first dirty tile
+	for (int ty = minTy + 1; ty < tilesY; ty++)
+		for (int tx = minTx + 1; tx < tilesX; tx++)
+		{
+			int tile = ty * tilesX + tx;
+			density->grid[tile] = density->grid[tile - tilesX] + density->grid[tile - 1] - density->grid[tile - tilesX - 1] +
+				TileTotal(density, tile - tilesX - 1);
+		}
+
+	memset(density->dirty, 0, tilesX * tilesY * sizeof(bool));
+}
+
+static void MarkDirty(TerrainDensity* density, TerrainRect rect)
+{
+	int x0 = rect.x < 0 ? 0 : rect.x, y0 = rect.y < 0 ? 0 : rect.y;
+	int x1 = rect.x + rect.width > density->width ? density->width : rect.x + rect.width;
+	int y1 = rect.y + rect.height > density->height ? density->height : rect.y + rect.height;
+	if (x0 >= x1 || y0 >= y1) return;
+
+	for (int ty = y0 / TILE; ty <= (y1 - 1) / TILE; ty++)
+		for (int tx = x0 / TILE; tx <= (x1 - 1) / TILE; tx++) density->dirty[ty * density->tilesX + tx] = true;
+}
+
+//----------------------------------------------------------------------------------
+// Terrain Density Functions Definition
+//----------------------------------------------------------------------------------
+void InitTerrainDensity(TerrainDensity* density, const int* mask, int width, int height)
+{
+	density->mask = mask;
+	density->width = width;
+	density->height = height;
+	density->tilesX = (width + TILE - 1) / TILE;
+	density->tilesY = (height + TILE - 1) / TILE;
+
+	int tiles = density->tilesX * density->tilesY;
+	density->local = (unsigned short*)malloc((size_t)tiles * TILE * TILE * sizeof(unsigned short));
+	density->above = (int*)calloc((size_t)tiles * TILE, sizeof(int));
+	density->left = (int*)calloc((size_t)tiles * TILE, sizeof(int));
+	density->grid = (int*)calloc(tiles, sizeof(int));
+	density->dirty = (bool*)malloc(tiles * sizeof(bool));
+
+	//everything dirty is one full build
+	memset(density->dirty, 1, tiles * sizeof(bool));
+	RebuildDirty(density);
+}
+
+void UnloadTerrainDensity(TerrainDensity* density)
+{
+	free(density->local);
+	free(density->above);
+	free(density->left);
+	free(density->grid);
+	free(density->dirty);
+	density->local = nullptr;
+	density->above = nullptr;
+	density->left = nullptr;
+	density->grid = nullptr;
+	density->dirty = nullptr;
+}
+
+void UpdateTerrainDensity(TerrainDensity* density, TerrainRect rect)
+{
+	MarkDirty(density, rect);
+	RebuildDirty(density);
+}
+
+void OnTerrainChangedDensity(const TerrainRect* rects, int count, unsigned int version, void* density)
+{
+	TerrainDensity* d = (TerrainDensity*)density;
+	for (int i = 0; i < count; i++) MarkDirty(d, rects[i]);
+	RebuildDirty(d);
+}
+
+int GetTerrainSum(const TerrainDensity* density, TerrainRect rect)
+{
+	int x0 = rect.x < 0 ? 0 : rect.x, y0 = rect.y < 0 ? 0 : rect.y;
+	int x1 = rect.x + rect.width > density->width ? density->width : rect.x + rect.width;
+	int y1 = rect.y + rect.height > density->height ? density->height : rect.y + rect.height;
+	if (x0 >= x1 || y0 >= y1) return 0;
+
+	return SumTo(density, x1, y1) - SumTo(density, x0, y1) - SumTo(density, x1, y0) + SumTo(density, x0, y0);
+}
+
+float GetTerrainDensity(const TerrainDensity* density, TerrainRect rect)
+{
+	if (rect.width <= 0 || rect.height <= 0) return 0;
+	return (float)GetTerrainSum(density, rect) / ((float)rect.width * rect.height);
+}
+
+void QueryTerrainSums(const TerrainDensity* density, const TerrainRect* rects, int count, int* sums)
+{
+	for (int i = 0; i < count; i++) sums[i] = GetTerrainSum(density, rects[i]);
+}
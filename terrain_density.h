@@ -0,0 +1,59 @@
+/*******************************************************************************************
+*
+*   Terrain Density - summed-area table of the terrain mask in per-tile blocks
+*
+*   The count of solid pixels above and left of any point is four lookups: the whole tiles
+*   above-left of its tile, the partial columns of the tiles above it, the partial rows of
+*   the tiles left of it, and the tile's own local table. Any rectangle is then four such
+*   points, O(1) whatever its size.
+*
+*   A plain summed-area table would rewrite everything below and right of a carve. Here a
+*   change rebuilds the local tables of the tiles it touches, then only the strips of the
+*   tiles below them in their tile columns, the strips right of them in their tile rows,
+*   and the tile grid downstream of the first dirty tile.
+*
+********************************************************************************************/
+
+#ifndef TERRAIN_DENSITY_H
+#define TERRAIN_DENSITY_H
+
+#include "terrain_events.h"
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct TerrainDensityStats {
+	int tilesRebuilt;               // Last update
+	int stripsUpdated;              // Tile strips redone downstream of them
+} TerrainDensityStats;
+
+typedef struct TerrainDensity {
+	const int* mask;                // 1 = solid, not owned
+	int width, height;
+	int tilesX, tilesY;
+
+	unsigned short* local;          // Per tile, TERRAIN_TILE_SIZE^2 inclusive sums within the tile
+	int* above;                     // Per tile and local column, solids of the tiles above it in columns 0..lx
+	int* left;                      // Per tile and local row, solids of the tiles left of it in rows 0..ly
+	int* grid;                      // Per tile, solids of all the tiles above-left of it
+	bool* dirty;
+
+	TerrainDensityStats stats;
+} TerrainDensity;
+
+//----------------------------------------------------------------------------------
+// Terrain Density Functions Declaration
+//----------------------------------------------------------------------------------
+void InitTerrainDensity(TerrainDensity* density, const int* mask, int width, int height);
+void UnloadTerrainDensity(TerrainDensity* density);
+
+void UpdateTerrainDensity(TerrainDensity* density, TerrainRect rect);  // Rebuild the tiles under rect and what follows them
+void OnTerrainChangedDensity(const TerrainRect* rects, int count, unsigned int version, void* density);   // Terrain events subscriber, one downstream pass per flush
+
+int GetTerrainSum(const TerrainDensity* density, TerrainRect rect);       // Solid pixels in rect, outside the map counts as empty
+float GetTerrainDensity(const TerrainDensity* density, TerrainRect rect); // Solid fraction of rect, 0 if it is empty
+
+// sums[i] = GetTerrainSum(density, rects[i])
+void QueryTerrainSums(const TerrainDensity* density, const TerrainRect* rects, int count, int* sums);
+
+#endif // TERRAIN_DENSITY_H
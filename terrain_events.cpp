@@ -0,0 +1,190 @@
+/*******************************************************************************************
+*
+*   Terrain Events - dirty-region change bus for terrain writes
+*
+********************************************************************************************/
+
+#include "terrain_events.h"
+
+#include <stdlib.h>
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct TerrainSubscriber {
+	TerrainChangedCallback callback;
+	void* userData;
+} TerrainSubscriber;
+
+//----------------------------------------------------------------------------------
+// Module Variables Definition (local)
+//----------------------------------------------------------------------------------
+static int mapWidth = 0;
+static int mapHeight = 0;
+
+static TerrainSubscriber subscribers[TERRAIN_MAX_SUBSCRIBERS] = { 0 };
+
+static TerrainRect pending[TERRAIN_MAX_PENDING_RECTS] = { 0 };
+static int pendingCount = 0;
+
+static unsigned int version = 0;
+static unsigned int* tileVersions = nullptr;
+static int tilesX = 0;
+static int tilesY = 0;
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition (local)
+//----------------------------------------------------------------------------------
+static TerrainRect UnionRect(TerrainRect a, TerrainRect b)
+{
+	int x0 = a.x < b.x ? a.x : b.x;
+	int y0 = a.y < b.y ? a.y : b.y;
+	int x1 = a.x + a.width > b.x + b.width ? a.x + a.width : b.x + b.width;
+	int y1 = a.y + a.height > b.y + b.height ? a.y + a.height : b.y + b.height;
+	return { x0, y0, x1 - x0, y1 - y0 };
+}
+
+// Overlapping or edge-adjacent rects are merged, the union covers no extra area worth keeping apart
+static bool RectsTouch(TerrainRect a, TerrainRect b)
+{
+	return a.x <= b.x + b.width && b.x <= a.x + a.width &&
+		a.y <= b.y + b.height && b.y <= a.y + a.height;
+}
+
+static long Area(TerrainRect r) { return (long)r.width * r.height; }
+
+//merge until no two pending rects touch, each merge can make a new pair touch
+static void MergePending()
+{
+	bool merged = true;
+	while (merged)
+	{
+		merged = false;
+		for (int i = 0; i < pendingCount; i++)
+			for (int j = i + 1; j < pendingCount; j++)
+			{
+				if (!RectsTouch(pending[i], pending[j])) continue;
+
+				pending[i] = UnionRect(pending[i], pending[j]);
+				pending[j] = pending[--pendingCount];
+				merged = true;
+				j--;
+			}
+	}
+}
+
+//----------------------------------------------------------------------------------
+// Terrain Events Functions Definition
+//----------------------------------------------------------------------------------
+void InitTerrainEvents(int width, int height)
+{
+	mapWidth = width;
+	mapHeight = height;
+
+	tilesX = (width + TERRAIN_TILE_SIZE - 1) / TERRAIN_TILE_SIZE;
+	tilesY = (height + TERRAIN_TILE_SIZE - 1) / TERRAIN_TILE_SIZE;
+	free(tileVersions);
+	tileVersions = (unsigned int*)calloc(tilesX * tilesY, sizeof(unsigned int));
+
+	version = 0;
+	pendingCount = 0;
+}
+
+void UnloadTerrainEvents()
+{
+	free(tileVersions);
+	tileVersions = nullptr;
+	pendingCount = 0;
+	for (int i = 0; i < TERRAIN_MAX_SUBSCRIBERS; i++) subscribers[i] = { 0 };
+}
+
+int SubscribeTerrainChanges(TerrainChangedCallback callback, void* userData)
+{
+	for (int i = 0; i < TERRAIN_MAX_SUBSCRIBERS; i++)
+	{
+		if (subscribers[i].callback != nullptr) continue;
+
+		subscribers[i].callback = callback;
+		subscribers[i].userData = userData;
+		return i;
+	}
+
+	return -1;
+}
+
+void UnsubscribeTerrainChanges(int id)
+{
+	if (id < 0 || id >= TERRAIN_MAX_SUBSCRIBERS) return;
+	subscribers[id] = { 0 };
+}
+
+void PublishTerrainChange(TerrainRect rect)
+{
+	//clip to the map, writes hanging off the edges are common (blasts near borders)
+	if (rect.x < 0) { rect.width += rect.x; rect.x = 0; }
+	if (rect.y < 0) { rect.height += rect.y; rect.y = 0; }
+	if (rect.x + rect.width > mapWidth) rect.width = mapWidth - rect.x;
+	if (rect.y + rect.height > mapHeight) rect.height = mapHeight - rect.y;
+	if (rect.width <= 0 || rect.height <= 0) return;
+
+	if (pendingCount < TERRAIN_MAX_PENDING_RECTS)
+	{
+		pending[pendingCount++] = rect;
+		return;
+	}
+
+	//list full, grow whichever pending rect costs the least extra area
+	int best = 0;
+	long bestGrowth = -1;
+	for (int i = 0; i < pendingCount; i++)
+	{
+		long growth = Area(UnionRect(pending[i], rect)) - Area(pending[i]);
+		if (bestGrowth < 0 || growth < bestGrowth)
+		{
+			best = i;
+			bestGrowth = growth;
+		}
+	}
+	pending[best] = UnionRect(pending[best], rect);
+}
+
+void FlushTerrainChanges()
+{
+	if (pendingCount == 0) return;
+
+	MergePending();
+	version++;
+
+	//take a copy so subscribers may publish follow-up writes for the next flush
+	TerrainRect merged[TERRAIN_MAX_PENDING_RECTS];
+	int count = pendingCount;
+	for (int i = 0; i < count; i++) merged[i] = pending[i];
+	pendingCount = 0;
+
+	for (int i = 0; i < count; i++)
+	{
+		TerrainRect r = merged[i];
+		int tx1 = (r.x + r.width - 1) / TERRAIN_TILE_SIZE;
+		int ty1 = (r.y + r.height - 1) / TERRAIN_TILE_SIZE;
+		for (int ty = r.y / TERRAIN_TILE_SIZE; ty <= ty1; ty++)
+			for (int tx = r.x / TERRAIN_TILE_SIZE; tx <= tx1; tx++)
+				tileVersions[ty * tilesX + tx] = version;
+	}
+
+	for (int i = 0; i < TERRAIN_MAX_SUBSCRIBERS; i++)
+	{
+		if (subscribers[i].callback == nullptr) continue;
+		subscribers[i].callback(merged, count, version, subscribers[i].userData);
+	}
+}
+
+unsigned int GetTerrainVersion() { return version; }
+
+unsigned int GetTerrainTileVersion(int tx, int ty)
+{
+	if (tx < 0 || ty < 0 || tx >= tilesX || ty >= tilesY) return 0;
+	return tileVersions[ty * tilesX + tx];
+}
+
+int GetTerrainTilesX() { return tilesX; }
+int GetTerrainTilesY() { return tilesY; }
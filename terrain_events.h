@@ -0,0 +1,47 @@
+/*******************************************************************************************
+*
+*   Terrain Events - dirty-region change bus for terrain writes
+*
+*   Carves and any other terrain writes publish the rectangle they touched. Once per frame
+*   FlushTerrainChanges() merges the pending rectangles, bumps the terrain version and the
+*   version of every tile they cover, then hands the merged list to each subscriber so it
+*   can redo only the work for those regions (texture upload, indices, caches...).
+*
+********************************************************************************************/
+
+#ifndef TERRAIN_EVENTS_H
+#define TERRAIN_EVENTS_H
+
+#define TERRAIN_TILE_SIZE               64      // Tile edge in pixels, shared by tile-based caches
+#define TERRAIN_MAX_SUBSCRIBERS         16
+#define TERRAIN_MAX_PENDING_RECTS       64      // Above this, new rects are folded into the closest one
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct TerrainRect {
+	int x, y;
+	int width, height;
+} TerrainRect;
+
+// Called with the merged dirty rects of one flush, rects are clipped to the map
+typedef void (*TerrainChangedCallback)(const TerrainRect* rects, int count, unsigned int version, void* userData);
+
+//----------------------------------------------------------------------------------
+// Terrain Events Functions Declaration
+//----------------------------------------------------------------------------------
+void InitTerrainEvents(int width, int height);
+void UnloadTerrainEvents();
+
+int SubscribeTerrainChanges(TerrainChangedCallback callback, void* userData);   // Returns subscription id, -1 if full
+void UnsubscribeTerrainChanges(int id);
+
+void PublishTerrainChange(TerrainRect rect);     // Queue a dirty rect, delivered on the next flush
+void FlushTerrainChanges();                      // Merge and deliver pending rects, once per frame
+
+unsigned int GetTerrainVersion();
+unsigned int GetTerrainTileVersion(int tx, int ty);
+int GetTerrainTilesX();
+int GetTerrainTilesY();
+
+#endif // TERRAIN_EVENTS_H
@@ -0,0 +1,214 @@
+/*******************************************************************************************
+*
+*   Terrain Gen - seedable procedural terrain for stress maps
+*
+********************************************************************************************/
+
+#include "terrain_gen.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <atomic>
+#include <vector>
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct GenContext {
+	const TerrainGenParams* params;
+	unsigned char* pixels;
+	int* mask;
+
+	int* surface;                   // Surface row per column, indexed from -overhang
+	int* bandMin;                   // Lowest / highest surface within +-overhang of each column
+	int* bandMax;
+
+	int tilesX, tilesY;
+	std::atomic<int> nextTile;
+} GenContext;
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition (local)
+//----------------------------------------------------------------------------------
+
+// Integer hash of a lattice point, the only source of randomness
+static inline unsigned int Hash(unsigned int seed, int x, int y)
+{
+	unsigned int h = seed ^ ((unsigned int)x * 0x27D4EB2Du) ^ ((unsigned int)y * 0x165667B1u);
+	h ^= h >> 15;
+	h *= 0x85EBCA6Bu;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35u;
+	h ^= h >> 16;
+	return h;
+}
+
+static inline int FloorDiv(int a, int b) { return a >= 0 ? a / b : -((-a + b - 1) / b); }
+
+// Smoothstep in 16.16 fixed point
+static inline long long Fade(long long t) { return (t * t >> 16) * ((3 << 16) - 2 * t) >> 16; }
+
+// Value noise in [0, 65535], fixed point throughout so every platform agrees
+static int ValueNoise(unsigned int seed, int x, int y, int cell)
+{
+	int cx = FloorDiv(x, cell), cy = FloorDiv(y, cell);
+	long long tx = Fade(((long long)(x - cx * cell) << 16) / cell);
+	long long ty = Fade(((long long)(y - cy * cell) << 16) / cell);
+
+	long long a = Hash(seed, cx, cy) & 0xFFFF, b = Hash(seed, cx + 1, cy) & 0xFFFF;
+	long long c = Hash(seed, cx, cy + 1) & 0xFFFF, d = Hash(seed, cx + 1, cy + 1) & 0xFFFF;
+
+	long long top = a + ((b - a) * tx >> 16);
+	long long bottom = c + ((d - c) * tx >> 16);
+	return (int)(top + ((bottom - top) * ty >> 16));
+}
+
+// Fractal sum of octaves, halving cell and amplitude each time, normalised to [0, 65535]
+static int FractalNoise(unsigned int seed, int x, int y, int cell, int octaves)
+{
+	long long sum = 0, total = 0;
+	int amplitude = 1 << octaves;
+	for (int o = 0; o < octaves && cell > 0; o++)
+	{
+		sum += (long long)ValueNoise(seed + o * 1013, x, y, cell) * amplitude;
+		total += amplitude;
+		amplitude >>= 1;
+		cell >>= 1;
+	}
+
+	return (int)(sum / total);
+}
+
+static bool IsSolid(GenContext* ctx, int x, int y)
+{
+	const TerrainGenParams* p = ctx->params;
+	int ov = p->overhang;
+
+	if (y < ctx->bandMin[x]) return false;
+
+	//inside the surface band the surface is read at a warped column, which folds it into overhangs
+	if (y <= ctx->bandMax[x])
+	{
+		int warp = ov > 0 ? (FractalNoise(p->seed ^ 0xA5A5A5A5u, x, y, 64, 3) - 32768) * ov / 32768 : 0;
+		if (y < ctx->surface[x + ov + warp]) return false;
+	}
+
+	//caves: ridged noise opens thin winding tunnels, leaving a crust under the surface
+	if (p->caveDensity > 0 && y > ctx->surface[x + ov] + 12)
+	{
+		int n = FractalNoise(p->seed ^ 0x5EED5EEDu, x, y, 96, 3) - 32768;
+		if (n < 0) n = -n;
+		if (n < p->caveDensity * 60) return false;
+	}
+
+	return true;
+}
+
+static void GenerateTile(GenContext* ctx, int tx, int ty)
+{
+	const TerrainGenParams* p = ctx->params;
+	int x0 = tx * TERRAINGEN_TILE_SIZE, y0 = ty * TERRAINGEN_TILE_SIZE;
+	int x1 = x0 + TERRAINGEN_TILE_SIZE > p->width ? p->width : x0 + TERRAINGEN_TILE_SIZE;
+	int y1 = y0 + TERRAINGEN_TILE_SIZE > p->height ? p->height : y0 + TERRAINGEN_TILE_SIZE;
+
+	for (int y = y0; y < y1; y++)
+		for (int x = x0; x < x1; x++)
+		{
+			int ix = y * p->width + x;
+			bool solid = IsSolid(ctx, x, y);
+
+			if (ctx->mask != nullptr) ctx->mask[ix] = solid;
+			if (ctx->pixels == nullptr) continue;
+
+			unsigned char* px = ctx->pixels + ix * 4;
+			if (!solid)
+			{
+				px[0] = px[1] = px[2] = px[3] = 0;
+				continue;
+			}
+
+			//grass on top, dirt, then rock, dithered per pixel
+			int depth = y - ctx->surface[x + p->overhang];
+			int grain = (int)(Hash(p->seed, x, y) & 15) - 8;
+			int r, g, b;
+			if (depth < 4) { r = 70; g = 150; b = 50; }
+			else if (depth < 48) { r = 120; g = 85; b = 50; }
+			else { r = 95; g = 92; b = 90; }
+
+			px[0] = (unsigned char)(r + grain);
+			px[1] = (unsigned char)(g + grain);
+			px[2] = (unsigned char)(b + grain);
+			px[3] = 255;
+		}
+}
+
+static void GenerateWorker(GenContext* ctx)
+{
+	int tiles = ctx->tilesX * ctx->tilesY;
+	for (int t = ctx->nextTile++; t < tiles; t = ctx->nextTile++)
+		GenerateTile(ctx, t % ctx->tilesX, t / ctx->tilesX);
+}
+
+//----------------------------------------------------------------------------------
+// Terrain Gen Functions Definition
+//----------------------------------------------------------------------------------
+TerrainGenParams DefaultTerrainGenParams(unsigned int seed, int width, int height)
+{
+	TerrainGenParams p = { 0 };
+	p.seed = seed;
+	p.width = width;
+	p.height = height;
+	p.threads = 0;
+	p.surfaceMin = height / 4;
+	p.surfaceMax = height * 3 / 4;
+	p.caveDensity = 30;
+	p.overhang = 24;
+	return p;
+}
+
+void GenerateTerrain(const TerrainGenParams* params, unsigned char* pixels, int* mask)
+{
+	GenContext ctx;
+	ctx.params = params;
+	ctx.pixels = pixels;
+	ctx.mask = mask;
+
+	//the surface is 1D, compute it once for every column the warp can reach
+	int ov = params->overhang;
+	int columns = params->width + 2 * ov + 1;
+	ctx.surface = (int*)calloc(columns, sizeof(int));
+	ctx.bandMin = (int*)calloc(params->width, sizeof(int));
+	ctx.bandMax = (int*)calloc(params->width, sizeof(int));
+
+	int range = params->surfaceMax - params->surfaceMin;
+	for (int c = 0; c < columns; c++)
+		ctx.surface[c] = params->surfaceMin + (int)((long long)FractalNoise(params->seed, c - ov, 0, 512, 5) * range >> 16);
+
+	for (int x = 0; x < params->width; x++)
+	{
+		ctx.bandMin[x] = ctx.surface[x];
+		ctx.bandMax[x] = ctx.surface[x];
+		for (int c = x; c <= x + 2 * ov; c++)
+		{
+			if (ctx.surface[c] < ctx.bandMin[x]) ctx.bandMin[x] = ctx.surface[c];
+			if (ctx.surface[c] > ctx.bandMax[x]) ctx.bandMax[x] = ctx.surface[c];
+		}
+	}
+
+	ctx.tilesX = (params->width + TERRAINGEN_TILE_SIZE - 1) / TERRAINGEN_TILE_SIZE;
+	ctx.tilesY = (params->height + TERRAINGEN_TILE_SIZE - 1) / TERRAINGEN_TILE_SIZE;
+	ctx.nextTile = 0;
+
+	int threads = params->threads > 0 ? params->threads : (int)std::thread::hardware_concurrency();
+	if (threads < 1) threads = 1;
+
+	std::vector<std::thread> workers;
+	for (int i = 1; i < threads; i++) workers.emplace_back(GenerateWorker, &ctx);
+	GenerateWorker(&ctx);
+	for (std::thread& w : workers) w.join();
+
+	free(ctx.surface);
+	free(ctx.bandMin);
+	free(ctx.bandMax);
+}
@@ -0,0 +1,37 @@
+/*******************************************************************************************
+*
+*   Terrain Gen - seedable procedural terrain for stress maps
+*
+*   Height field, overhangs (domain-warped surface) and caves from integer value noise, so
+*   the same seed gives the same bytes whatever the thread count or platform. Maps are
+*   built in TERRAINGEN_TILE_SIZE tiles spread over worker threads.
+*
+********************************************************************************************/
+
+#ifndef TERRAIN_GEN_H
+#define TERRAIN_GEN_H
+
+#define TERRAINGEN_TILE_SIZE           256
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct TerrainGenParams {
+	unsigned int seed;
+	int width, height;
+	int threads;                    // 0 uses every hardware thread
+
+	int surfaceMin, surfaceMax;     // Surface height band, rows from the top
+	int caveDensity;                // 0..100, share of the underground opened by caves
+	int overhang;                   // Horizontal warp of the surface in pixels
+} TerrainGenParams;
+
+//----------------------------------------------------------------------------------
+// Terrain Gen Functions Declaration
+//----------------------------------------------------------------------------------
+TerrainGenParams DefaultTerrainGenParams(unsigned int seed, int width, int height);
+
+// Fill pixels (RGBA8, width * height * 4 bytes) and mask (width * height, 1 solid), either may be null
+void GenerateTerrain(const TerrainGenParams* params, unsigned char* pixels, int* mask);
+
+#endif // TERRAIN_GEN_H
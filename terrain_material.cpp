@@ -0,0 +1,157 @@
+/*******************************************************************************************
+*
+*   Terrain Material - packed per-pixel hardness plane alongside the solid mask
+*
+********************************************************************************************/
+
+#include "terrain_material.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+	#include <emmintrin.h>
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Variables Definition (local)
+//----------------------------------------------------------------------------------
+static const int materialHardness[MATERIAL_COUNT] = { 0, 2, 6, MATERIAL_HARDNESS_MAX };
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition (local)
+//----------------------------------------------------------------------------------
+static inline int GetNibble(const unsigned char* row, int x)
+{
+	return (row[x >> 1] >> ((x & 1) * 4)) & 15;
+}
+
+static inline void SetNibble(unsigned char* row, int x, int value)
+{
+	int shift = (x & 1) * 4;
+	row[x >> 1] = (unsigned char)((row[x >> 1] & ~(15 << shift)) | (value << shift));
+}
+
+static inline void DamagePixel(unsigned char* row, int x, int damage)
+{
+	int h = GetNibble(row, x);
+	if (h == MATERIAL_HARDNESS_MAX) return;
+	SetNibble(row, x, h > damage ? h - damage : 0);
+}
+
+//----------------------------------------------------------------------------------
+// Terrain Material Functions Definition
+//----------------------------------------------------------------------------------
+void InitTerrainMaterials(TerrainMaterials* materials, const int* mask, int width, int height, TerrainMaterial fill)
+{
+	materials->width = width;
+	materials->height = height;
+	materials->bytesPerRow = ((width + 31) / 32) * 16;
+	materials->hardness = (unsigned char*)calloc((size_t)materials->bytesPerRow * height, 1);
+	materials->tilesX = (width + TERRAIN_TILE_SIZE - 1) / TERRAIN_TILE_SIZE;
+	materials->tilesY = (height + TERRAIN_TILE_SIZE - 1) / TERRAIN_TILE_SIZE;
+	materials->tileVersions = (unsigned int*)calloc(materials->tilesX * materials->tilesY, sizeof(unsigned int));
+#if defined(__SSE2__)
+	materials->simd = true;
+#else
+	materials->simd = false;
+#endif
+
+	for (int y = 0; y < height; y++)
+	{
+		unsigned char* row = materials->hardness + y * materials->bytesPerRow;
+		for (int x = 0; x < width; x++)
+			if (mask[y * width + x] == 1) SetNibble(row, x, materialHardness[fill]);
+	}
+}
+
+void UnloadTerrainMaterials(TerrainMaterials* materials)
+{
+	free(materials->hardness);
+	free(materials->tileVersions);
+	memset(materials, 0, sizeof(TerrainMaterials));
+}
+
+int GetMaterialHardness(TerrainMaterial material)
+{
+	return materialHardness[material];
+}
+
+void SetTerrainMaterial(TerrainMaterials* materials, int x, int y, TerrainMaterial material)
+{
+	if ((unsigned int)x >= (unsigned int)materials->width || (unsigned int)y >= (unsigned int)materials->height) return;
+	SetNibble(materials->hardness + y * materials->bytesPerRow, x, materialHardness[material]);
+	materials->tileVersions[(y / TERRAIN_TILE_SIZE) * materials->tilesX + x / TERRAIN_TILE_SIZE]++;
+}
+
+int GetTerrainHardness(const TerrainMaterials* materials, int x, int y)
+{
+	if ((unsigned int)x >= (unsigned int)materials->width || (unsigned int)y >= (unsigned int)materials->height) return 0;
+	return GetNibble(materials->hardness + y * materials->bytesPerRow, x);
+}
+
+void LayerTerrainMaterials(TerrainMaterials* materials, const int* mask, int dirtDepth, int bedrockRows)
+{
+	int width = materials->width, height = materials->height;
+	for (int x = 0; x < width; x++)
+	{
+		int surface = 0;
+		while (surface < height && mask[surface * width + x] != 1) surface++;
+
+		for (int y = surface; y < height; y++)
+		{
+			if (mask[y * width + x] != 1) continue;
+
+			TerrainMaterial material = MATERIAL_DIRT;
+			if (y >= height - bedrockRows) material = MATERIAL_BEDROCK;
+			else if (y - surface >= dirtDepth) material = MATERIAL_ROCK;
+			SetNibble(materials->hardness + y * materials->bytesPerRow, x, materialHardness[material]);
+		}
+	}
+}
+
+void DamageTerrainRow(TerrainMaterials* materials, int y, int x0, int x1, int damage)
+{
+	if ((unsigned int)y >= (unsigned int)materials->height || damage <= 0) return;
+	if (x0 < 0) x0 = 0;
+	if (x1 > materials->width) x1 = materials->width;
+	if (damage > MATERIAL_HARDNESS_MAX) damage = MATERIAL_HARDNESS_MAX;
+	if (x0 >= x1) return;
+
+	unsigned int* versions = materials->tileVersions + (y / TERRAIN_TILE_SIZE) * materials->tilesX;
+	for (int t = x0 / TERRAIN_TILE_SIZE; t <= (x1 - 1) / TERRAIN_TILE_SIZE; t++) versions[t]++;
+
+	unsigned char* row = materials->hardness + y * materials->bytesPerRow;
+
+#if defined(__SSE2__)
+	if (materials->simd)
+	{
+		//whole 32-pixel blocks (16 bytes, always inside the padded row), lanes outside [x0, x1) take no damage
+		const __m128i low = _mm_set1_epi8(15);
+		const __m128i hit = _mm_set1_epi8((char)damage);
+		const __m128i evenX = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+		const __m128i oddX = _mm_add_epi8(evenX, _mm_set1_epi8(1));
+
+		for (int base = x0 & ~31; base < x1; base += 32)
+		{
+			__m128i first = _mm_set1_epi8((char)(x0 > base ? x0 - base : 0));
+			__m128i end = _mm_set1_epi8((char)(x1 - base < 32 ? x1 - base : 32));
+			__m128i hitLo = _mm_and_si128(hit, _mm_andnot_si128(_mm_cmpgt_epi8(first, evenX), _mm_cmpgt_epi8(end, evenX)));
+			__m128i hitHi = _mm_and_si128(hit, _mm_andnot_si128(_mm_cmpgt_epi8(first, oddX), _mm_cmpgt_epi8(end, oddX)));
+
+			__m128i v = _mm_loadu_si128((const __m128i*)(row + (base >> 1)));
+			__m128i lo = _mm_and_si128(v, low);
+			__m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), low);
+
+			//indestructible lanes take no damage either
+			lo = _mm_subs_epu8(lo, _mm_andnot_si128(_mm_cmpeq_epi8(lo, low), hitLo));
+			hi = _mm_subs_epu8(hi, _mm_andnot_si128(_mm_cmpeq_epi8(hi, low), hitHi));
+
+			_mm_storeu_si128((__m128i*)(row + (base >> 1)), _mm_or_si128(lo, _mm_slli_epi16(hi, 4)));
+		}
+		return;
+	}
+#endif
+
+	for (int x = x0; x < x1; x++) DamagePixel(row, x, damage);
+}
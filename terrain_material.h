@@ -0,0 +1,57 @@
+/*******************************************************************************************
+*
+*   Terrain Material - packed per-pixel hardness plane alongside the solid mask
+*
+*   Every pixel holds a 4-bit hardness, two pixels per byte, rows padded to 16 bytes. The
+*   material a pixel starts as sets its hardness, a blast subtracts its damage (saturating,
+*   16 bytes / 32 pixels per SSE2 op) and a pixel only leaves the mask once it reaches 0.
+*   Hardness 15 is never damaged. Solid pixels with hardness 0 are loose (settled debris)
+*   and go with any blast.
+*
+********************************************************************************************/
+
+#ifndef TERRAIN_MATERIAL_H
+#define TERRAIN_MATERIAL_H
+
+#include "terrain_events.h"
+
+#define MATERIAL_HARDNESS_MAX            15     // Indestructible
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef enum TerrainMaterial {
+	MATERIAL_NONE = 0,
+	MATERIAL_DIRT,
+	MATERIAL_ROCK,
+	MATERIAL_BEDROCK,
+	MATERIAL_COUNT
+} TerrainMaterial;
+
+typedef struct TerrainMaterials {
+	int width, height;
+	int bytesPerRow;                // Multiple of 16
+	unsigned char* hardness;        // Pixel x in byte x >> 1, low nibble for even x
+
+	int tilesX, tilesY;
+	unsigned int* tileVersions;     // Per TERRAIN_TILE_SIZE tile, bumped by every damage that reaches it
+
+	bool simd;                      // Use the SSE2 kernel where the build has it
+} TerrainMaterials;
+
+//----------------------------------------------------------------------------------
+// Terrain Material Functions Declaration
+//----------------------------------------------------------------------------------
+void InitTerrainMaterials(TerrainMaterials* materials, const int* mask, int width, int height, TerrainMaterial fill);   // Solid pixels get fill
+void UnloadTerrainMaterials(TerrainMaterials* materials);
+
+int GetMaterialHardness(TerrainMaterial material);
+void SetTerrainMaterial(TerrainMaterials* materials, int x, int y, TerrainMaterial material);
+int GetTerrainHardness(const TerrainMaterials* materials, int x, int y);    // 0 off the map
+
+// Dirt down to dirtDepth below each column's surface, rock under it, bedrock in the last bedrockRows
+void LayerTerrainMaterials(TerrainMaterials* materials, const int* mask, int dirtDepth, int bedrockRows);
+
+void DamageTerrainRow(TerrainMaterials* materials, int y, int x0, int x1, int damage);    // [x0, x1), saturates at 0
+
+#endif // TERRAIN_MATERIAL_H
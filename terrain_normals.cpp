@@ -0,0 +1,191 @@
+/*******************************************************************************************
+*
+*   Terrain Normals - batched surface normal and slope queries
+*
+********************************************************************************************/
+
+#include "terrain_normals.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__SSE2__)
+	#include <emmintrin.h>
+#endif
+
+#define TILE            TERRAIN_TILE_SIZE
+#define R               NORMAL_KERNEL_RADIUS
+#define PADDED          (TILE + 2 * R)
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition (local)
+//----------------------------------------------------------------------------------
+
+// The kernel reaches R pixels into the neighbouring tiles, so any of them changing counts
+static unsigned int NeighbourhoodVersion(int tx, int ty)
+{
+	unsigned int version = 0;
+	for (int y = ty - 1; y <= ty + 1; y++)
+		for (int x = tx - 1; x <= tx + 1; x++)
+		{
+			unsigned int v = GetTerrainTileVersion(x, y);
+			if (v > version) version = v;
+		}
+
+	return version;
+}
+
+// dst[i] += src[i] (or -=), the only operation the box kernel needs
+static void AccumulateRow(int* dst, const int* src, int n, bool subtract)
+{
+	int i = 0;
+
+#if defined(__SSE2__)
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+		__m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+		_mm_storeu_si128((__m128i*)(dst + i), subtract ? _mm_sub_epi32(d, s) : _mm_add_epi32(d, s));
+	}
+#endif
+
+	for (; i < n; i++) dst[i] += subtract ? -src[i] : src[i];
+}
+
+// Gradient of the occupancy over a (2R+1)^2 window for every pixel of one tile
+static void ComputeTile(TerrainNormalCache* cache, int tx, int ty)
+{
+	int* occ = cache->scratch;               // PADDED x PADDED
+	int* v = occ + PADDED * PADDED;          // Vertical box sums of one output row
+	int* d = v + PADDED;                     // Vertical differences of one output row
+	int* gx = d + PADDED;
+	int* gy = gx + TILE;
+
+	int x0 = tx * TILE - R, y0 = ty * TILE - R;
+	for (int y = 0; y < PADDED; y++)
+		for (int x = 0; x < PADDED; x++)
+		{
+			int mx = x0 + x, my = y0 + y;
+			bool inside = mx >= 0 && my >= 0 && mx < cache->width && my < cache->height;
+			occ[y * PADDED + x] = inside && cache->mask[my * cache->width + mx] != 0;
+		}
+
+	int tile = ty * cache->tilesX + tx;
+	if (cache->gradient[tile] == nullptr) cache->gradient[tile] = (signed char*)malloc(TILE * TILE * 2);
+	signed char* out = cache->gradient[tile];
+
+	for (int y = 0; y < TILE; y++)
+	{
+		memset(v, 0, PADDED * sizeof(int));
+		memset(d, 0, PADDED * sizeof(int));
+		memset(gx, 0, TILE * sizeof(int));
+		memset(gy, 0, TILE * sizeof(int));
+
+		//rows y..y+2R of the padded tile are the window rows of output row y
+		for (int k = 0; k <= 2 * R; k++) AccumulateRow(v, occ + (y + k) * PADDED, PADDED, false);
+		for (int k = 1; k <= R; k++)
+		{
+			AccumulateRow(d, occ + (y + R + k) * PADDED, PADDED, false);
+			AccumulateRow(d, occ + (y + R - k) * PADDED, PADDED, true);
+		}
+
+		//gx: right half of the window minus the left half, gy: window sum of the vertical differences
+		for (int k = 1; k <= R; k++)
+		{
+			AccumulateRow(gx, v + R + k, TILE, false);
+			AccumulateRow(gx, v + R - k, TILE, true);
+		}
+		for (int k = 0; k <= 2 * R; k++) AccumulateRow(gy, d + k, TILE, false);
+
+		for (int x = 0; x < TILE; x++)
+		{
+			out[(y * TILE + x) * 2] = (signed char)gx[x];
+			out[(y * TILE + x) * 2 + 1] = (signed char)gy[x];
+		}
+	}
+
+	cache->tileValid[tile] = true;
+	cache->tileVersion[tile] = NeighbourhoodVersion(tx, ty);
+}
+
+// (gx, gy) of pixel (x, y), its tile recomputed first if the terrain around it changed; null off the map
+static const signed char* GradientAt(TerrainNormalCache* cache, int x, int y)
+{
+	if (x < 0 || y < 0 || x >= cache->width || y >= cache->height) return nullptr;
+
+	int tx = x / TILE, ty = y / TILE;
+	int tile = ty * cache->tilesX + tx;
+	//nothing changed anywhere since the last check, skip the neighbourhood lookups
+	bool fresh = cache->tileValid[tile] && cache->checkedAt[tile] == GetTerrainVersion();
+	if (!fresh && (!cache->tileValid[tile] || cache->tileVersion[tile] != NeighbourhoodVersion(tx, ty)))
+	{
+		ComputeTile(cache, tx, ty);
+		cache->misses++;
+	}
+	else cache->hits++;
+	cache->checkedAt[tile] = GetTerrainVersion();
+
+	return cache->gradient[tile] + ((y % TILE) * TILE + (x % TILE)) * 2;
+}
+
+//----------------------------------------------------------------------------------
+// Terrain Normals Functions Definition
+//----------------------------------------------------------------------------------
+void InitTerrainNormalCache(TerrainNormalCache* cache, const int* mask, int width, int height)
+{
+	cache->mask = mask;
+	cache->width = width;
+	cache->height = height;
+	cache->tilesX = (width + TILE - 1) / TILE;
+	cache->tilesY = (height + TILE - 1) / TILE;
+
+	int tiles = cache->tilesX * cache->tilesY;
+	cache->gradient = (signed char**)calloc(tiles, sizeof(signed char*));
+	cache->tileVersion = (unsigned int*)calloc(tiles, sizeof(unsigned int));
+	cache->tileValid = (bool*)calloc(tiles, sizeof(bool));
+	cache->checkedAt = (unsigned int*)calloc(tiles, sizeof(unsigned int));
+	cache->scratch = (int*)calloc(PADDED * PADDED + 2 * PADDED + 2 * TILE, sizeof(int));
+
+	cache->hits = 0;
+	cache->misses = 0;
+}
+
+void UnloadTerrainNormalCache(TerrainNormalCache* cache)
+{
+	for (int i = 0; i < cache->tilesX * cache->tilesY; i++) free(cache->gradient[i]);
+	free(cache->gradient);
+	free(cache->tileVersion);
+	free(cache->tileValid);
+	free(cache->checkedAt);
+	free(cache->scratch);
+	memset(cache, 0, sizeof(TerrainNormalCache));
+}
+
+void QueryTerrainNormals(TerrainNormalCache* cache, const float* xs, const float* ys, int count, TerrainNormal* out)
+{
+	for (int i = 0; i < count; i++)
+	{
+		out[i] = { 0, -1, 0 };
+		const signed char* g = GradientAt(cache, (int)floorf(xs[i]), (int)floorf(ys[i]));
+		if (g == nullptr) continue;
+
+		float len = sqrtf((float)(g[0] * g[0] + g[1] * g[1]));
+		if (len == 0) continue;
+
+		//occupancy grows into the ground, the normal points the other way
+		out[i].nx = -g[0] / len;
+		out[i].ny = -g[1] / len;
+		out[i].slope = acosf(-out[i].ny) * 57.29578f;
+	}
+}
+
+void QueryTerrainGradients(TerrainNormalCache* cache, const int* xs, const int* ys, int count, int* gxs, int* gys)
+{
+	for (int i = 0; i < count; i++)
+	{
+		const signed char* g = GradientAt(cache, xs[i], ys[i]);
+		gxs[i] = g != nullptr ? g[0] : 0;
+		gys[i] = g != nullptr ? g[1] : 0;
+	}
+}
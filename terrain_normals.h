@@ -0,0 +1,54 @@
+/*******************************************************************************************
+*
+*   Terrain Normals - batched surface normal and slope queries
+*
+*   Normals come from the gradient of the occupancy mask over a (2R+1) square window,
+*   computed a tile at a time with an SSE2 box kernel (scalar fallback) and cached per
+*   tile until the terrain events bus bumps that tile's version.
+*
+********************************************************************************************/
+
+#ifndef TERRAIN_NORMALS_H
+#define TERRAIN_NORMALS_H
+
+#include "terrain_events.h"
+
+#define NORMAL_KERNEL_RADIUS             3      // Gradient window is 7x7 pixels
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct TerrainNormal {
+	float nx, ny;                   // Unit normal pointing out of the terrain, (0, -1) on flat ground
+	float slope;                    // Degrees from horizontal, 0 flat, 90 wall
+} TerrainNormal;
+
+typedef struct TerrainNormalCache {
+	const int* mask;                // Not owned
+	int width, height;
+	int tilesX, tilesY;
+
+	signed char** gradient;         // Per tile, TERRAIN_TILE_SIZE^2 (gx, gy) pairs, allocated on first use
+	unsigned int* tileVersion;      // Terrain tile version the gradient was computed at
+	bool* tileValid;
+	unsigned int* checkedAt;        // Terrain version when the tile was last found up to date
+
+	int* scratch;                   // Padded occupancy and box-sum rows for one tile
+
+	long hits;                      // Queries served from an up to date tile
+	long misses;                    // Queries that had to recompute their tile
+} TerrainNormalCache;
+
+//----------------------------------------------------------------------------------
+// Terrain Normals Functions Declaration
+//----------------------------------------------------------------------------------
+void InitTerrainNormalCache(TerrainNormalCache* cache, const int* mask, int width, int height);
+void UnloadTerrainNormalCache(TerrainNormalCache* cache);
+
+// Normals and slopes at count points, points off the map read as flat ground
+void QueryTerrainNormals(TerrainNormalCache* cache, const float* xs, const float* ys, int count, TerrainNormal* out);
+
+// Occupancy gradients at count pixels, pointing into the terrain, (0, 0) off the map; integers only, for fixed-point callers
+void QueryTerrainGradients(TerrainNormalCache* cache, const int* xs, const int* ys, int count, int* gxs, int* gys);
+
+#endif // TERRAIN_NORMALS_H
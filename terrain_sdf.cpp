@@ -0,0 +1,220 @@
+/*******************************************************************************************
+*
+*   Terrain SDF - incrementally maintained signed distance field of the terrain mask
+*
+********************************************************************************************/
+
+#include "terrain_sdf.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define SDF_INF                       1e20f
+#define SDF_REGION_SIZE               (SDF_CHUNK_SIZE + 2 * SDF_MAX_DISTANCE)
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition (local)
+//----------------------------------------------------------------------------------
+
+// 1D squared distance transform of sampled function f (Felzenszwalb & Huttenlocher), O(n)
+static void DistanceTransform1D(const float* f, float* d, int n, int* v, float* z)
+{
+	int k = 0;
+	v[0] = 0;
+	z[0] = -SDF_INF;
+	z[1] = SDF_INF;
+
+	for (int q = 1; q < n; q++)
+	{
+		float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+		while (s <= z[k])
+		{
+			k--;
+			s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+		}
+
+		k++;
+		v[k] = q;
+		z[k] = s;
+		z[k + 1] = SDF_INF;
+	}
+
+	k = 0;
+	for (int q = 0; q < n; q++)
+	{
+		while (z[k + 1] < q) k++;
+		d[q] = (float)(q - v[k]) * (q - v[k]) + f[v[k]];
+	}
+}
+
+// 2D squared distance transform in place, columns then rows
+static void DistanceTransform2D(TerrainSdf* sdf, float* grid, int w, int h)
+{
+	float* in = sdf->line;
+	float* out = in + SDF_REGION_SIZE;
+	float* z = out + SDF_REGION_SIZE;
+
+	for (int x = 0; x < w; x++)
+	{
+		for (int y = 0; y < h; y++) in[y] = grid[y * w + x];
+		DistanceTransform1D(in, out, h, sdf->v, z);
+		for (int y = 0; y < h; y++) grid[y * w + x] = out[y];
+	}
+
+	for (int y = 0; y < h; y++)
+	{
+		DistanceTransform1D(grid + y * w, out, w, sdf->v, z);
+		memcpy(grid + y * w, out, w * sizeof(float));
+	}
+}
+
+// Recompute the write rect [x0, x1) x [y0, y1), reading the mask up to SDF_MAX_DISTANCE around it
+static void ComputeChunk(TerrainSdf* sdf, int x0, int y0, int x1, int y1)
+{
+	int cx0 = x0 - SDF_MAX_DISTANCE < 0 ? 0 : x0 - SDF_MAX_DISTANCE;
+	int cy0 = y0 - SDF_MAX_DISTANCE < 0 ? 0 : y0 - SDF_MAX_DISTANCE;
+	int cx1 = x1 + SDF_MAX_DISTANCE > sdf->width ? sdf->width : x1 + SDF_MAX_DISTANCE;
+	int cy1 = y1 + SDF_MAX_DISTANCE > sdf->height ? sdf->height : y1 + SDF_MAX_DISTANCE;
+	int cw = cx1 - cx0, ch = cy1 - cy0;
+
+	for (int y = 0; y < ch; y++)
+		for (int x = 0; x < cw; x++)
+		{
+			bool solid = sdf->mask[(cy0 + y) * sdf->width + cx0 + x] != 0;
+			sdf->outside[y * cw + x] = solid ? 0 : SDF_INF;
+			sdf->inside[y * cw + x] = solid ? SDF_INF : 0;
+		}
+
+	DistanceTransform2D(sdf, sdf->outside, cw, ch);
+	DistanceTransform2D(sdf, sdf->inside, cw, ch);
+
+	const float limit = SDF_MAX_DISTANCE * SDF_STEPS_PER_PIXEL;
+	for (int y = y0; y < y1; y++)
+		for (int x = x0; x < x1; x++)
+		{
+			int ix = (y - cy0) * cw + (x - cx0);
+
+			//distances are between pixel centres, the surface sits half a pixel in
+			float d = sdf->mask[y * sdf->width + x] != 0 ? -(sqrtf(sdf->inside[ix]) - 0.5f) : sqrtf(sdf->outside[ix]) - 0.5f;
+			float q = roundf(d * SDF_STEPS_PER_PIXEL);
+			if (q > limit) q = limit;
+			if (q < -limit) q = -limit;
+
+			sdf->dist[y * sdf->width + x] = (signed char)q;
+		}
+}
+
+static float DistAt(const TerrainSdf* sdf, int x, int y)
+{
+	if (x < 0 || y < 0 || x >= sdf->width || y >= sdf->height) return SDF_MAX_DISTANCE;
+	return (float)sdf->dist[y * sdf->width + x] / SDF_STEPS_PER_PIXEL;
+}
+
+//----------------------------------------------------------------------------------
+// Terrain SDF Functions Definition
+//----------------------------------------------------------------------------------
+void InitTerrainSdf(TerrainSdf* sdf, const int* mask, int width, int height)
+{
+	sdf->mask = mask;
+	sdf->width = width;
+	sdf->height = height;
+	sdf->dist = (signed char*)calloc(width * height, sizeof(signed char));
+
+	sdf->outside = (float*)calloc(SDF_REGION_SIZE * SDF_REGION_SIZE, sizeof(float));
+	sdf->inside = (float*)calloc(SDF_REGION_SIZE * SDF_REGION_SIZE, sizeof(float));
+	sdf->line = (float*)calloc(3 * SDF_REGION_SIZE + 1, sizeof(float));
+	sdf->v = (int*)calloc(SDF_REGION_SIZE, sizeof(int));
+
+	for (int y = 0; y < height; y += SDF_CHUNK_SIZE)
+		for (int x = 0; x < width; x += SDF_CHUNK_SIZE)
+			ComputeChunk(sdf, x, y, x + SDF_CHUNK_SIZE > width ? width : x + SDF_CHUNK_SIZE, y + SDF_CHUNK_SIZE > height ? height : y + SDF_CHUNK_SIZE);
+}
+
+void UnloadTerrainSdf(TerrainSdf* sdf)
+{
+	free(sdf->dist);
+	free(sdf->outside);
+	free(sdf->inside);
+	free(sdf->line);
+	free(sdf->v);
+	memset(sdf, 0, sizeof(TerrainSdf));
+}
+
+void UpdateTerrainSdf(TerrainSdf* sdf, TerrainRect rect)
+{
+	//a change moves distances up to the clamp away from it
+	int x0 = rect.x - SDF_MAX_DISTANCE < 0 ? 0 : rect.x - SDF_MAX_DISTANCE;
+	int y0 = rect.y - SDF_MAX_DISTANCE < 0 ? 0 : rect.y - SDF_MAX_DISTANCE;
+	int x1 = rect.x + rect.width + SDF_MAX_DISTANCE > sdf->width ? sdf->width : rect.x + rect.width + SDF_MAX_DISTANCE;
+	int y1 = rect.y + rect.height + SDF_MAX_DISTANCE > sdf->height ? sdf->height : rect.y + rect.height + SDF_MAX_DISTANCE;
+
+	for (int y = y0; y < y1; y += SDF_CHUNK_SIZE)
+		for (int x = x0; x < x1; x += SDF_CHUNK_SIZE)
+			ComputeChunk(sdf, x, y, x + SDF_CHUNK_SIZE > x1 ? x1 : x + SDF_CHUNK_SIZE, y + SDF_CHUNK_SIZE > y1 ? y1 : y + SDF_CHUNK_SIZE);
+}
+
+void OnTerrainChangedSdf(const TerrainRect* rects, int count, unsigned int version, void* sdf)
+{
+	for (int i = 0; i < count; i++) UpdateTerrainSdf((TerrainSdf*)sdf, rects[i]);
+}
+
+float SampleTerrainSdf(const TerrainSdf* sdf, float x, float y)
+{
+	//sample between pixel centres
+	x -= 0.5f;
+	y -= 0.5f;
+	int ix = (int)floorf(x), iy = (int)floorf(y);
+	float fx = x - ix, fy = y - iy;
+
+	float top = DistAt(sdf, ix, iy) * (1 - fx) + DistAt(sdf, ix + 1, iy) * fx;
+	float bottom = DistAt(sdf, ix, iy + 1) * (1 - fx) + DistAt(sdf, ix + 1, iy + 1) * fx;
+	return top * (1 - fy) + bottom * fy;
+}
+
+void GetTerrainSdfNormal(const TerrainSdf* sdf, float x, float y, float* nx, float* ny)
+{
+	float gx = SampleTerrainSdf(sdf, x + 1, y) - SampleTerrainSdf(sdf, x - 1, y);
+	float gy = SampleTerrainSdf(sdf, x, y + 1) - SampleTerrainSdf(sdf, x, y - 1);
+	float len = sqrtf(gx * gx + gy * gy);
+
+	if (len < 1e-6f)
+	{
+		*nx = 0;
+		*ny = -1;
+		return;
+	}
+
+	*nx = gx / len;
+	*ny = gy / len;
+}
+
+bool SphereTraceTerrainSdf(const TerrainSdf* sdf, float x0, float y0, float x1, float y1, float radius, float* hitX, float* hitY)
+{
+	float dx = x1 - x0, dy = y1 - y0;
+	float len = sqrtf(dx * dx + dy * dy);
+	if (len > 0)
+	{
+		dx /= len;
+		dy /= len;
+	}
+
+	float t = 0;
+	while (true)
+	{
+		float x = x0 + dx * t, y = y0 + dy * t;
+		float d = SampleTerrainSdf(sdf, x, y) - radius;
+		if (d <= 0.25f)
+		{
+			*hitX = x;
+			*hitY = y;
+			return true;
+		}
+
+		if (t >= len) return false;
+
+		//the field guarantees nothing is closer than d, half a pixel minimum to keep moving
+		t += d > 0.5f ? d : 0.5f;
+		if (t > len) t = len;
+	}
+}
@@ -0,0 +1,50 @@
+/*******************************************************************************************
+*
+*   Terrain SDF - incrementally maintained signed distance field of the terrain mask
+*
+*   Distances are in pixels, positive in open space and negative inside solid terrain,
+*   quantised to signed 8-bit at SDF_STEPS_PER_PIXEL and clamped at SDF_MAX_DISTANCE.
+*   After a carve only a band of SDF_MAX_DISTANCE around the dirty rect is recomputed,
+*   with a linear-time (Felzenszwalb-Huttenlocher) distance transform over that region.
+*
+********************************************************************************************/
+
+#ifndef TERRAIN_SDF_H
+#define TERRAIN_SDF_H
+
+#include "terrain_events.h"
+
+#define SDF_STEPS_PER_PIXEL              4      // Quantisation, 1/4 pixel resolution
+#define SDF_MAX_DISTANCE                31      // Clamp in pixels, 31 * 4 fits in a signed char
+#define SDF_CHUNK_SIZE                 256      // Large updates are split into chunks this size
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct TerrainSdf {
+	const int* mask;                // Not owned
+	int width, height;
+	signed char* dist;              // width * height quantised distances
+
+	float* outside;                 // Scratch for the distance transform, sized for one region
+	float* inside;
+	float* line;                    // Per row/column input, output and parabola bounds
+	int* v;                         // Parabola vertices
+} TerrainSdf;
+
+//----------------------------------------------------------------------------------
+// Terrain SDF Functions Declaration
+//----------------------------------------------------------------------------------
+void InitTerrainSdf(TerrainSdf* sdf, const int* mask, int width, int height);
+void UnloadTerrainSdf(TerrainSdf* sdf);
+
+void UpdateTerrainSdf(TerrainSdf* sdf, TerrainRect rect);   // Recompute the band around a dirty rect
+void OnTerrainChangedSdf(const TerrainRect* rects, int count, unsigned int version, void* sdf);   // Terrain events subscriber
+
+float SampleTerrainSdf(const TerrainSdf* sdf, float x, float y);                     // Bilinear, in pixels
+void GetTerrainSdfNormal(const TerrainSdf* sdf, float x, float y, float* nx, float* ny);   // Points out of the terrain
+
+// Sphere-trace a circle of radius along (x0, y0) -> (x1, y1), true and the contact centre on a hit
+bool SphereTraceTerrainSdf(const TerrainSdf* sdf, float x0, float y0, float x1, float y1, float radius, float* hitX, float* hitY);
+
+#endif // TERRAIN_SDF_H
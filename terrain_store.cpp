@@ -0,0 +1,150 @@
+/*******************************************************************************************
+*
+*   Terrain Store - one query and carve interface over the dense mask or run-length columns
+*
+********************************************************************************************/
+
+#include "terrain_store.h"
+
+#include <math.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition (local)
+//----------------------------------------------------------------------------------
+
+// Dense writes go to the mask and its packed bits together
+static void WriteDenseSpan(TerrainStore* store, int x, int y0, int y1, int value)
+{
+	if ((unsigned int)x >= (unsigned int)store->width) return;
+	if (y0 < 0) y0 = 0;
+	if (y1 > store->height) y1 = store->height;
+
+	TerrainBits* bits = &store->bits;
+	unsigned int bit = 1u << (x & 31);
+	for (int y = y0; y < y1; y++)
+	{
+		store->mask[y * store->width + x] = value;
+		unsigned int* word = &bits->words[y * bits->wordsPerRow + (x >> 5)];
+		*word = value ? *word | bit : *word & ~bit;
+	}
+}
+
+//----------------------------------------------------------------------------------
+// Terrain Store Functions Definition
+//----------------------------------------------------------------------------------
+void InitTerrainStore(TerrainStore* store, TerrainBackend backend, int* mask, int width, int height)
+{
+	store->backend = backend;
+	store->width = width;
+	store->height = height;
+	store->mask = mask;
+
+	if (backend == TERRAIN_BACKEND_COLUMNS) InitTerrainColumns(&store->columns, mask, width, height);
+	else InitTerrainBits(&store->bits, mask, width, height);
+}
+
+void UnloadTerrainStore(TerrainStore* store)
+{
+	if (store->backend == TERRAIN_BACKEND_COLUMNS) UnloadTerrainColumns(&store->columns);
+	else UnloadTerrainBits(&store->bits);
+}
+
+void OnTerrainChangedStore(const TerrainRect* rects, int count, unsigned int version, void* store)
+{
+	TerrainStore* s = (TerrainStore*)store;
+	if (s->mask == nullptr) return;
+
+	//the mask was written behind the store's back, bring the bits or columns up to it
+	for (int i = 0; i < count; i++)
+	{
+		if (s->backend == TERRAIN_BACKEND_COLUMNS) EncodeTerrainColumnRows(&s->columns, s->mask, rects[i]);
+		else UpdateTerrainBits(&s->bits, rects[i]);
+	}
+}
+
+bool IsTerrainSolid(const TerrainStore* store, int x, int y)
+{
+	switch (store->backend)
+	{
+	case TERRAIN_BACKEND_COLUMNS: return IsTerrainColumnSolid(&store->columns, x, y);
+	default: return IsTerrainBitSolid(&store->bits, x, y);
+	}
+}
+
+void QueryTerrainStorePoints(const TerrainStore* store, const int* xs, const int* ys, int count, unsigned long long* solid)
+{
+	switch (store->backend)
+	{
+	case TERRAIN_BACKEND_COLUMNS:
+		memset(solid, 0, ((count + 63) / 64) * sizeof(unsigned long long));
+		for (int i = 0; i < count; i++)
+			if (IsTerrainColumnSolid(&store->columns, xs[i], ys[i])) solid[i >> 6] |= 1ull << (i & 63);
+		break;
+	default: QueryTerrainPoints(&store->bits, xs, ys, count, solid); break;
+	}
+}
+
+int FindTerrainBelow(const TerrainStore* store, int x, int y, int maxDistance)
+{
+	switch (store->backend)
+	{
+	case TERRAIN_BACKEND_COLUMNS: return FindTerrainColumnBelow(&store->columns, x, y, maxDistance);
+	default:
+	{
+		if ((unsigned int)x >= (unsigned int)store->width) return -1;
+
+		int from = y < 0 ? 0 : y;
+		int to = y + maxDistance < store->height - 1 ? y + maxDistance : store->height - 1;
+		for (int row = from; row <= to; row++)
+			if (store->mask[row * store->width + x]) return row - y;
+		return -1;
+	}
+	}
+}
+
+void CarveTerrainSpan(TerrainStore* store, int x, int y0, int y1)
+{
+	switch (store->backend)
+	{
+	case TERRAIN_BACKEND_COLUMNS: CarveTerrainColumn(&store->columns, x, y0, y1); break;
+	default: WriteDenseSpan(store, x, y0, y1, 0); break;
+	}
+}
+
+void FillTerrainSpan(TerrainStore* store, int x, int y0, int y1)
+{
+	switch (store->backend)
+	{
+	case TERRAIN_BACKEND_COLUMNS: FillTerrainColumn(&store->columns, x, y0, y1); break;
+	default: WriteDenseSpan(store, x, y0, y1, 1); break;
+	}
+}
+
+TerrainRect CarveTerrainCircle(TerrainStore* store, int cx, int cy, int radius)
+{
+	int x0 = cx - radius < 0 ? 0 : cx - radius;
+	int x1 = cx + radius + 1 > store->width ? store->width : cx + radius + 1;
+	int y0 = cy - radius < 0 ? 0 : cy - radius;
+	int y1 = cy + radius + 1 > store->height ? store->height : cy + radius + 1;
+	if (x0 >= x1 || y0 >= y1) return { 0, 0, 0, 0 };
+
+	//one vertical chord per column, which is all the columns backend can take in one step
+	for (int x = x0; x < x1; x++)
+	{
+		int dx = x - cx;
+		int half = (int)sqrtf((float)(radius * radius - dx * dx));
+		CarveTerrainSpan(store, x, cy - half, cy + half + 1);
+	}
+
+	return { x0, y0, x1 - x0, y1 - y0 };
+}
+
+long GetTerrainStoreBytes(const TerrainStore* store)
+{
+	switch (store->backend)
+	{
+	case TERRAIN_BACKEND_COLUMNS: return GetTerrainColumnsBytes(&store->columns);
+	default: return (long)store->width * store->height * sizeof(int) + (long)store->bits.wordsPerRow * store->height * sizeof(unsigned int);
+	}
+}
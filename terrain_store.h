@@ -0,0 +1,62 @@
+/*******************************************************************************************
+*
+*   Terrain Store - one query and carve interface over the dense mask or run-length columns
+*
+*   The dense backend borrows a width * height int mask and writes it in place, points are
+*   read from a TerrainBits packing of it kept in step by every write. The columns backend
+*   encodes the mask into TerrainColumns once and answers from them, which costs memory in
+*   proportion to the spans instead of the pixels, so open maps shrink to a few bytes per
+*   column. The backend is picked per map; callers only see points, batches of points,
+*   column spans and circles.
+*
+*   A columns store built from a mask that keeps changing elsewhere follows it through
+*   the terrain events subscriber, which splices only the changed rect's rows back into
+*   its columns.
+*
+********************************************************************************************/
+
+#ifndef TERRAIN_STORE_H
+#define TERRAIN_STORE_H
+
+#include "terrain_events.h"
+#include "terrain_columns.h"
+#include "terrain_bits.h"
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef enum TerrainBackend {
+	TERRAIN_BACKEND_DENSE = 0,
+	TERRAIN_BACKEND_COLUMNS
+} TerrainBackend;
+
+typedef struct TerrainStore {
+	TerrainBackend backend;
+	int width, height;
+
+	int* mask;                      // Dense: the terrain, columns: the mask it was encoded from, not owned
+	TerrainBits bits;               // Dense only
+	TerrainColumns columns;         // Columns only
+} TerrainStore;
+
+//----------------------------------------------------------------------------------
+// Terrain Store Functions Declaration
+//----------------------------------------------------------------------------------
+void InitTerrainStore(TerrainStore* store, TerrainBackend backend, int* mask, int width, int height);
+void UnloadTerrainStore(TerrainStore* store);
+
+void OnTerrainChangedStore(const TerrainRect* rects, int count, unsigned int version, void* store);   // Terrain events subscriber
+
+bool IsTerrainSolid(const TerrainStore* store, int x, int y);                      // False off the map
+
+// Bit i of solid (count bits, 64 per word) set when point (xs[i], ys[i]) is solid
+void QueryTerrainStorePoints(const TerrainStore* store, const int* xs, const int* ys, int count, unsigned long long* solid);
+int FindTerrainBelow(const TerrainStore* store, int x, int y, int maxDistance);   // Rows down to the first solid pixel, -1 if none within maxDistance
+
+void CarveTerrainSpan(TerrainStore* store, int x, int y0, int y1);     // Clear [y0, y1) of column x
+void FillTerrainSpan(TerrainStore* store, int x, int y0, int y1);      // Set [y0, y1) of column x
+TerrainRect CarveTerrainCircle(TerrainStore* store, int cx, int cy, int radius);    // Returns the bounds it cleared, clipped to the map
+
+long GetTerrainStoreBytes(const TerrainStore* store);      // Terrain memory of the backend
+
+#endif // TERRAIN_STORE_H
@@ -0,0 +1,98 @@
+/*******************************************************************************************
+*
+*   Terrain Tiles - tiled terrain textures with dirty uploads and camera culling
+*
+********************************************************************************************/
+
+#include "terrain_tiles.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+//----------------------------------------------------------------------------------
+// Terrain Tiles Functions Definition
+//----------------------------------------------------------------------------------
+void InitTerrainTiles(TerrainTiles* tiles, int width, int height, TerrainTileCallbacks callbacks)
+{
+	tiles->width = width;
+	tiles->height = height;
+	tiles->tilesX = (width + TERRAIN_TEXTURE_TILE_SIZE - 1) / TERRAIN_TEXTURE_TILE_SIZE;
+	tiles->tilesY = (height + TERRAIN_TEXTURE_TILE_SIZE - 1) / TERRAIN_TEXTURE_TILE_SIZE;
+	tiles->callbacks = callbacks;
+	memset(&tiles->stats, 0, sizeof(TerrainTileStats));
+
+	int count = tiles->tilesX * tiles->tilesY;
+	tiles->dirty = (bool*)malloc(count * sizeof(bool));
+	for (int i = 0; i < count; i++) tiles->dirty[i] = true;
+}
+
+void UnloadTerrainTiles(TerrainTiles* tiles)
+{
+	free(tiles->dirty);
+	memset(tiles, 0, sizeof(TerrainTiles));
+}
+
+void OnTerrainChangedTiles(const TerrainRect* rects, int count, unsigned int version, void* data)
+{
+	TerrainTiles* tiles = (TerrainTiles*)data;
+
+	for (int i = 0; i < count; i++)
+	{
+		TerrainRect r = rects[i];
+		int tx1 = (r.x + r.width - 1) / TERRAIN_TEXTURE_TILE_SIZE;
+		int ty1 = (r.y + r.height - 1) / TERRAIN_TEXTURE_TILE_SIZE;
+		for (int ty = r.y / TERRAIN_TEXTURE_TILE_SIZE; ty <= ty1; ty++)
+			for (int tx = r.x / TERRAIN_TEXTURE_TILE_SIZE; tx <= tx1; tx++)
+				tiles->dirty[ty * tiles->tilesX + tx] = true;
+	}
+}
+
+void DrawTerrainTiles(TerrainTiles* tiles, float viewX, float viewY, float viewWidth, float viewHeight)
+{
+	TerrainTileStats* stats = &tiles->stats;
+	stats->tilesVisible = 0;
+	stats->drawCalls = 0;
+	stats->uploads = 0;
+	stats->uploadBytes = 0;
+
+	int tx0 = (int)floorf(viewX / TERRAIN_TEXTURE_TILE_SIZE);
+	int ty0 = (int)floorf(viewY / TERRAIN_TEXTURE_TILE_SIZE);
+	int tx1 = (int)ceilf((viewX + viewWidth) / TERRAIN_TEXTURE_TILE_SIZE) - 1;
+	int ty1 = (int)ceilf((viewY + viewHeight) / TERRAIN_TEXTURE_TILE_SIZE) - 1;
+	if (tx0 < 0) tx0 = 0;
+	if (ty0 < 0) ty0 = 0;
+	if (tx1 >= tiles->tilesX) tx1 = tiles->tilesX - 1;
+	if (ty1 >= tiles->tilesY) ty1 = tiles->tilesY - 1;
+
+	for (int ty = ty0; ty <= ty1; ty++)
+		for (int tx = tx0; tx <= tx1; tx++)
+		{
+			int tile = ty * tiles->tilesX + tx;
+			TerrainRect rect = GetTerrainTileRect(tiles, tile);
+
+			if (tiles->dirty[tile])
+			{
+				tiles->callbacks.upload(tile, rect, tiles->callbacks.userData);
+				tiles->dirty[tile] = false;
+				stats->uploads++;
+				stats->uploadBytes += (long)rect.width * rect.height * 4;
+			}
+
+			tiles->callbacks.draw(tile, rect, tiles->callbacks.userData);
+			stats->tilesVisible++;
+			stats->drawCalls++;
+		}
+
+	stats->totalDrawCalls += stats->drawCalls;
+	stats->totalUploadBytes += stats->uploadBytes;
+}
+
+TerrainRect GetTerrainTileRect(const TerrainTiles* tiles, int tile)
+{
+	int x = tile % tiles->tilesX * TERRAIN_TEXTURE_TILE_SIZE;
+	int y = tile / tiles->tilesX * TERRAIN_TEXTURE_TILE_SIZE;
+	int w = x + TERRAIN_TEXTURE_TILE_SIZE > tiles->width ? tiles->width - x : TERRAIN_TEXTURE_TILE_SIZE;
+	int h = y + TERRAIN_TEXTURE_TILE_SIZE > tiles->height ? tiles->height - y : TERRAIN_TEXTURE_TILE_SIZE;
+	return { x, y, w, h };
+}
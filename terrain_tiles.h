@@ -0,0 +1,62 @@
+/*******************************************************************************************
+*
+*   Terrain Tiles - tiled terrain textures with dirty uploads and camera culling
+*
+*   The terrain image is split into TERRAIN_TEXTURE_TILE_SIZE textures so map size is no
+*   longer capped by the GPU texture limit. Changed tiles are only flagged, and uploaded
+*   the next time they are drawn; tiles outside the view are neither uploaded nor drawn.
+*
+*   GPU work goes through callbacks so the tiling and culling can run headless, the
+*   counters report what a frame would have cost.
+*
+********************************************************************************************/
+
+#ifndef TERRAIN_TILES_H
+#define TERRAIN_TILES_H
+
+#include "terrain_events.h"
+
+#define TERRAIN_TEXTURE_TILE_SIZE      256
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct TerrainTileCallbacks {
+	void (*upload)(int tile, TerrainRect rect, void* userData);     // Create or refresh the texture of a tile
+	void (*draw)(int tile, TerrainRect rect, void* userData);
+	void* userData;
+} TerrainTileCallbacks;
+
+typedef struct TerrainTileStats {
+	int tilesVisible;               // Last frame
+	int drawCalls;
+	int uploads;
+	long uploadBytes;
+
+	long totalDrawCalls;            // Since init
+	long totalUploadBytes;
+} TerrainTileStats;
+
+typedef struct TerrainTiles {
+	int width, height;
+	int tilesX, tilesY;
+	bool* dirty;                    // Needs upload before its next draw
+
+	TerrainTileCallbacks callbacks;
+	TerrainTileStats stats;
+} TerrainTiles;
+
+//----------------------------------------------------------------------------------
+// Terrain Tiles Functions Declaration
+//----------------------------------------------------------------------------------
+void InitTerrainTiles(TerrainTiles* tiles, int width, int height, TerrainTileCallbacks callbacks);   // Every tile starts dirty
+void UnloadTerrainTiles(TerrainTiles* tiles);
+
+void OnTerrainChangedTiles(const TerrainRect* rects, int count, unsigned int version, void* tiles);  // Terrain events subscriber
+
+// Upload the dirty tiles intersecting the view and draw every tile intersecting it
+void DrawTerrainTiles(TerrainTiles* tiles, float viewX, float viewY, float viewWidth, float viewHeight);
+
+TerrainRect GetTerrainTileRect(const TerrainTiles* tiles, int tile);
+
+#endif // TERRAIN_TILES_H
@@ -0,0 +1,162 @@
+/*******************************************************************************************
+*
+*   Thread Pool - persistent worker threads for background and data-parallel work
+*
+********************************************************************************************/
+
+#include "thread_pool.h"
+
+#if !defined(PLATFORM_WEB)
+	#include <thread>
+	#include <mutex>
+	#include <condition_variable>
+#endif
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct PoolTask {
+	PoolTaskFunc func;
+	void* userData;
+	PoolTaskGroup* group;
+} PoolTask;
+
+//----------------------------------------------------------------------------------
+// Module Variables Definition (local)
+//----------------------------------------------------------------------------------
+static int workerCount = 0;
+
+#if !defined(PLATFORM_WEB)
+static std::thread workers[THREAD_POOL_MAX_WORKERS];
+static std::mutex queueLock;
+static std::condition_variable queueWake;       // Work queued or shutting down
+static std::condition_variable queueRoom;       // A slot freed in a full queue
+static std::condition_variable groupDone;       // Some group's last task finished, or new work for waiters
+static PoolTask queue[THREAD_POOL_QUEUE_SIZE];
+static unsigned int head = 0, tail = 0;         // Pop at tail, push at head
+static bool quitting = false;
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition (local)
+//----------------------------------------------------------------------------------
+static void RunTask(const PoolTask* task)
+{
+	task->func(task->userData);
+	if (task->group == nullptr || task->group->pending.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+
+#if !defined(PLATFORM_WEB)
+	//taking the lock orders this with a waiter that just found the count non-zero
+	{
+		std::lock_guard<std::mutex> lock(queueLock);
+	}
+	groupDone.notify_all();
+#endif
+}
+
+#if !defined(PLATFORM_WEB)
+// Pop one task under the lock, false if the queue is empty
+static bool PopTask(PoolTask* task)
+{
+	if (head == tail) return false;
+
+	*task = queue[tail++ & (THREAD_POOL_QUEUE_SIZE - 1)];
+	queueRoom.notify_one();
+	return true;
+}
+
+static void WorkerLoop()
+{
+	for (;;)
+	{
+		PoolTask task;
+		{
+			std::unique_lock<std::mutex> lock(queueLock);
+			queueWake.wait(lock, [] { return head != tail || quitting; });
+			if (!PopTask(&task)) return;      // Quitting with nothing left
+		}
+		RunTask(&task);
+	}
+}
+#endif
+
+//----------------------------------------------------------------------------------
+// Thread Pool Functions Definition
+//----------------------------------------------------------------------------------
+void InitThreadPool(int count)
+{
+#if !defined(PLATFORM_WEB)
+	if (workerCount > 0) return;
+
+	if (count < 0) count = (int)std::thread::hardware_concurrency() - 1;
+	if (count > THREAD_POOL_MAX_WORKERS) count = THREAD_POOL_MAX_WORKERS;
+	if (count < 0) count = 0;
+
+	quitting = false;
+	for (int i = 0; i < count; i++) workers[i] = std::thread(WorkerLoop);
+	workerCount = count;
+#else
+	(void)count;
+#endif
+}
+
+void ShutdownThreadPool()
+{
+#if !defined(PLATFORM_WEB)
+	{
+		std::lock_guard<std::mutex> lock(queueLock);
+		quitting = true;
+	}
+	queueWake.notify_all();
+	for (int i = 0; i < workerCount; i++) workers[i].join();
+	workerCount = 0;
+#endif
+}
+
+int GetThreadPoolWorkers()
+{
+	return workerCount;
+}
+
+void SubmitPoolTask(PoolTaskFunc func, void* userData, PoolTaskGroup* group)
+{
+	PoolTask task = { func, userData, group };
+	if (group != nullptr) group->pending.fetch_add(1, std::memory_order_relaxed);
+
+	if (workerCount == 0)
+	{
+		RunTask(&task);
+		return;
+	}
+
+#if !defined(PLATFORM_WEB)
+	{
+		std::unique_lock<std::mutex> lock(queueLock);
+		queueRoom.wait(lock, [] { return head - tail < THREAD_POOL_QUEUE_SIZE; });
+		queue[head++ & (THREAD_POOL_QUEUE_SIZE - 1)] = task;
+	}
+	queueWake.notify_one();
+	groupDone.notify_all();     // Waiters help with new work too, nested passes can't starve
+#endif
+}
+
+void WaitPoolTasks(PoolTaskGroup* group)
+{
+#if !defined(PLATFORM_WEB)
+	while (group->pending.load(std::memory_order_acquire) > 0)
+	{
+		//run someone's queued task rather than idle, the group's own are usually among them
+		PoolTask task;
+		bool popped;
+		{
+			std::unique_lock<std::mutex> lock(queueLock);
+			groupDone.wait(lock, [group] { return head != tail || group->pending.load(std::memory_order_acquire) == 0; });
+			popped = PopTask(&task);
+		}
+
+		if (popped) RunTask(&task);
+	}
+#else
+	(void)group;
+#endif
+}
@@ -0,0 +1,39 @@
+/*******************************************************************************************
+*
+*   Thread Pool - persistent worker threads for background and data-parallel work
+*
+*   One shared pool started once, tasks are a function and a pointer. A task group counts
+*   its outstanding tasks so the submitter can wait for them, and a waiting thread runs
+*   queued tasks itself instead of sleeping. With no workers (web, or 0 threads) tasks
+*   run inline when submitted.
+*
+********************************************************************************************/
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+
+#define THREAD_POOL_MAX_WORKERS          32
+#define THREAD_POOL_QUEUE_SIZE         1024     // Power of two
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef void (*PoolTaskFunc)(void* userData);
+
+typedef struct PoolTaskGroup {
+	std::atomic<int> pending;       // Submitted and not finished yet
+} PoolTaskGroup;
+
+//----------------------------------------------------------------------------------
+// Thread Pool Functions Declaration
+//----------------------------------------------------------------------------------
+void InitThreadPool(int workers);           // 0 runs everything inline, -1 uses every hardware thread but one
+void ShutdownThreadPool();                  // Finishes queued tasks, then joins the workers
+int GetThreadPoolWorkers();
+
+void SubmitPoolTask(PoolTaskFunc func, void* userData, PoolTaskGroup* group);   // group may be null
+void WaitPoolTasks(PoolTaskGroup* group);   // Helps run queued tasks until the group is done
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,162 @@
+/*******************************************************************************************
+*
+*   Trajectory Cache - first-contact results of simulated shots, keyed by launch state
+*
+********************************************************************************************/
+
+#include "trajectory_cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition (local)
+//----------------------------------------------------------------------------------
+static unsigned int HashShot(const TrajectoryShot* shot)
+{
+	const unsigned int* words = (const unsigned int*)shot;
+	unsigned int h = 2166136261u;
+	for (int i = 0; i < (int)(sizeof(TrajectoryShot) / 4); i++) h = (h ^ words[i]) * 16777619u;
+	return h ^ (h >> 15);
+}
+
+static bool SameShot(const TrajectoryShot* a, const TrajectoryShot* b)
+{
+	return a->x == b->x && a->y == b->y && a->vx == b->vx && a->vy == b->vy && a->gravity == b->gravity;
+}
+
+// Remember the tiles under a step's bounding box, tileCount goes to -1 once the path is too long to cache
+static void RecordTiles(TrajectoryEntry* entry, const OccupancyPyramid* terrain, float x0, float y0, float x1, float y1)
+{
+	if (entry->tileCount < 0) return;
+
+	int tilesX = GetTerrainTilesX();
+	int tilesY = GetTerrainTilesY();
+	int tx0 = (int)(x0 < x1 ? x0 : x1) / TERRAIN_TILE_SIZE, tx1 = (int)(x0 < x1 ? x1 : x0) / TERRAIN_TILE_SIZE;
+	int ty0 = (int)(y0 < y1 ? y0 : y1) / TERRAIN_TILE_SIZE, ty1 = (int)(y0 < y1 ? y1 : y0) / TERRAIN_TILE_SIZE;
+	if (x0 < 0 || x1 < 0) tx0 = 0;
+	if (y0 < 0 || y1 < 0) ty0 = 0;
+	if (tx1 >= tilesX) tx1 = tilesX - 1;
+	if (ty1 >= tilesY) ty1 = tilesY - 1;
+
+	for (int ty = ty0; ty <= ty1; ty++)
+		for (int tx = tx0; tx <= tx1; tx++)
+		{
+			int tile = ty * tilesX + tx;
+
+			//steps are short, a repeat is almost always one of the last few tiles
+			bool seen = false;
+			for (int i = entry->tileCount - 1; i >= 0 && i >= entry->tileCount - 4; i--)
+				if (entry->tiles[i] == tile) seen = true;
+			for (int i = 0; i < entry->tileCount - 4 && !seen; i++)
+				if (entry->tiles[i] == tile) seen = true;
+			if (seen) continue;
+
+			if (entry->tileCount == TRAJECTORY_MAX_TILES)
+			{
+				entry->tileCount = -1;
+				return;
+			}
+			entry->tiles[entry->tileCount] = tile;
+			entry->versions[entry->tileCount] = GetTerrainTileVersion(tx, ty);
+			entry->tileCount++;
+		}
+}
+
+// Same integration as the game's fixed-point shells, the probe point raycast against the terrain each step
+static TrajectoryResult SimulateTrajectory(const OccupancyPyramid* terrain, const TrajectoryShot* shot, TrajectoryEntry* entry)
+{
+	fixed x = shot->x, y = shot->y, vx = shot->vx, vy = shot->vy;
+	FixedBodies body = { &x, &y, &vx, &vy, 1 };
+	TrajectoryResult result = { false, 0, 0, 0 };
+	entry->tileCount = 0;
+
+	for (int step = 1; step <= TRAJECTORY_MAX_STEPS; step++)
+	{
+		float fromX = FixedToFloat(x), fromY = FixedToFloat(y);
+		StepFixedBodies(&body, shot->gravity);
+		float toX = FixedToFloat(x), toY = FixedToFloat(y);
+		result.steps = step;
+
+		if (toY >= 0 || fromY >= 0) RecordTiles(entry, terrain, fromX, fromY, toX, toY);
+		if (RaycastOccupancy((OccupancyPyramid*)terrain, fromX, fromY, toX, toY, &result.x, &result.y))
+		{
+			result.hit = true;
+			break;
+		}
+
+		//gone off the sides or through the bottom, nothing left to hit
+		if (toX < 0 || toX >= terrain->width || toY >= terrain->height) break;
+	}
+
+	return result;
+}
+
+static bool TilesUnchanged(const TrajectoryEntry* entry)
+{
+	int tilesX = GetTerrainTilesX();
+	for (int i = 0; i < entry->tileCount; i++)
+		if (GetTerrainTileVersion(entry->tiles[i] % tilesX, entry->tiles[i] / tilesX) != entry->versions[i]) return false;
+
+	return true;
+}
+
+//----------------------------------------------------------------------------------
+// Trajectory Cache Functions Definition
+//----------------------------------------------------------------------------------
+void InitTrajectoryCache(TrajectoryCache* cache, OccupancyPyramid* terrain, int capacity)
+{
+	int size = TRAJECTORY_WAYS;
+	while (size < capacity) size *= 2;
+
+	cache->terrain = terrain;
+	cache->entries = (TrajectoryEntry*)calloc(size, sizeof(TrajectoryEntry));
+	cache->capacity = size;
+	cache->clock = 0;
+	cache->hits = cache->misses = cache->stale = 0;
+}
+
+void UnloadTrajectoryCache(TrajectoryCache* cache)
+{
+	free(cache->entries);
+	memset(cache, 0, sizeof(TrajectoryCache));
+}
+
+TrajectoryResult QueryTrajectory(TrajectoryCache* cache, const TrajectoryShot* shot)
+{
+	cache->clock++;
+	unsigned int base = HashShot(shot) & (cache->capacity - 1) & ~(unsigned int)(TRAJECTORY_WAYS - 1);
+
+	//the key's set: reuse its entry if there is one, otherwise take an empty or the least recently used slot
+	TrajectoryEntry* slot = nullptr;
+	for (int w = 0; w < TRAJECTORY_WAYS; w++)
+	{
+		TrajectoryEntry* e = &cache->entries[base + w];
+		if (e->lastUsed != 0 && SameShot(&e->shot, shot))
+		{
+			if (e->tileCount >= 0 && TilesUnchanged(e))
+			{
+				e->lastUsed = cache->clock;
+				cache->hits++;
+				return e->result;
+			}
+
+			cache->stale++;
+			slot = e;
+			break;
+		}
+		if (slot == nullptr || e->lastUsed < slot->lastUsed) slot = e;
+	}
+
+	cache->misses++;
+	slot->shot = *shot;
+	slot->result = SimulateTrajectory(cache->terrain, shot, slot);
+	slot->lastUsed = cache->clock;
+	return slot->result;
+}
+
+float GetTrajectoryHitRate(const TrajectoryCache* cache)
+{
+	long total = cache->hits + cache->misses;
+	return total > 0 ? (float)cache->hits / total : 0.0f;
+}
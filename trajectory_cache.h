@@ -0,0 +1,67 @@
+/*******************************************************************************************
+*
+*   Trajectory Cache - first-contact results of simulated shots, keyed by launch state
+*
+*   Shots are simulated in fixed point, so a launch state (position, velocity, gravity)
+*   always produces the same arc and makes an exact key. Each entry keeps the version of
+*   every terrain tile the arc crossed; a lookup is a hit while all of those are unchanged,
+*   so a carve only invalidates the shots whose path runs through the tiles it touched.
+*
+********************************************************************************************/
+
+#ifndef TRAJECTORY_CACHE_H
+#define TRAJECTORY_CACHE_H
+
+#include "fixed_physics.h"
+#include "occupancy_pyramid.h"
+
+#define TRAJECTORY_MAX_TILES             48     // Longer paths are simulated but not cached
+#define TRAJECTORY_MAX_STEPS           2000
+#define TRAJECTORY_WAYS                   4     // Slots probed per key
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct TrajectoryShot {
+	fixed x, y;                     // Launch position of the probe point
+	fixed vx, vy;
+	fixed gravity;                  // Added to vy every step
+} TrajectoryShot;
+
+typedef struct TrajectoryResult {
+	bool hit;                       // False when the shot left the map or ran out of steps
+	int x, y;                       // First solid pixel
+	int steps;
+} TrajectoryResult;
+
+typedef struct TrajectoryEntry {
+	TrajectoryShot shot;
+	TrajectoryResult result;
+	unsigned int lastUsed;          // 0 = empty
+
+	int tileCount;
+	int tiles[TRAJECTORY_MAX_TILES];                // ty * tilesX + tx
+	unsigned int versions[TRAJECTORY_MAX_TILES];
+} TrajectoryEntry;
+
+typedef struct TrajectoryCache {
+	OccupancyPyramid* terrain;      // Not owned, tile versions come from the terrain events
+	TrajectoryEntry* entries;
+	int capacity;                   // Power of two
+	unsigned int clock;
+
+	long hits;
+	long misses;                    // Includes stale entries
+	long stale;                     // Found, but a crossed tile changed since
+} TrajectoryCache;
+
+//----------------------------------------------------------------------------------
+// Trajectory Cache Functions Declaration
+//----------------------------------------------------------------------------------
+void InitTrajectoryCache(TrajectoryCache* cache, OccupancyPyramid* terrain, int capacity);
+void UnloadTrajectoryCache(TrajectoryCache* cache);
+
+TrajectoryResult QueryTrajectory(TrajectoryCache* cache, const TrajectoryShot* shot);      // Cached or simulated
+float GetTrajectoryHitRate(const TrajectoryCache* cache);
+
+#endif // TRAJECTORY_CACHE_H